@@ -3,6 +3,7 @@
 #include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
 #include <llvm/ADT/ArrayRef.h>
 #include <llvm-c/Core.h>
 
@@ -16,4 +17,18 @@ extern "C" LLVMValueRef LLVMBuildUnsignedIntCast(LLVMBuilderRef B, LLVMValueRef
 extern "C" LLVMValueRef LLVMIntrinsicGetDeclaration(LLVMModuleRef M, unsigned int ID, LLVMTypeRef *ParamTypes, unsigned ParamCount)
 {
 	return wrap(Intrinsic::getDeclaration(unwrap(M), (Intrinsic::ID)ID, makeArrayRef(unwrap(ParamTypes), ParamCount)));
-}
\ No newline at end of file
+}
+extern "C" LLVMValueRef LLVMBuildAtomicCompareExchange(LLVMBuilderRef B, LLVMValueRef Ptr, LLVMValueRef Cmp, LLVMValueRef New, LLVMAtomicOrdering successOrdering, LLVMAtomicOrdering failureOrdering, LLVMBool singleThread)
+{
+	// Result is { original value, success flag }
+	return wrap(unwrap(B)->CreateAtomicCmpXchg(unwrap(Ptr), unwrap(Cmp), unwrap(New), (AtomicOrdering)successOrdering, (AtomicOrdering)failureOrdering, singleThread ? SingleThread : CrossThread));
+}
+
+extern "C" void LLVMSetAtomicOrdering(LLVMValueRef MemoryAccessInst, LLVMAtomicOrdering ordering)
+{
+	auto instruction = unwrap<Value>(MemoryAccessInst);
+	if (auto load = dyn_cast<LoadInst>(instruction))
+		load->setOrdering((AtomicOrdering)ordering);
+	else if (auto store = dyn_cast<StoreInst>(instruction))
+		store->setOrdering((AtomicOrdering)ordering);
+}
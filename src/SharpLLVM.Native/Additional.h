@@ -7,4 +7,8 @@ extern "C" LLVMValueRef LLVMBuildUnsignedIntCast(LLVMBuilderRef, LLVMValueRef Va
 
 extern "C" LLVMValueRef LLVMIntrinsicGetDeclaration(LLVMModuleRef M, unsigned int ID, LLVMTypeRef *ParamTypes, unsigned ParamCount);
 
+extern "C" LLVMValueRef LLVMBuildAtomicCompareExchange(LLVMBuilderRef B, LLVMValueRef Ptr, LLVMValueRef Cmp, LLVMValueRef New, LLVMAtomicOrdering successOrdering, LLVMAtomicOrdering failureOrdering, LLVMBool singleThread);
+
+extern "C" void LLVMSetAtomicOrdering(LLVMValueRef MemoryAccessInst, LLVMAtomicOrdering ordering);
+
 #endif
@@ -8502,6 +8502,40 @@ SWIGEXPORT void * SWIGSTDCALL CSharp_IntrinsicGetDeclaration(void * jarg1, unsig
 }
 
 
+SWIGEXPORT void * SWIGSTDCALL CSharp_BuildAtomicCompareExchange(void * jarg1, void * jarg2, void * jarg3, void * jarg4, int jarg5, int jarg6, unsigned int jarg7) {
+  void * jresult ;
+  LLVMBuilderRef arg1 ;
+  LLVMValueRef arg2 ;
+  LLVMValueRef arg3 ;
+  LLVMValueRef arg4 ;
+  LLVMAtomicOrdering arg5 ;
+  LLVMAtomicOrdering arg6 ;
+  LLVMBool arg7 ;
+  LLVMValueRef result;
+  
+  arg1 = (LLVMBuilderRef)jarg1; 
+  arg2 = (LLVMValueRef)jarg2; 
+  arg3 = (LLVMValueRef)jarg3; 
+  arg4 = (LLVMValueRef)jarg4; 
+  arg5 = (LLVMAtomicOrdering)jarg5; 
+  arg6 = (LLVMAtomicOrdering)jarg6; 
+  arg7 = jarg7 ? true : false; 
+  result = LLVMBuildAtomicCompareExchange(arg1,arg2,arg3,arg4,arg5,arg6,arg7);
+  jresult = result; 
+  return jresult;
+}
+
+
+SWIGEXPORT void SWIGSTDCALL CSharp_SetAtomicOrdering(void * jarg1, int jarg2) {
+  LLVMValueRef arg1 ;
+  LLVMAtomicOrdering arg2 ;
+  
+  arg1 = (LLVMValueRef)jarg1; 
+  arg2 = (LLVMAtomicOrdering)jarg2; 
+  LLVMSetAtomicOrdering(arg1,arg2);
+}
+
+
 SWIGEXPORT void * SWIGSTDCALL CSharp_DIBuilderCreate(void * jarg1) {
   void * jresult ;
   LLVMModuleRef arg1 ;
@@ -3166,6 +3166,15 @@ public class LLVM {
     }
   }
 
+  public unsafe static ValueRef BuildAtomicCompareExchange(BuilderRef B, ValueRef Ptr, ValueRef Cmp, ValueRef New, AtomicOrdering successOrdering, AtomicOrdering failureOrdering, bool singleThread) {
+    ValueRef ret = new ValueRef(LLVMPINVOKE.BuildAtomicCompareExchange(B.Value, Ptr.Value, Cmp.Value, New.Value, (int)successOrdering, (int)failureOrdering, singleThread));
+    return ret;
+  }
+
+  public unsafe static void SetAtomicOrdering(ValueRef MemoryAccessInst, AtomicOrdering ordering) {
+    LLVMPINVOKE.SetAtomicOrdering(MemoryAccessInst.Value, (int)ordering);
+  }
+
   public unsafe static DIBuilderRef DIBuilderCreate(ModuleRef M) {
     DIBuilderRef ret = new DIBuilderRef(LLVMPINVOKE.DIBuilderCreate(M.Value));
     return ret;
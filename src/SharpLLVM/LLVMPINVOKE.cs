@@ -2130,6 +2130,12 @@ class LLVMPINVOKE {
   [global::System.Runtime.InteropServices.DllImport("SharpLLVM.Native.dll", EntryPoint="CSharp_IntrinsicGetDeclaration")]
   public static extern System.IntPtr IntrinsicGetDeclaration(System.IntPtr jarg1, uint jarg2, System.IntPtr arg3_data, uint jarg3);
 
+  [global::System.Runtime.InteropServices.DllImport("SharpLLVM.Native.dll", EntryPoint="CSharp_BuildAtomicCompareExchange")]
+  public static extern System.IntPtr BuildAtomicCompareExchange(System.IntPtr jarg1, System.IntPtr jarg2, System.IntPtr jarg3, System.IntPtr jarg4, int jarg5, int jarg6, bool jarg7);
+
+  [global::System.Runtime.InteropServices.DllImport("SharpLLVM.Native.dll", EntryPoint="CSharp_SetAtomicOrdering")]
+  public static extern void SetAtomicOrdering(System.IntPtr jarg1, int jarg2);
+
   [global::System.Runtime.InteropServices.DllImport("SharpLLVM.Native.dll", EntryPoint="CSharp_DIBuilderCreate")]
   public static extern System.IntPtr DIBuilderCreate(System.IntPtr jarg1);
 
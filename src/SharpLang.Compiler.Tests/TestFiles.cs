@@ -38,6 +38,22 @@ namespace SharpLang.CompilerServices.Tests
             Assert.That(output2, Is.EqualTo(output1));
         }
 
+        [Test]
+        public static void TestCorlibGuardPageSafepoints()
+        {
+            // Same as the tests-corlib one, but polling a guard page instead of a flag
+            var previousSafepointMode = Driver.SafepointMode;
+            Driver.SafepointMode = SafepointMode.GuardPage;
+            try
+            {
+                TestCorlib(Path.Combine(Utils.GetTestsDirectory("tests-corlib"), "SafepointLoops.cs"));
+            }
+            finally
+            {
+                Driver.SafepointMode = previousSafepointMode;
+            }
+        }
+
         [Test, TestCaseSource("TestPInvokeCases")]
         public static void TestPInvoke(string sourceFile)
         {
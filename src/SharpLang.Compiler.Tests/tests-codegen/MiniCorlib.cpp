@@ -51,6 +51,20 @@ extern "C" void System_NotSupportedException___ctor_System_String_(void* excepti
 {
 }
 
+// Needed by Internal.cpp (exceptions thrown by Monitor)
+EEType System_ArgumentNullException_rtti;
+EEType System_Threading_SynchronizationLockException_rtti;
+
+// System.ArgumentNullException..ctor()
+extern "C" void System_ArgumentNullException___ctor__(void* exception)
+{
+}
+
+// System.Threading.SynchronizationLockException..ctor()
+extern "C" void System_Threading_SynchronizationLockException___ctor__(void* exception)
+{
+}
+
 // System.IntPtr::op_Explicit(void*)
 extern "C" void* System_IntPtr__op_Explicit_System_Void_(void* p)
 {
@@ -204,6 +218,32 @@ extern "C" bool System_RuntimeTypeHandle__IsInterface_System_RuntimeType_(Runtim
 // Needed by AllocateObject
 EEType System_Threading_Thread_rtti;
 
+// Needed by ManagedThread.cpp (Thread start)
+EEType System_Threading_ParameterizedThreadStart_rtti;
+
+// Needed by Internal.cpp (exceptions thrown by Thread)
+EEType System_Threading_ThreadStateException_rtti;
+
+// System.Threading.ThreadStateException..ctor()
+extern "C" void System_Threading_ThreadStateException___ctor__(void* exception)
+{
+}
+
+extern "C" bool System_Threading__ThreadPoolWaitCallback__PerformWaitCallback__()
+{
+	// Needed by ThreadPool.cpp (worker threads)
+	assert(false);
+	return false;
+}
+
+// Needed by Finalizer.cpp (to find whether a type overrides Finalize)
+// Weak, since they are emitted by test assemblies using System.Object as a base type
+__attribute__((weak)) EEType System_Object_rtti;
+
+extern "C" __attribute__((weak)) void System_Object__Finalize__(Object* obj)
+{
+}
+
 EEType System_Byte___rtti;
 
 class Module;
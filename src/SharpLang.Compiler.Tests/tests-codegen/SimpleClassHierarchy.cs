@@ -0,0 +1,91 @@
+// Class hierarchy checks (isinst, castclass, catch) at various depths, between sibling branches and against deeper types
+public static class Program
+{
+    public class A { }
+    public class B : A { }
+    public class C : B { }
+    public class D : C { }
+    public class E : D { }
+    public class F : E { }
+    public class G : F { }
+    public class H : G { }
+
+    // Sibling branch with same depths
+    public class B2 : A { }
+    public class C2 : B2 { }
+
+    public class BaseException : System.Exception { }
+    public class MiddleException : BaseException { }
+    public class LeafException : MiddleException { }
+    public class OtherException : System.Exception { }
+
+    public static int Mask(object obj)
+    {
+        int mask = 0;
+        if (obj is A) mask |= 1;
+        if (obj is B) mask |= 2;
+        if (obj is C) mask |= 4;
+        if (obj is D) mask |= 8;
+        if (obj is E) mask |= 16;
+        if (obj is F) mask |= 32;
+        if (obj is G) mask |= 64;
+        if (obj is H) mask |= 128;
+        if (obj is B2) mask |= 256;
+        if (obj is C2) mask |= 512;
+        return mask;
+    }
+
+    public static void Throw(int kind)
+    {
+        if (kind == 0)
+            throw new LeafException();
+        if (kind == 1)
+            throw new MiddleException();
+        if (kind == 2)
+            throw new BaseException();
+        throw new OtherException();
+    }
+
+    public static void Catch(int kind)
+    {
+        try
+        {
+            try
+            {
+                Throw(kind);
+            }
+            catch (MiddleException)
+            {
+                System.Console.WriteLine("MiddleException caught");
+            }
+            catch (BaseException)
+            {
+                System.Console.WriteLine("BaseException caught");
+            }
+        }
+        catch (System.Exception)
+        {
+            System.Console.WriteLine("Exception caught");
+        }
+    }
+
+    public static void Main()
+    {
+        System.Console.WriteLine(Mask(new A()));
+        System.Console.WriteLine(Mask(new D()));
+        System.Console.WriteLine(Mask(new H()));
+        System.Console.WriteLine(Mask(new C2()));
+        System.Console.WriteLine(Mask(new object()));
+
+        object h = new H();
+        var e = (E)h;
+        System.Console.WriteLine(e != null);
+        System.Console.WriteLine(h as B2 == null);
+        System.Console.WriteLine(new C() as H == null);
+
+        Catch(0);
+        Catch(1);
+        Catch(2);
+        Catch(3);
+    }
+}
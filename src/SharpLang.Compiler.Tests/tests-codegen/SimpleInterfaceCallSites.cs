@@ -0,0 +1,109 @@
+// Interface call sites seeing one, a few, and more types than their inline cache can hold (currently 4)
+public static class Program
+{
+    public interface IShape
+    {
+        int Area();
+        int Sides();
+    }
+
+    public class Square : IShape
+    {
+        public int Size;
+        public int Area() { return Size * Size; }
+        public int Sides() { return 4; }
+    }
+
+    public class Rectangle : IShape
+    {
+        public int Width;
+        public int Height;
+        public int Area() { return Width * Height; }
+        public virtual int Sides() { return 4; }
+    }
+
+    public class Triangle : IShape
+    {
+        public int Base;
+        public int Height;
+        public int Area() { return Base * Height / 2; }
+        public int Sides() { return 3; }
+    }
+
+    public class Line : IShape
+    {
+        public int Area() { return 0; }
+        public int Sides() { return 1; }
+    }
+
+    public class Dot : IShape
+    {
+        public int Area() { return 0; }
+        public int Sides() { return 0; }
+    }
+
+    public class Hexagon : IShape
+    {
+        public int Area() { return 60; }
+        public int Sides() { return 6; }
+    }
+
+    // Overrides base implementation: cached targets must be per type
+    public class Parallelogram : Rectangle
+    {
+        public override int Sides() { return 40; }
+    }
+
+    public struct Circle : IShape
+    {
+        public int Radius;
+        public int Area() { return 3 * Radius * Radius; }
+        public int Sides() { return 0; }
+    }
+
+    // Single call site for all shapes
+    public static int TotalArea(IShape[] shapes, int count)
+    {
+        int total = 0;
+        for (int i = 0; i < count; ++i)
+            total += shapes[i % shapes.Length].Area();
+        return total;
+    }
+
+    public static int TotalSides(IShape[] shapes, int count)
+    {
+        int total = 0;
+        for (int i = 0; i < count; ++i)
+            total += shapes[i % shapes.Length].Sides();
+        return total;
+    }
+
+    public static void Main()
+    {
+        var monomorphic = new IShape[] { new Square { Size = 3 } };
+        var polymorphic = new IShape[] { new Square { Size = 2 }, new Triangle { Base = 4, Height = 3 } };
+        var megamorphic = new IShape[]
+        {
+            new Square { Size = 5 },
+            new Rectangle { Width = 2, Height = 7 },
+            new Triangle { Base = 6, Height = 2 },
+            new Line(),
+            new Dot(),
+            new Hexagon(),
+            new Parallelogram { Width = 3, Height = 3 },
+            new Circle { Radius = 2 },
+        };
+
+        System.Console.WriteLine(TotalArea(monomorphic, 1000));
+        System.Console.WriteLine(TotalArea(polymorphic, 1000));
+        System.Console.WriteLine(TotalArea(megamorphic, 1000));
+
+        System.Console.WriteLine(TotalSides(monomorphic, 1000));
+        System.Console.WriteLine(TotalSides(polymorphic, 1000));
+        System.Console.WriteLine(TotalSides(megamorphic, 1000));
+
+        // Same call sites again, with caches already filled
+        System.Console.WriteLine(TotalArea(polymorphic, 10));
+        System.Console.WriteLine(TotalSides(megamorphic, 16));
+    }
+}
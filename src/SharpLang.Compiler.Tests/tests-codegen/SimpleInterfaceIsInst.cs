@@ -0,0 +1,88 @@
+// Interface casts on types implementing many interfaces (colliding in the interface hash table), or none of them
+public static class Program
+{
+    public interface I01 { }
+    public interface I02 { }
+    public interface I03 { }
+    public interface I04 { }
+    public interface I05 { }
+    public interface I06 { }
+    public interface I07 { }
+    public interface I08 { }
+    public interface I09 { }
+    public interface I10 { }
+    public interface I11 { }
+    public interface I12 { }
+    public interface I13 { }
+    public interface I14 { }
+    public interface I15 { }
+    public interface I16 { }
+    public interface I17 { }
+    public interface I18 { }
+    public interface I19 { }
+    public interface I20 { }
+    public interface I21 { }
+    public interface I22 { }
+    public interface I23 { }
+    public interface I24 { }
+
+    public interface IDerived : I01, I02 { }
+    public interface IUnused { }
+
+    public class Many : I01, I03, I05, I07, I09, I11, I13, I15, I17, I19, I21, I23 { }
+
+    public class MoreMany : Many, I02, I04, I06, I08, I10, I12, I14, I16, I18, I20, I22, I24 { }
+
+    public class Derived : IDerived { }
+
+    public class None { }
+
+    public static int Mask(object obj)
+    {
+        int mask = 0;
+        if (obj is I01) mask |= 1 << 0;
+        if (obj is I02) mask |= 1 << 1;
+        if (obj is I03) mask |= 1 << 2;
+        if (obj is I04) mask |= 1 << 3;
+        if (obj is I05) mask |= 1 << 4;
+        if (obj is I06) mask |= 1 << 5;
+        if (obj is I07) mask |= 1 << 6;
+        if (obj is I08) mask |= 1 << 7;
+        if (obj is I09) mask |= 1 << 8;
+        if (obj is I10) mask |= 1 << 9;
+        if (obj is I11) mask |= 1 << 10;
+        if (obj is I12) mask |= 1 << 11;
+        if (obj is I13) mask |= 1 << 12;
+        if (obj is I14) mask |= 1 << 13;
+        if (obj is I15) mask |= 1 << 14;
+        if (obj is I16) mask |= 1 << 15;
+        if (obj is I17) mask |= 1 << 16;
+        if (obj is I18) mask |= 1 << 17;
+        if (obj is I19) mask |= 1 << 18;
+        if (obj is I20) mask |= 1 << 19;
+        if (obj is I21) mask |= 1 << 20;
+        if (obj is I22) mask |= 1 << 21;
+        if (obj is I23) mask |= 1 << 22;
+        if (obj is I24) mask |= 1 << 23;
+        return mask;
+    }
+
+    public static void Main()
+    {
+        System.Console.WriteLine(Mask(new Many()));
+        System.Console.WriteLine(Mask(new MoreMany()));
+        System.Console.WriteLine(Mask(new Derived()));
+        System.Console.WriteLine(Mask(new None()));
+
+        object many = new Many();
+        System.Console.WriteLine(many is IUnused);
+        System.Console.WriteLine(many is IDerived);
+        System.Console.WriteLine(new Derived() is IDerived);
+
+        // Successful and failing casts
+        var i03 = (I03)many;
+        System.Console.WriteLine(i03 != null);
+        System.Console.WriteLine(many as I04 == null);
+        System.Console.WriteLine(new MoreMany() as I04 != null);
+    }
+}
@@ -0,0 +1,77 @@
+using System;
+using System.Runtime.CompilerServices;
+using System.Threading;
+
+public static class Program
+{
+    static int finalizedCount;
+    static int suppressedFinalizedCount;
+    static int keptFinalizedCount;
+
+    class Finalizable
+    {
+        ~Finalizable()
+        {
+            Interlocked.Increment(ref finalizedCount);
+        }
+    }
+
+    class Suppressed
+    {
+        public Suppressed()
+        {
+            GC.SuppressFinalize(this);
+        }
+
+        ~Suppressed()
+        {
+            Interlocked.Increment(ref suppressedFinalizedCount);
+        }
+    }
+
+    class Kept
+    {
+        ~Kept()
+        {
+            Interlocked.Increment(ref keptFinalizedCount);
+        }
+    }
+
+    class Derived : Finalizable
+    {
+        public int Value;
+    }
+
+    [MethodImpl(MethodImplOptions.NoInlining)]
+    static void Allocate(int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            new Finalizable();
+            new Derived { Value = i };
+            new Suppressed();
+        }
+    }
+
+    public static void Main()
+    {
+        Allocate(1000);
+
+        GC.Collect();
+        GC.WaitForPendingFinalizers();
+        GC.Collect();
+        GC.WaitForPendingFinalizers();
+
+        // Conservative stack scanning might keep a few objects alive
+        Console.WriteLine(finalizedCount >= 1900);
+        Console.WriteLine(finalizedCount <= 2000);
+        Console.WriteLine(suppressedFinalizedCount);
+
+        // Object kept alive is not finalized
+        var kept = new Kept();
+        GC.Collect();
+        GC.WaitForPendingFinalizers();
+        Console.WriteLine(keptFinalizedCount);
+        GC.KeepAlive(kept);
+    }
+}
@@ -0,0 +1,84 @@
+using System;
+using System.Runtime.CompilerServices;
+
+public static class Program
+{
+    class Node
+    {
+        public Node Left;
+        public Node Right;
+        public int Value;
+        public string Name;
+    }
+
+    struct Pair
+    {
+        public string First;
+        public int Number;
+        public string Second;
+    }
+
+    static Node BuildTree(int depth, int value)
+    {
+        if (depth == 0)
+            return null;
+
+        return new Node
+        {
+            Left = BuildTree(depth - 1, value * 2),
+            Right = BuildTree(depth - 1, value * 2 + 1),
+            Value = value,
+            Name = value.ToString(),
+        };
+    }
+
+    static bool CheckTree(Node node, int depth, int value)
+    {
+        if (depth == 0)
+            return node == null;
+
+        return node.Value == value
+            && node.Name == value.ToString()
+            && CheckTree(node.Left, depth - 1, value * 2)
+            && CheckTree(node.Right, depth - 1, value * 2 + 1);
+    }
+
+    [MethodImpl(MethodImplOptions.NoInlining)]
+    static void AllocateGarbage(int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            var garbage = BuildTree(4, i);
+        }
+    }
+
+    public static void Main()
+    {
+        var tree = BuildTree(12, 1);
+
+        // Structs embedding references, in an array (only reachable through array elements)
+        var pairs = new Pair[1000];
+        for (int i = 0; i < pairs.Length; ++i)
+            pairs[i] = new Pair { First = "a" + i.ToString(), Number = i, Second = "b" + i.ToString() };
+
+        // Garbage gets swept, and its space reused by later allocations
+        for (int i = 0; i < 10; ++i)
+        {
+            AllocateGarbage(2000);
+            GC.Collect();
+        }
+
+        Console.WriteLine(CheckTree(tree, 12, 1));
+
+        bool pairsIntact = true;
+        for (int i = 0; i < pairs.Length; ++i)
+            pairsIntact &= pairs[i].First == "a" + i.ToString() && pairs[i].Number == i && pairs[i].Second == "b" + i.ToString();
+        Console.WriteLine(pairsIntact);
+
+        // Replace half of the tree, so that it gets collected while the other half is kept
+        tree.Left = BuildTree(11, 2);
+        GC.Collect();
+        AllocateGarbage(2000);
+        Console.WriteLine(CheckTree(tree, 12, 1));
+    }
+}
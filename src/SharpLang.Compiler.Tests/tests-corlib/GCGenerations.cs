@@ -0,0 +1,56 @@
+using System;
+
+public static class Program
+{
+    class Holder
+    {
+        public object Value;
+        public Holder Next;
+    }
+
+    public static void Main()
+    {
+        // Make holders old
+        var holders = new Holder[500];
+        for (int i = 0; i < holders.Length; ++i)
+            holders[i] = new Holder();
+        GC.Collect();
+        GC.Collect();
+
+        // Old objects and arrays now point to young objects only: they must be found through dirty cards
+        var strings = new object[500];
+        GC.Collect();
+        for (int i = 0; i < holders.Length; ++i)
+        {
+            holders[i].Value = "young" + i.ToString();
+            holders[i].Next = new Holder { Value = i };
+            strings[i] = i.ToString();
+        }
+
+        for (int i = 0; i < 5; ++i)
+        {
+            // Allocate garbage between young collections
+            for (int j = 0; j < 10000; ++j)
+            {
+                var garbage = new Holder();
+            }
+            GC.Collect(0);
+        }
+
+        bool intact = true;
+        for (int i = 0; i < holders.Length; ++i)
+        {
+            intact &= (string)holders[i].Value == "young" + i.ToString();
+            intact &= (int)holders[i].Next.Value == i;
+            intact &= (string)strings[i] == i.ToString();
+        }
+        Console.WriteLine(intact);
+
+        // Promoted objects survive a full collection too
+        GC.Collect();
+        intact = true;
+        for (int i = 0; i < holders.Length; ++i)
+            intact &= (string)holders[i].Value == "young" + i.ToString() && (int)holders[i].Next.Value == i;
+        Console.WriteLine(intact);
+    }
+}
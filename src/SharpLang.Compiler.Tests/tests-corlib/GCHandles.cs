@@ -0,0 +1,67 @@
+using System;
+using System.Runtime.InteropServices;
+
+public static class Program
+{
+    class Data
+    {
+        public int Value;
+    }
+
+    public static void Main()
+    {
+        // Strong handles keep their target alive without any other reference
+        var strongHandles = new GCHandle[1000];
+        for (int i = 0; i < strongHandles.Length; ++i)
+            strongHandles[i] = GCHandle.Alloc(new Data { Value = i });
+
+        // Weak handles return their target as long as it is otherwise referenced
+        var kept = new Data { Value = 42 };
+        var weakHandle = GCHandle.Alloc(kept, GCHandleType.Weak);
+        var weakReference = new WeakReference(kept);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 10000; ++j)
+            {
+                var garbage = new Data();
+            }
+            GC.Collect();
+        }
+
+        bool intact = true;
+        for (int i = 0; i < strongHandles.Length; ++i)
+            intact &= ((Data)strongHandles[i].Target).Value == i;
+        Console.WriteLine(intact);
+
+        Console.WriteLine(weakHandle.Target == kept);
+        Console.WriteLine(weakReference.IsAlive);
+        Console.WriteLine(((Data)weakReference.Target).Value);
+
+        // Pinned handles
+        var array = new byte[16];
+        var pinnedHandle = GCHandle.Alloc(array, GCHandleType.Pinned);
+        Console.WriteLine(pinnedHandle.AddrOfPinnedObject() != IntPtr.Zero);
+        pinnedHandle.Free();
+
+        // Freed slots get reused
+        for (int i = 0; i < strongHandles.Length; ++i)
+            strongHandles[i].Free();
+        Console.WriteLine(strongHandles[0].IsAllocated);
+
+        for (int i = 0; i < strongHandles.Length; ++i)
+            strongHandles[i] = GCHandle.Alloc(i.ToString());
+        GC.Collect();
+
+        intact = true;
+        for (int i = 0; i < strongHandles.Length; ++i)
+        {
+            intact &= (string)strongHandles[i].Target == i.ToString();
+            strongHandles[i].Free();
+        }
+        Console.WriteLine(intact);
+
+        weakHandle.Free();
+        GC.KeepAlive(kept);
+    }
+}
@@ -0,0 +1,70 @@
+using System;
+using System.Threading;
+
+public static class Program
+{
+    class Node
+    {
+        public int Value;
+        public byte[] Data;
+        public Node Next;
+    }
+
+    static bool[] results = new bool[4];
+
+    // Keeps a window of live objects while allocating many short-lived ones,
+    // so that collections happen while allocation contexts are partly used
+    static bool Stress(int seed)
+    {
+        var live = new Node[64];
+        for (int i = 0; i < 20000; ++i)
+        {
+            var node = new Node { Value = seed + i, Data = new byte[(i % 37) + 1], Next = live[(i + 1) % live.Length] };
+            for (int j = 0; j < node.Data.Length; ++j)
+                node.Data[j] = (byte)(node.Value + j);
+
+            // Short-lived garbage
+            var garbage = new object[i % 5];
+
+            live[i % live.Length] = node;
+
+            if (i % 1000 == 0)
+                GC.Collect(0);
+            if (i % 5000 == 0)
+                GC.Collect();
+        }
+
+        GC.Collect();
+
+        // Check that nothing got overwritten (i.e. handed out twice)
+        foreach (var node in live)
+        {
+            for (int j = 0; j < node.Data.Length; ++j)
+            {
+                if (node.Data[j] != (byte)(node.Value + j))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    public static void Main()
+    {
+        Console.WriteLine(Stress(0));
+
+        var threads = new Thread[results.Length];
+        for (int i = 0; i < threads.Length; ++i)
+        {
+            var index = i;
+            threads[i] = new Thread(() => results[index] = Stress(index * 100000));
+            threads[i].Start();
+        }
+
+        for (int i = 0; i < threads.Length; ++i)
+        {
+            threads[i].Join();
+            Console.WriteLine(results[i]);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+using System;
+using System.Threading;
+
+public static class Program
+{
+    const int Iterations = 100000;
+
+    static int intCounter;
+    static long longCounter;
+    static int casCounter;
+    static long added;
+    static object lastExchanged;
+    static int flag;
+    static int ready;
+
+    static void Work(int thread)
+    {
+        for (int i = 0; i < Iterations; ++i)
+        {
+            Interlocked.Increment(ref intCounter);
+            Interlocked.Decrement(ref intCounter);
+            Interlocked.Increment(ref intCounter);
+            Interlocked.Increment(ref longCounter);
+            Interlocked.Add(ref added, thread + 1);
+
+            // Increment through a compare-exchange loop
+            int current;
+            do
+            {
+                current = Volatile.Read(ref casCounter);
+            } while (Interlocked.CompareExchange(ref casCounter, current + 1, current) != current);
+
+            Interlocked.Exchange(ref lastExchanged, (object)thread);
+        }
+    }
+
+    public static void Main()
+    {
+        var threads = new Thread[4];
+        for (int i = 0; i < threads.Length; ++i)
+        {
+            var thread = i;
+            threads[i] = new Thread(() => Work(thread));
+            threads[i].Start();
+        }
+
+        foreach (var thread in threads)
+            thread.Join();
+
+        Console.WriteLine(intCounter);
+        Console.WriteLine(longCounter);
+        Console.WriteLine(casCounter);
+        Console.WriteLine(added);
+        Console.WriteLine((int)lastExchanged < threads.Length);
+
+        // Return values
+        Console.WriteLine(Interlocked.Exchange(ref flag, 5));
+        Console.WriteLine(Interlocked.CompareExchange(ref flag, 7, 4));
+        Console.WriteLine(Interlocked.CompareExchange(ref flag, 7, 5));
+        Console.WriteLine(Interlocked.Increment(ref flag));
+        Console.WriteLine(Interlocked.Add(ref flag, 10));
+
+        // Publication through Volatile
+        var data = new int[1];
+        var reader = new Thread(() =>
+        {
+            while (Volatile.Read(ref ready) == 0)
+            {
+            }
+            Console.WriteLine(data[0]);
+        });
+        reader.Start();
+        data[0] = 123;
+        Volatile.Write(ref ready, 1);
+        reader.Join();
+
+        var value = 1.5;
+        Console.WriteLine(Interlocked.Exchange(ref value, 2.5));
+        Console.WriteLine(value);
+    }
+}
@@ -0,0 +1,75 @@
+using System;
+
+public static class Program
+{
+    static bool IsZero(byte[] array)
+    {
+        for (int i = 0; i < array.Length; ++i)
+        {
+            if (array[i] != 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    static void Fill(byte[] array, int seed)
+    {
+        for (int i = 0; i < array.Length; ++i)
+            array[i] = (byte)(seed + i);
+    }
+
+    static bool Check(byte[] array, int seed)
+    {
+        for (int i = 0; i < array.Length; ++i)
+        {
+            if (array[i] != (byte)(seed + i))
+                return false;
+        }
+
+        return true;
+    }
+
+    public static void Main()
+    {
+        // Kept alive across collections
+        var kept = new byte[200000];
+        Fill(kept, 7);
+
+        // Dead large objects get released, and their mappings cached and reused:
+        // new arrays must still come back zeroed
+        bool allZero = true;
+        for (int i = 0; i < 50; ++i)
+        {
+            var array = new byte[100000 + (i % 4) * 4096];
+            allZero &= IsZero(array);
+            Fill(array, i);
+
+            if (i % 10 == 0)
+                GC.Collect();
+        }
+
+        GC.Collect();
+        Console.WriteLine(allZero);
+        Console.WriteLine(Check(kept, 7));
+
+        // Large object referencing small objects: they must survive collections
+        var references = new object[20000];
+        for (int i = 0; i < references.Length; ++i)
+            references[i] = i.ToString();
+
+        GC.Collect(0);
+        GC.Collect();
+
+        bool referencesIntact = true;
+        for (int i = 0; i < references.Length; ++i)
+            referencesIntact &= (string)references[i] == i.ToString();
+        Console.WriteLine(referencesIntact);
+
+        // Large strings
+        var largeString = new string('a', 50000);
+        GC.Collect();
+        Console.WriteLine(largeString.Length);
+        Console.WriteLine(largeString[49999]);
+    }
+}
@@ -0,0 +1,31 @@
+using System;
+
+public static class Program
+{
+    const long PressureStep = 16 * 1024 * 1024;
+    const int MaxSteps = 64;
+
+    public static void Main()
+    {
+        // Unmanaged memory reported to the GC should eventually trigger a collection, even without managed allocations
+        var collectionsBefore = GC.CollectionCount(0);
+        int steps = 0;
+        while (steps < MaxSteps && GC.CollectionCount(0) == collectionsBefore)
+        {
+            GC.AddMemoryPressure(PressureStep);
+            steps++;
+        }
+        Console.WriteLine(GC.CollectionCount(0) > collectionsBefore);
+
+        for (int i = 0; i < steps; ++i)
+            GC.RemoveMemoryPressure(PressureStep);
+
+        // Once removed, pressure doesn't keep triggering collections
+        GC.Collect();
+        collectionsBefore = GC.CollectionCount(0);
+        var small = new object[16];
+        for (int i = 0; i < small.Length; ++i)
+            small[i] = new object();
+        Console.WriteLine(GC.CollectionCount(0) == collectionsBefore);
+    }
+}
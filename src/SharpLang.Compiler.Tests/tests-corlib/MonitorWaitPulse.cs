@@ -0,0 +1,126 @@
+using System;
+using System.Collections.Generic;
+using System.Threading;
+
+public static class Program
+{
+    const int ItemCount = 10000;
+    const int QueueCapacity = 16;
+
+    static readonly object queueLock = new object();
+    static readonly Queue<int> queue = new Queue<int>();
+    static bool done;
+
+    static readonly object counterLock = new object();
+    static int counter;
+
+    static void Produce()
+    {
+        for (int i = 1; i <= ItemCount; ++i)
+        {
+            lock (queueLock)
+            {
+                while (queue.Count >= QueueCapacity)
+                    Monitor.Wait(queueLock);
+
+                queue.Enqueue(i);
+                Monitor.PulseAll(queueLock);
+            }
+        }
+
+        lock (queueLock)
+        {
+            done = true;
+            Monitor.PulseAll(queueLock);
+        }
+    }
+
+    static long Consume()
+    {
+        long sum = 0;
+        while (true)
+        {
+            int item;
+            lock (queueLock)
+            {
+                while (queue.Count == 0 && !done)
+                    Monitor.Wait(queueLock);
+
+                if (queue.Count == 0)
+                    return sum;
+
+                item = queue.Dequeue();
+                Monitor.PulseAll(queueLock);
+            }
+
+            sum += item;
+        }
+    }
+
+    static void Increment()
+    {
+        for (int i = 0; i < 100000; ++i)
+        {
+            // Recursive locking
+            lock (counterLock)
+            {
+                lock (counterLock)
+                {
+                    counter++;
+                }
+            }
+        }
+    }
+
+    public static void Main()
+    {
+        // Producer/consumers with a bounded queue
+        var sums = new long[3];
+        var consumers = new Thread[sums.Length];
+        for (int i = 0; i < consumers.Length; ++i)
+        {
+            var index = i;
+            consumers[i] = new Thread(() => sums[index] = Consume());
+            consumers[i].Start();
+        }
+
+        var producer = new Thread(Produce);
+        producer.Start();
+        producer.Join();
+
+        long total = 0;
+        for (int i = 0; i < consumers.Length; ++i)
+        {
+            consumers[i].Join();
+            total += sums[i];
+        }
+        Console.WriteLine(total);
+
+        // Contention (thin locks getting inflated)
+        var threads = new Thread[4];
+        for (int i = 0; i < threads.Length; ++i)
+        {
+            threads[i] = new Thread(Increment);
+            threads[i].Start();
+        }
+        foreach (var thread in threads)
+            thread.Join();
+        Console.WriteLine(counter);
+
+        // Wait with timeout and nobody pulsing
+        lock (counterLock)
+        {
+            Console.WriteLine(Monitor.Wait(counterLock, 10));
+        }
+
+        // Lock on an object whose hash code was already taken
+        var hashed = new object();
+        var hashCode = hashed.GetHashCode();
+        lock (hashed)
+        {
+            Console.WriteLine(hashed.GetHashCode() == hashCode);
+            Console.WriteLine(Monitor.IsEntered(hashed));
+        }
+        Console.WriteLine(Monitor.IsEntered(hashed));
+    }
+}
@@ -0,0 +1,90 @@
+using System;
+using System.Runtime.CompilerServices;
+using System.Threading;
+
+public static class Program
+{
+    const int ObjectCount = 10000;
+    const int BucketCount = 64;
+
+    class HashedObject
+    {
+        public int Value;
+
+        public override int GetHashCode()
+        {
+            return 42;
+        }
+    }
+
+    public static void Main()
+    {
+        var objects = new HashedObject[ObjectCount];
+        var hashCodes = new int[ObjectCount];
+        for (int i = 0; i < ObjectCount; ++i)
+        {
+            objects[i] = new HashedObject { Value = i };
+            hashCodes[i] = RuntimeHelpers.GetHashCode(objects[i]);
+        }
+
+        // Stable across collections (objects might move or get promoted)
+        for (int i = 0; i < 3; ++i)
+            GC.Collect();
+
+        bool stable = true;
+        for (int i = 0; i < ObjectCount; ++i)
+            stable &= RuntimeHelpers.GetHashCode(objects[i]) == hashCodes[i];
+        Console.WriteLine("Stable after GC: " + stable);
+
+        // Stable when header gets a lock (thin lock, then inflated by Monitor.Wait)
+        bool stableWithLock = true;
+        for (int i = 0; i < 100; ++i)
+        {
+            var obj = objects[i];
+            lock (obj)
+            {
+                stableWithLock &= RuntimeHelpers.GetHashCode(obj) == hashCodes[i];
+                Monitor.Wait(obj, 0);
+                stableWithLock &= RuntimeHelpers.GetHashCode(obj) == hashCodes[i];
+            }
+            stableWithLock &= RuntimeHelpers.GetHashCode(obj) == hashCodes[i];
+        }
+        Console.WriteLine("Stable with lock: " + stableWithLock);
+
+        // Hash code assigned while object is locked stays the same afterward
+        var lockedFirst = new object();
+        int lockedHashCode;
+        lock (lockedFirst)
+        {
+            lockedHashCode = RuntimeHelpers.GetHashCode(lockedFirst);
+        }
+        GC.Collect();
+        Console.WriteLine("Stable when assigned under lock: " + (RuntimeHelpers.GetHashCode(lockedFirst) == lockedHashCode));
+
+        // Reasonably distributed (overrides are ignored): few duplicates, and low bits spread over buckets
+        var sortedHashCodes = (int[])hashCodes.Clone();
+        Array.Sort(sortedHashCodes);
+        int duplicates = 0;
+        for (int i = 1; i < ObjectCount; ++i)
+        {
+            if (sortedHashCodes[i] == sortedHashCodes[i - 1])
+                duplicates++;
+        }
+        Console.WriteLine("Mostly distinct: " + (duplicates < ObjectCount / 100));
+
+        var buckets = new int[BucketCount];
+        foreach (var hashCode in hashCodes)
+            buckets[hashCode & (BucketCount - 1)]++;
+
+        int minBucket = int.MaxValue, maxBucket = 0;
+        foreach (var bucket in buckets)
+        {
+            minBucket = Math.Min(minBucket, bucket);
+            maxBucket = Math.Max(maxBucket, bucket);
+        }
+        var expectedBucket = ObjectCount / BucketCount;
+        Console.WriteLine("Buckets balanced: " + (minBucket > expectedBucket / 2 && maxBucket < expectedBucket * 2));
+
+        GC.KeepAlive(objects);
+    }
+}
@@ -0,0 +1,76 @@
+using System;
+using System.Threading;
+
+public static class Program
+{
+    const int CollectionCount = 20;
+
+    static int started;
+    static bool collectionsDone;
+    static uint[] checksums = new uint[2];
+    static bool[] spunDuringCollections = new bool[2];
+
+    // Tight loops without calls or allocations: they can only be suspended through their back-edge polls
+    static uint Spin(int index)
+    {
+        uint value = (uint)index;
+        long iterations = 0;
+
+        // Keeps running until every collection is over
+        while (!Volatile.Read(ref collectionsDone))
+        {
+            value = value * 1664525 + 1013904223;
+            ++iterations;
+        }
+        spunDuringCollections[index] = iterations > 0;
+
+        // Fixed amount of work, for a deterministic result
+        value = (uint)index;
+        for (int i = 0; i < 1000000; ++i)
+            value = value * 1664525 + 1013904223;
+        return value;
+    }
+
+    public static void Main()
+    {
+        var threads = new Thread[checksums.Length];
+        for (int i = 0; i < threads.Length; ++i)
+        {
+            var index = i;
+            threads[i] = new Thread(() =>
+            {
+                Interlocked.Increment(ref started);
+                checksums[index] = Spin(index);
+            });
+            threads[i].Start();
+        }
+
+        while (Volatile.Read(ref started) != threads.Length)
+            Thread.Sleep(1);
+
+        // Each collection needs spinning threads to reach a safe point
+        var collectionsBefore = GC.CollectionCount(0);
+        for (int i = 0; i < CollectionCount; ++i)
+        {
+            var garbage = new object[100];
+            GC.Collect();
+        }
+        Console.WriteLine(GC.CollectionCount(0) - collectionsBefore >= CollectionCount);
+
+        // Threads can't have left their loop before that
+        bool stillRunning = true;
+        foreach (var thread in threads)
+            stillRunning &= thread.IsAlive;
+        Console.WriteLine(stillRunning);
+
+        Volatile.Write(ref collectionsDone, true);
+
+        foreach (var thread in threads)
+            thread.Join();
+
+        foreach (var spun in spunDuringCollections)
+            Console.WriteLine(spun);
+        foreach (var checksum in checksums)
+            Console.WriteLine(checksum);
+    }
+}
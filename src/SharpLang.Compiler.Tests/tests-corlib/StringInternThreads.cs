@@ -0,0 +1,56 @@
+using System;
+using System.Threading;
+
+public static class Program
+{
+    const int StringCount = 2000;
+
+    static string[][] interned = new string[4][];
+
+    static void Intern(int thread)
+    {
+        var results = new string[StringCount];
+        for (int i = 0; i < StringCount; ++i)
+        {
+            // Go through strings in a different order on each thread, and allocate to get some collections in
+            var index = (i * 7 + thread * 500) % StringCount;
+            results[index] = string.Intern("str" + index.ToString());
+        }
+
+        interned[thread] = results;
+    }
+
+    public static void Main()
+    {
+        var threads = new Thread[interned.Length];
+        for (int i = 0; i < threads.Length; ++i)
+        {
+            var thread = i;
+            threads[i] = new Thread(() => Intern(thread));
+            threads[i].Start();
+        }
+
+        foreach (var thread in threads)
+            thread.Join();
+
+        GC.Collect();
+
+        // Every thread should have received the same instance for a given content
+        bool sameInstances = true;
+        bool sameContent = true;
+        for (int i = 0; i < StringCount; ++i)
+        {
+            for (int thread = 1; thread < interned.Length; ++thread)
+                sameInstances &= (object)interned[thread][i] == (object)interned[0][i];
+            sameContent &= interned[0][i] == "str" + i.ToString();
+        }
+
+        Console.WriteLine(sameInstances);
+        Console.WriteLine(sameContent);
+
+        // Literals and interned strings should match
+        Console.WriteLine((object)interned[0][42] == (object)"str42");
+        Console.WriteLine(string.IsInterned("str" + "1999") != null);
+        Console.WriteLine(string.IsInterned("not" + "interned" + StringCount.ToString()) == null);
+    }
+}
@@ -0,0 +1,81 @@
+using System;
+using System.Threading;
+
+public static class Program
+{
+    static readonly object doneLock = new object();
+    static int pending;
+    static long sum;
+    static int[] executed = new int[1000];
+
+    static void Complete()
+    {
+        if (Interlocked.Decrement(ref pending) == 0)
+        {
+            lock (doneLock)
+                Monitor.PulseAll(doneLock);
+        }
+    }
+
+    static void WaitAll()
+    {
+        lock (doneLock)
+        {
+            while (Volatile.Read(ref pending) != 0)
+                Monitor.Wait(doneLock, 100);
+        }
+    }
+
+    static void Item(object state)
+    {
+        var index = (int)state;
+        Interlocked.Increment(ref executed[index]);
+        Interlocked.Add(ref sum, index);
+        Complete();
+    }
+
+    // Work items queued from pool threads go to the local queue of their worker (and can be stolen)
+    static void Split(object state)
+    {
+        var range = (int[])state;
+        var start = range[0];
+        var end = range[1];
+
+        if (end - start <= 8)
+        {
+            for (int i = start; i < end; ++i)
+                Interlocked.Add(ref sum, i);
+        }
+        else
+        {
+            var middle = (start + end) / 2;
+            Interlocked.Add(ref pending, 2);
+            ThreadPool.QueueUserWorkItem(Split, new[] { start, middle });
+            ThreadPool.QueueUserWorkItem(Split, new[] { middle, end });
+        }
+
+        Complete();
+    }
+
+    public static void Main()
+    {
+        // Work items queued from outside the pool
+        pending = executed.Length;
+        for (int i = 0; i < executed.Length; ++i)
+            ThreadPool.QueueUserWorkItem(Item, i);
+        WaitAll();
+
+        bool executedOnce = true;
+        foreach (var count in executed)
+            executedOnce &= count == 1;
+        Console.WriteLine(executedOnce);
+        Console.WriteLine(sum);
+
+        // Recursive splitting
+        sum = 0;
+        pending = 1;
+        ThreadPool.QueueUserWorkItem(Split, new[] { 0, 100000 });
+        WaitAll();
+        Console.WriteLine(sum);
+    }
+}
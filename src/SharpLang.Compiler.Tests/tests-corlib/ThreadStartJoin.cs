@@ -0,0 +1,62 @@
+using System;
+using System.Threading;
+
+public static class Program
+{
+    static int[] results = new int[4];
+    static Thread[] currentThreads = new Thread[4];
+    static int[] threadIds = new int[4];
+
+    static void Run(object parameter)
+    {
+        var index = (int)parameter;
+
+        results[index] = (index + 1) * 10;
+        currentThreads[index] = Thread.CurrentThread;
+        threadIds[index] = Thread.CurrentThread.ManagedThreadId;
+
+        // Allocate enough to collect while other threads are running
+        for (int i = 0; i < 10000; ++i)
+        {
+            var garbage = new object[4];
+        }
+        GC.Collect();
+    }
+
+    public static void Main()
+    {
+        var threads = new Thread[results.Length];
+        for (int i = 0; i < threads.Length; ++i)
+        {
+            threads[i] = new Thread(Run);
+            threads[i].Start(i);
+        }
+
+        for (int i = 0; i < threads.Length; ++i)
+        {
+            threads[i].Join();
+            Console.WriteLine(results[i]);
+            Console.WriteLine(currentThreads[i] == threads[i]);
+            Console.WriteLine(threads[i].IsAlive);
+        }
+
+        // Thread ids are distinct, and differ from main thread id
+        bool distinct = true;
+        for (int i = 0; i < threadIds.Length; ++i)
+        {
+            distinct &= threadIds[i] != Thread.CurrentThread.ManagedThreadId;
+            for (int j = i + 1; j < threadIds.Length; ++j)
+                distinct &= threadIds[i] != threadIds[j];
+        }
+        Console.WriteLine(distinct);
+
+        Console.WriteLine(Thread.CurrentThread == Thread.CurrentThread);
+
+        // Thread without parameter
+        var message = "not run";
+        var simpleThread = new Thread(() => message = "run");
+        simpleThread.Start();
+        simpleThread.Join();
+        Console.WriteLine(message);
+    }
+}
@@ -0,0 +1,81 @@
+using System;
+using System.Collections.Generic;
+
+public static class Program
+{
+    interface IProducer<out T> { T Produce(); }
+    interface IConsumer<in T> { void Consume(T value); }
+
+    class Producer<T> : IProducer<T> where T : new()
+    {
+        public T Produce() { return new T(); }
+    }
+
+    class Consumer<T> : IConsumer<T>
+    {
+        public void Consume(T value) { }
+    }
+
+    class Animal { }
+    class Cat : Animal { }
+
+    static void Check(string name, bool value)
+    {
+        Console.WriteLine(name + ": " + value);
+    }
+
+    public static void Main()
+    {
+        object list = new List<string>();
+        Check("List<string> is IEnumerable<object>", list is IEnumerable<object>);
+        Check("List<string> is IEnumerable<string>", list is IEnumerable<string>);
+        Check("List<string> is IList<object>", list is IList<object>);
+
+        object ints = new List<int>();
+        Check("List<int> is IEnumerable<object>", ints is IEnumerable<object>);
+
+        object action = new Action<object>(x => { });
+        Check("Action<object> is Action<string>", action is Action<string>);
+        Check("Action<string> is Action<object>", (object)new Action<string>(x => { }) is Action<object>);
+
+        object func = new Func<string>(() => "a");
+        Check("Func<string> is Func<object>", func is Func<object>);
+
+        object producer = new Producer<Cat>();
+        Check("Producer<Cat> is IProducer<Animal>", producer is IProducer<Animal>);
+        Check("Producer<Cat> is IConsumer<Animal>", producer is IConsumer<Animal>);
+
+        object consumer = new Consumer<Animal>();
+        Check("Consumer<Animal> is IConsumer<Cat>", consumer is IConsumer<Cat>);
+        Check("Consumer<Animal> is IProducer<Cat>", consumer is IProducer<Cat>);
+
+        object comparer = Comparer<object>.Default;
+        Check("Comparer<object> is IComparer<string>", comparer is IComparer<string>);
+
+        object strings = new string[0];
+        Check("string[] is object[]", strings is object[]);
+        Check("string[] is IEnumerable<object>", strings is IEnumerable<object>);
+        Check("int[] is object[]", (object)new int[0] is object[]);
+
+        // Same checks repeated, going through the cast cache
+        int hits = 0;
+        for (int i = 0; i < 1000; ++i)
+        {
+            if (list is IEnumerable<object>) hits++;
+            if (ints is IEnumerable<object>) hits++;
+            if (action is Action<string>) hits++;
+        }
+        Console.WriteLine(hits);
+
+        // Reflection uses the same rules
+        Check("IsAssignableFrom(List<string>)", typeof(IEnumerable<object>).IsAssignableFrom(typeof(List<string>)));
+        Check("IsAssignableFrom(List<int>)", typeof(IEnumerable<object>).IsAssignableFrom(typeof(List<int>)));
+
+        // Casts
+        var enumerable = (IEnumerable<object>)list;
+        Console.WriteLine(enumerable != null);
+        var stringAction = (Action<string>)action;
+        stringAction("test");
+        Console.WriteLine("Cast action invoked");
+    }
+}
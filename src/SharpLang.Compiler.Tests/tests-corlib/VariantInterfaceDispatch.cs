@@ -0,0 +1,80 @@
+using System;
+using System.Collections.Generic;
+
+public static class Program
+{
+    interface IProducer<out T> { T Produce(); }
+    interface IConsumer<in T> { string Consume(T value); }
+
+    class Animal { public virtual string Name { get { return "Animal"; } } }
+    class Cat : Animal { public override string Name { get { return "Cat"; } } }
+
+    class CatProducer : IProducer<Cat>
+    {
+        public Cat Produce() { return new Cat(); }
+    }
+
+    class AnimalConsumer : IConsumer<Animal>
+    {
+        public string Consume(Animal value) { return "AnimalConsumer " + value.Name; }
+    }
+
+    // Implements the interface for two instantiations: an exact match must win over a variant one
+    class BothProducer : IProducer<Animal>, IProducer<Cat>
+    {
+        Animal IProducer<Animal>.Produce() { return new Animal(); }
+        Cat IProducer<Cat>.Produce() { return new Cat(); }
+    }
+
+    class BothConsumer : IConsumer<object>, IConsumer<Animal>
+    {
+        string IConsumer<object>.Consume(object value) { return "object"; }
+        string IConsumer<Animal>.Consume(Animal value) { return "Animal"; }
+    }
+
+    static string Produce(IProducer<Animal> producer)
+    {
+        return producer.Produce().Name;
+    }
+
+    static string Consume(IConsumer<Cat> consumer)
+    {
+        return consumer.Consume(new Cat());
+    }
+
+    static string Consume(IConsumer<Animal> consumer)
+    {
+        return consumer.Consume(new Cat());
+    }
+
+    public static void Main()
+    {
+        // Covariant and contravariant call sites
+        Console.WriteLine(Produce(new CatProducer()));
+        Console.WriteLine(Consume((IConsumer<Cat>)new AnimalConsumer()));
+
+        // Exact instantiation is used when the type implements it
+        Console.WriteLine(Produce(new BothProducer()));
+        Console.WriteLine(((IProducer<Cat>)new BothProducer()).Produce().Name);
+        Console.WriteLine(Consume((IConsumer<Animal>)new BothConsumer()));
+        Console.WriteLine(((IConsumer<object>)new BothConsumer()).Consume(null));
+
+        // Same call site, alternating between exact and variant targets
+        var producers = new IProducer<Animal>[] { new CatProducer(), new BothProducer() };
+        var results = new string[4];
+        for (int i = 0; i < 1000; ++i)
+        {
+            var name = Produce(producers[i % 2]);
+            results[i % 4] = name;
+        }
+        Console.WriteLine(string.Join(",", results));
+
+        // Framework interfaces
+        IEnumerable<object> enumerable = new List<string> { "a", "b", "c" };
+        foreach (var item in enumerable)
+            Console.WriteLine(item);
+
+        IComparer<string> comparer = Comparer<object>.Default;
+        Console.WriteLine(comparer.Compare("a", "a"));
+    }
+}
@@ -13,6 +13,7 @@ namespace SharpLang.CompilerServices
     public partial class Compiler
     {
         public const int InterfaceMethodTableSize = 19;
+        public const int InterfaceCallCacheSize = 4;
 
         /// <summary>
         /// Gets the specified class.
@@ -176,6 +177,7 @@ namespace SharpLang.CompilerServices
                         parentRuntimeTypeInfoType,
                         LLVM.Int8TypeInContext(context), // IsConcreteType
                         LLVM.Int8TypeInContext(context), // CorElementType
+                        int16LLVM, // GenericVariance
                         typeDefLLVM,
                         intPtrLLVM,
                         sharpLangTypeType.DefaultTypeLLVM, // CachedType
@@ -223,6 +225,8 @@ namespace SharpLang.CompilerServices
                             LLVM.PointerType(intPtrLLVM, 0), // SuperTypes
                             LLVM.PointerType(intPtrLLVM, 0), // InterfaceMap
                             LLVM.Int8TypeInContext(context), // TypeInitialized
+                            LLVM.Int8TypeInContext(context), // Flags
+                            int16LLVM, // InterfaceHashMask
                             LLVM.Int32TypeInContext(context), // ObjectSize
                             LLVM.Int32TypeInContext(context), // ElementSize
                             LLVM.ArrayType(intPtrLLVM, InterfaceMethodTableSize), // IMT
@@ -233,7 +237,7 @@ namespace SharpLang.CompilerServices
                     }
 
                     LLVM.StructSetBody(runtimeTypeInfoType, runtimeTypeInfoFields.ToArray(), false);
-                    LLVM.StructSetBody(boxedType, new[] { LLVM.TypeOf(@class.GeneratedEETypeRuntimeLLVM), valueType }, false);
+                    LLVM.StructSetBody(boxedType, new[] { LLVM.TypeOf(@class.GeneratedEETypeRuntimeLLVM), nativeIntLLVM, valueType }, false);
 
                     if (@class.Type.IsLocal)
                     {
@@ -426,6 +430,7 @@ namespace SharpLang.CompilerServices
                 @class.BaseType != null ? @class.BaseType.GeneratedEETypeTokenLLVM : LLVM.ConstPointerNull(intPtrLLVM),
                 LLVM.ConstInt(LLVM.Int8TypeInContext(context), isConcreteType ? 1U : 0U, false),
                 LLVM.ConstInt(LLVM.Int8TypeInContext(context), (byte)@class.Type.TypeReferenceCecil.MetadataType, false),
+                LLVM.ConstInt(int16LLVM, GetGenericVariance(@class), false),
                 LLVM.ConstNamedStruct(typeDefLLVM, new[]
                 {
                     sharpLangModule,
@@ -445,9 +450,18 @@ namespace SharpLang.CompilerServices
             {
                 // Build IMT
                 var interfaceMethodTable = new LinkedList<InterfaceMethodTableEntry>[InterfaceMethodTableSize];
+
+                // Also build dispatch tables (one per interface, indexed by method index in interface definition)
+                // Used by runtime for calls not found in IMT (i.e. variance)
+                var interfaceDispatchTables = new Dictionary<Class, ValueRef[]>();
+
                 foreach (var @interface in @class.Interfaces)
                 {
-                    foreach (var interfaceMethod in @interface.Type.TypeReferenceCecil.Resolve().Methods)
+                    var interfaceMethods = @interface.Type.TypeReferenceCecil.Resolve().Methods;
+                    var interfaceDispatchTable = new ValueRef[interfaceMethods.Count];
+                    interfaceDispatchTables.Add(@interface, interfaceDispatchTable);
+
+                    foreach (var interfaceMethod in interfaceMethods)
                     {
                         var resolvedInterfaceMethod = ResolveGenericMethod(@interface.Type.TypeReferenceCecil, interfaceMethod);
 
@@ -491,6 +505,8 @@ namespace SharpLang.CompilerServices
                         if (resolvedFunction == null)
                             throw new InvalidOperationException("Interface method not found");
 
+                        interfaceDispatchTable[interfaceMethods.IndexOf(interfaceMethod)] = LLVM.ConstPointerCast(GetVirtualMethod(resolvedFunction), intPtrLLVM);
+
                         var methodId = GetMethodId(resolvedInterfaceMethod);
                         var imtSlotIndex = (int)(methodId % InterfaceMethodTableSize);
 
@@ -570,8 +586,9 @@ namespace SharpLang.CompilerServices
                 LLVM.SetLinkage(superTypesConstantGlobal, Linkage.PrivateLinkage);
                 var superTypesGlobal = LLVM.ConstInBoundsGEP(superTypesConstantGlobal, new[] {zero, zero});
 
-                // Interface map global
-                var interfacesConstantGlobal = LLVM.AddGlobal(module, LLVM.ArrayType(intPtrLLVM, (uint)@class.Interfaces.Count),
+                // Interface map global (followed by interface hash table, then by interface dispatch tables)
+                var interfaceHashTable = BuildInterfaceHashTable(@class);
+                var interfacesConstantGlobal = LLVM.AddGlobal(module, LLVM.ArrayType(intPtrLLVM, (uint)(@class.Interfaces.Count * 2 + interfaceHashTable.Length)),
                     @class.Type.TypeReferenceCecil.MangledName() + ".interfaces");
                 LLVM.SetLinkage(interfacesConstantGlobal, Linkage.PrivateLinkage);
                 var interfacesGlobal = LLVM.ConstInBoundsGEP(interfacesConstantGlobal, new[] {zero, zero});
@@ -615,36 +632,49 @@ namespace SharpLang.CompilerServices
                     return LLVM.ConstNull(fieldType.DefaultTypeLLVM);
                 }).ToArray());
 
-                // Order fields: instance ref (for GC), instance non-ref, then static ref and non-ref
-                var fields = @class.Type.Fields != null ? (IEnumerable<KeyValuePair<FieldDefinition, Field>>)@class.Type.Fields.OrderBy(x => (x.Key.IsStatic ? 2 : 0) + (x.Value.Type.TypeDefinitionCecil.IsValueType ? 1 : 0)) : new KeyValuePair<FieldDefinition, Field>[0];
-                int garbageCollectableFieldCount = 0;
+                // First entries are used by the GC: instance fields of referencable types, then references embedded in value type fields
+                // (with no field definition). For arrays, they describe references of a single element (relative to element start).
+                var garbageCollectableFields = new List<KeyValuePair<FieldDefinition, uint>>();
+                var arrayTypeSpecification = typeSpecification as ArrayType;
+                if (arrayTypeSpecification != null)
+                {
+                    var elementType = GetType(arrayTypeSpecification.ElementType, TypeState.StackComplete);
+                    if (elementType.StackType == StackValueType.Object)
+                        garbageCollectableFields.Add(new KeyValuePair<FieldDefinition, uint>(null, 0));
+                    else if (elementType.StackType == StackValueType.Value)
+                        AddGarbageCollectableFields(elementType, 0, true, garbageCollectableFields);
+                }
+                else
+                {
+                    AddGarbageCollectableFields(@class.Type, 0, false, garbageCollectableFields);
+                }
+
+                // Then other instance fields, and static fields
+                var otherFields = @class.Type.Fields != null
+                    ? @class.Type.Fields.Where(x => x.Key.IsStatic || x.Value.Type.StackType != StackValueType.Object).OrderBy(x => x.Key.IsStatic ? 1 : 0)
+                    : Enumerable.Empty<KeyValuePair<FieldDefinition, Field>>();
 
                 // Generate SharpLangFieldDescription
-                var fieldDescriptions = fields.Select(x =>
-                {
-                    if (!x.Key.IsStatic && x.Value.Type.TypeDefinitionCecil.IsValueType)
+                var fieldDescriptions = garbageCollectableFields
+                    .Concat(otherFields.Select(x => new KeyValuePair<FieldDefinition, uint>(x.Key, GetFieldOffset(@class.Type, x.Value))))
+                    .Select(x =>
                     {
-                        garbageCollectableFieldCount++;
-                    }
+                        // Encode what SharpLangFieldDescription expects
+                        // Note: at some point, we might want to include a SharpLangFieldDescription.cs with #ifdef to be sure it doesn't get out of sync
+                        uint data1 = x.Key != null ? x.Key.MetadataToken.RID : 0;
+                        if (x.Key != null && x.Key.IsStatic)
+                            data1 |= 1 << 24;
 
-                    // Encode what SharpLangFieldDescription expects
-                    // Note: at some point, we might want to include a SharpLangFieldDescription.cs with #ifdef to be sure it doesn't get out of sync
-                    uint data1 = x.Key.MetadataToken.RID;
-                    if (x.Key.IsStatic)
-                        data1 |= 1 << 24;
+                        uint data2 = x.Value;
+                        data2 &= 0x7FFFFFF;
+                        data2 |= (uint)@class.Type.TypeDefinitionCecil.MetadataType << 27;
 
-                    uint data2 = IsCustomLayout(@class.Type.TypeDefinitionCecil)
-                        ? (uint)x.Value.StructIndex
-                        : (uint)LLVM.OffsetOfElement(targetData, @class.Type.ValueTypeLLVM, (uint)x.Value.StructIndex); // alternative: ConstGEP?
-                    data2 &= 0x7FFFFFF;
-                    data2 |= (uint)@class.Type.TypeDefinitionCecil.MetadataType << 27;
-
-                    return LLVM.ConstNamedStruct(fieldDesc.DefaultTypeLLVM, new[]
-                    {
-                        LLVM.ConstInt(int32LLVM, data1, false),
-                        LLVM.ConstInt(int32LLVM, data2, false),
-                    });
-                }).ToArray();
+                        return LLVM.ConstNamedStruct(fieldDesc.DefaultTypeLLVM, new[]
+                        {
+                            LLVM.ConstInt(int32LLVM, data1, false),
+                            LLVM.ConstInt(int32LLVM, data2, false),
+                        });
+                    }).ToArray();
 
                 var fieldDescriptionsConstantGlobal = LLVM.AddGlobal(module, LLVM.ArrayType(fieldDesc.DefaultTypeLLVM, (uint)fieldDescriptions.Length), @class.Type.TypeReferenceCecil.MangledName() + ".fields");
                 LLVM.SetLinkage(fieldDescriptionsConstantGlobal, Linkage.PrivateLinkage);
@@ -653,7 +683,7 @@ namespace SharpLang.CompilerServices
 
                 runtimeTypeFields.AddRange(new[]
                 {
-                    LLVM.ConstInt(int16LLVM, (ulong)garbageCollectableFieldCount, false),
+                    LLVM.ConstInt(int16LLVM, (ulong)garbageCollectableFields.Count, false),
                     LLVM.ConstInt(int16LLVM, (ulong)fieldDescriptions.Length, false),
                     fieldDescriptionsGlobal,
 
@@ -662,6 +692,8 @@ namespace SharpLang.CompilerServices
                     superTypesGlobal,
                     interfacesGlobal,
                     LLVM.ConstInt(LLVM.Int8TypeInContext(context), 0, false), // Class initialized?
+                    LLVM.ConstInt(LLVM.Int8TypeInContext(context), (ulong)GetEETypeFlags(@class), false), // Flags
+                    LLVM.ConstInt(int16LLVM, (ulong)(interfaceHashTable.Length - 1), false), // InterfaceHashMask
                     LLVM.ConstIntCast(LLVM.SizeOf(@class.Type.ObjectTypeLLVM), int32LLVM, false),
                     elementTypeSize,
                     interfaceMethodTableConstant,
@@ -680,11 +712,22 @@ namespace SharpLang.CompilerServices
                         .ToArray());
                 LLVM.SetInitializer(superTypesConstantGlobal, superTypesConstant);
 
-                // Build interface map
-                var interfacesConstant = LLVM.ConstArray(intPtrLLVM,
-                    @class.Interfaces.Select(
-                        @interface => LLVM.ConstPointerCast(@interface.GeneratedEETypeTokenLLVM, intPtrLLVM)).ToArray());
-                LLVM.SetInitializer(interfacesConstantGlobal, interfacesConstant);
+                // Build interface map, followed by interface hash table
+                var interfacesConstant = @class.Interfaces.Concat(interfaceHashTable).Select(
+                        @interface => @interface != null ? LLVM.ConstPointerCast(@interface.GeneratedEETypeTokenLLVM, intPtrLLVM) : LLVM.ConstPointerNull(intPtrLLVM)).ToList();
+
+                // Then interface dispatch tables (same order as interface map)
+                foreach (var @interface in @class.Interfaces)
+                {
+                    var interfaceDispatchTable = interfaceDispatchTables[@interface]
+                        .Select(x => x != ValueRef.Empty ? x : LLVM.ConstPointerNull(intPtrLLVM)).ToArray();
+                    var interfaceDispatchTableGlobal = LLVM.AddGlobal(module, LLVM.ArrayType(intPtrLLVM, (uint)interfaceDispatchTable.Length),
+                        @class.Type.TypeReferenceCecil.MangledName() + ".itable");
+                    LLVM.SetLinkage(interfaceDispatchTableGlobal, Linkage.PrivateLinkage);
+                    LLVM.SetInitializer(interfaceDispatchTableGlobal, LLVM.ConstArray(intPtrLLVM, interfaceDispatchTable));
+                    interfacesConstant.Add(LLVM.ConstPointerCast(interfaceDispatchTableGlobal, intPtrLLVM));
+                }
+                LLVM.SetInitializer(interfacesConstantGlobal, LLVM.ConstArray(intPtrLLVM, interfacesConstant.ToArray()));
             }
             else
             {
@@ -697,6 +740,83 @@ namespace SharpLang.CompilerServices
             LLVM.SetLinkage(runtimeTypeInfoGlobal, Linkage.ExternalLinkage);
         }
 
+        /// <summary>
+        /// Collects offsets of references stored in instance fields of the given type, recursing into embedded value types.
+        /// </summary>
+        /// <param name="type">The type.</param>
+        /// <param name="baseOffset">The offset of the type data.</param>
+        /// <param name="embedded">If set to <c>true</c>, fields are embedded in a value type and won't be registered with their field definition.</param>
+        /// <param name="result">The list receiving field definitions and offsets.</param>
+        private void AddGarbageCollectableFields(Type type, uint baseOffset, bool embedded, List<KeyValuePair<FieldDefinition, uint>> result)
+        {
+            if (type.Fields == null)
+                return;
+
+            foreach (var field in type.Fields)
+            {
+                if (field.Key.IsStatic)
+                    continue;
+
+                var fieldOffset = baseOffset + GetFieldOffset(type, field.Value);
+                var fieldType = field.Value.Type;
+
+                if (fieldType.StackType == StackValueType.Object)
+                    result.Add(new KeyValuePair<FieldDefinition, uint>(embedded ? null : field.Key, fieldOffset));
+                else if (fieldType.StackType == StackValueType.Value)
+                    AddGarbageCollectableFields(fieldType, fieldOffset, true, result);
+            }
+        }
+
+        /// <summary>
+        /// Determines whether instances of the given value type embed references that the GC needs to know about.
+        /// </summary>
+        private bool HasGarbageCollectableFields(Type type)
+        {
+            var garbageCollectableFields = new List<KeyValuePair<FieldDefinition, uint>>();
+            AddGarbageCollectableFields(type, 0, true, garbageCollectableFields);
+            return garbageCollectableFields.Count > 0;
+        }
+
+        /// <summary>
+        /// Gets the offset of a field, relative to the start of its declaring type data.
+        /// </summary>
+        private uint GetFieldOffset(Type type, Field field)
+        {
+            return IsCustomLayout(type.TypeDefinitionCecil)
+                ? (uint)field.StructIndex
+                : (uint)LLVM.OffsetOfElement(targetData, type.ValueTypeLLVM, (uint)field.StructIndex); // alternative: ConstGEP?
+        }
+
+        private EETypeFlags GetEETypeFlags(Class @class)
+        {
+            var flags = EETypeFlags.None;
+
+            // Runtime registers instances for finalization if Object.Finalize is overridden
+            if (@class.VirtualTable.Any(x => x.MethodReference.Name == "Finalize" && x.MethodReference.Parameters.Count == 0
+                                             && x.DeclaringType.TypeReferenceCecil.FullName != typeof(object).FullName))
+                flags |= EETypeFlags.HasFinalizer;
+
+            // Generic variance only applies to reference type arguments
+            if (@class.Type.TypeDefinitionCecil.IsValueType)
+                flags |= EETypeFlags.IsValueType;
+
+            return flags;
+        }
+
+        private static ulong GetGenericVariance(Class @class)
+        {
+            // 2 bits per generic parameter (only first 8 parameters can be variant)
+            ulong genericVariance = 0;
+            var genericParameters = @class.Type.TypeDefinitionCecil.GenericParameters;
+            for (int i = 0; i < genericParameters.Count && i < 8; ++i)
+            {
+                var variance = genericParameters[i].Attributes & GenericParameterAttributes.VarianceMask;
+                genericVariance |= (ulong)variance << (i * 2);
+            }
+
+            return genericVariance;
+        }
+
         /// <summary>
         /// Gets a LLVM function suitable to be put in virtual table (which expect only reference types).
         /// </summary>
@@ -761,6 +881,49 @@ namespace SharpLang.CompilerServices
             return function.GeneratedValue;
         }
 
+        /// <summary>
+        /// Builds the interface hash table of a class (open addressing with linear probing, at most half full).
+        /// It allows interface casts to usually be checked with a single probe.
+        /// </summary>
+        /// <param name="class">The class.</param>
+        /// <returns>The interfaces stored at their hashed slot, null for empty slots.</returns>
+        private static Class[] BuildInterfaceHashTable(Class @class)
+        {
+            var tableSize = 1;
+            while (tableSize < @class.Interfaces.Count * 2)
+                tableSize *= 2;
+
+            if (tableSize > ushort.MaxValue + 1)
+                throw new NotSupportedException("Too many interfaces");
+
+            var table = new Class[tableSize];
+            foreach (var @interface in @class.Interfaces)
+            {
+                var slot = (int)(GetInterfaceId(@interface) & (tableSize - 1));
+                while (table[slot] != null)
+                    slot = (slot + 1) & (tableSize - 1);
+
+                table[slot] = @interface;
+            }
+
+            return table;
+        }
+
+        private static uint GetInterfaceId(Class @interface)
+        {
+            // Same as IMT, use full name hash code (so that it is the same in every module)
+            return StringHashCode(@interface.Type.TypeReferenceCecil.FullName);
+        }
+
+        private static int GetInterfaceMethodIndex(MethodReference interfaceMethod)
+        {
+            // Generic method instances are not in dispatch tables
+            if (interfaceMethod is GenericInstanceMethod)
+                return -1;
+
+            return interfaceMethod.DeclaringType.Resolve().Methods.IndexOf(interfaceMethod.Resolve());
+        }
+
         private static uint GetMethodId(MethodReference resolvedInterfaceMethod)
         {
             // For now, use full name has code for IMT slot
@@ -41,18 +41,29 @@ namespace SharpLang.CompilerServices
 
         // Runtime Types
         private TypeRef imtEntryLLVM;
+        private TypeRef interfaceCallCacheLLVM;
         private TypeRef caughtResultLLVM;
 
         // Runtime Methods
         private ValueRef allocObjectFunctionLLVM;
-        private ValueRef resolveInterfaceCallFunctionLLVM;
+        private ValueRef writeBarrierFunctionLLVM;
+        private ValueRef writeBarrierRangeFunctionLLVM;
+        private ValueRef safepointPollFunctionLLVM;
+        private ValueRef enableSafepointGuardPageFunctionLLVM;
+        private ValueRef registerStringLiteralsFunctionLLVM;
+        private ValueRef resolveInterfaceCallCachedFunctionLLVM;
         private ValueRef isInstInterfaceFunctionLLVM;
+        private ValueRef canCastToFunctionLLVM;
         private ValueRef throwExceptionFunctionLLVM;
         private ValueRef sharpPersonalityFunctionLLVM;
         private ValueRef pinvokeLoadLibraryFunctionLLVM;
         private ValueRef pinvokeGetProcAddressFunctionLLVM;
         private ValueRef palInitializeFunctionLLVM;
 
+        // Runtime Globals
+        private ValueRef safepointPollFlagLLVM;
+        private ValueRef safepointPollPageLLVM;
+
         // Types used for reflection
         private TypeRef typeDefLLVM;
         private Type sharpLangTypeType;
@@ -150,6 +161,18 @@ namespace SharpLang.CompilerServices
             imtEntryLLVM = LLVM.StructCreateNamed(context, "IMTEntry");
             LLVM.StructSetBody(imtEntryLLVM, new[] { intPtrLLVM, intPtrLLVM }, false);
 
+            // struct InterfaceCallCache { i8* eeTypes[InterfaceCallCacheSize], i8* targets[InterfaceCallCacheSize], i8* next, i32 hits, i32 misses, i32 inlineHits }
+            interfaceCallCacheLLVM = LLVM.StructCreateNamed(context, "InterfaceCallCache");
+            LLVM.StructSetBody(interfaceCallCacheLLVM, new[]
+            {
+                LLVM.ArrayType(intPtrLLVM, InterfaceCallCacheSize),
+                LLVM.ArrayType(intPtrLLVM, InterfaceCallCacheSize),
+                intPtrLLVM,
+                int32LLVM,
+                int32LLVM,
+                int32LLVM,
+            }, false);
+
             // struct CaughtResultType { i8*, i32 }
             caughtResultLLVM = LLVM.StructCreateNamed(context, "CaughtResultType");
             LLVM.StructSetBody(caughtResultLLVM, new[] { intPtrLLVM, int32LLVM }, false);
@@ -172,13 +195,23 @@ namespace SharpLang.CompilerServices
 
             // Import runtime methods
             allocObjectFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "allocObject");
-            resolveInterfaceCallFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "resolveInterfaceCall");
+            writeBarrierFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "writeBarrier");
+            writeBarrierRangeFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "writeBarrierRange");
+            safepointPollFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "safepointPoll");
+            enableSafepointGuardPageFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "enableSafepointGuardPage");
+            registerStringLiteralsFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "registerStringLiterals");
+            resolveInterfaceCallCachedFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "resolveInterfaceCallCached");
             isInstInterfaceFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "isInstInterface");
+            canCastToFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "canCastTo");
             throwExceptionFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "throwException");
             sharpPersonalityFunctionLLVM = ImportRuntimeFunction(module, runtimeModule, "sharpPersonality");
             pinvokeLoadLibraryFunctionLLVM = ImportRuntimeFunction(module, runtimeCoreModule, "PInvokeOpenLibrary");
             pinvokeGetProcAddressFunctionLLVM = ImportRuntimeFunction(module, runtimeCoreModule, "PInvokeGetProcAddress");
 
+            // Import runtime globals
+            safepointPollFlagLLVM = ImportRuntimeGlobal(module, runtimeModule, "safepointPollFlag");
+            safepointPollPageLLVM = ImportRuntimeGlobal(module, runtimeModule, "safepointPollPage");
+
             if (triple.Contains("linux"))
             {
                 var palInitializeFunctionType = LLVM.FunctionType(int32LLVM, new[] {int32LLVM, LLVM.PointerType(intPtrLLVM, 0)}, false);
@@ -209,5 +242,13 @@ namespace SharpLang.CompilerServices
 
             return LLVM.AddFunction(module, name, functionType);
         }
+
+        private ValueRef ImportRuntimeGlobal(ModuleRef module, ModuleRef runtimeModule, string name)
+        {
+            var global = LLVM.GetNamedGlobal(runtimeModule, name);
+            var globalType = LLVM.GetElementType(LLVM.TypeOf(global));
+
+            return LLVM.AddGlobal(module, globalType, name);
+        }
     }
 }
\ No newline at end of file
@@ -47,6 +47,27 @@ namespace SharpLang.CompilerServices
             SetInstructionFlags(store, instructionFlags);
         }
 
+        /// <summary>
+        /// Emits a write barrier (card marking for the generational GC) after storing a value of the given type at the given address, if it contains references.
+        /// </summary>
+        /// <param name="type">The stored type.</param>
+        /// <param name="dest">The destination address.</param>
+        private void EmitWriteBarrier(Type type, ValueRef dest)
+        {
+            if (type.StackType == StackValueType.Object)
+            {
+                var address = LLVM.BuildPointerCast(builder, dest, intPtrLLVM, string.Empty);
+                LLVM.BuildCall(builder, writeBarrierFunctionLLVM, new[] { address }, string.Empty);
+            }
+            else if (type.StackType == StackValueType.Value && HasGarbageCollectableFields(type))
+            {
+                // Struct might span multiple cards
+                var address = LLVM.BuildPointerCast(builder, dest, intPtrLLVM, string.Empty);
+                var size = LLVM.BuildIntCast(builder, LLVM.SizeOf(type.DefaultTypeLLVM), nativeIntLLVM, string.Empty);
+                LLVM.BuildCall(builder, writeBarrierRangeFunctionLLVM, new[] { address, size }, string.Empty);
+            }
+        }
+
         private void EmitStloc(FunctionStack stack, List<StackValue> locals, int localIndex)
         {
             var value = stack.Pop();
@@ -153,6 +174,7 @@ namespace SharpLang.CompilerServices
             // Store value at address
             var pointerCast = LLVM.BuildPointerCast(builder, address.Value, LLVM.PointerType(type.DefaultTypeLLVM, 0), string.Empty);
             StoreValue(type.StackType, sourceValue, pointerCast, instructionFlags);
+            EmitWriteBarrier(type, pointerCast);
         }
 
         private void EmitInitobj(StackValue address, Type type)
@@ -223,26 +245,19 @@ namespace SharpLang.CompilerServices
             }
 
             // TODO: Improve performance (better inlining, etc...)
-            // Invoke malloc
+            // Invoke allocator (it also setups vtable)
             var typeSize = LLVM.BuildIntCast(builder, LLVM.SizeOf(type.ObjectTypeLLVM), nativeIntLLVM, string.Empty);
-            var allocatedData = LLVM.BuildCall(builder, allocObjectFunctionLLVM, new[] { typeSize }, string.Empty);
+            var allocatedData = LLVM.BuildCall(builder, allocObjectFunctionLLVM, new[] { GetAllocObjectEEType(@class), typeSize }, string.Empty);
             var allocatedObject = LLVM.BuildPointerCast(builder, allocatedData, LLVM.PointerType(type.ObjectTypeLLVM, 0), string.Empty);
 
-            SetupVTable(allocatedObject, @class);
             return allocatedObject;
         }
 
-        private void SetupVTable(ValueRef @object, Class @class)
+        private ValueRef GetAllocObjectEEType(Class @class)
         {
-            // Store vtable global into first field of the object
-            var indices = new[]
-            {
-                LLVM.ConstInt(int32LLVM, 0, false),                                     // Pointer indirection
-                LLVM.ConstInt(int32LLVM, (int)ObjectFields.RuntimeTypeInfo, false),     // Access RTTI
-            };
-
-            var vtablePointer = LLVM.BuildInBoundsGEP(builder, @object, indices, string.Empty);
-            LLVM.BuildStore(builder, @class.GeneratedEETypeRuntimeLLVM, vtablePointer);
+            // Runtime allocator takes the EEType, so that it can be profiled per type
+            var eeTypeType = LLVM.TypeOf(LLVM.GetParam(allocObjectFunctionLLVM, 0));
+            return LLVM.BuildPointerCast(builder, @class.GeneratedEETypeRuntimeLLVM, eeTypeType, string.Empty);
         }
 
         private ValueRef SetupVTableConstant(ValueRef @object, Class @class)
@@ -300,24 +315,38 @@ namespace SharpLang.CompilerServices
         {
             var stringClass = GetClass(corlib.MainModule.GetType(typeof(string).FullName));
 
-            var utf16String = operand.Select(x => LLVM.ConstInt(LLVM.Int16TypeInContext(context), x, false)); // string
-            utf16String = utf16String.Concat(new[] { LLVM.ConstNull(LLVM.Int16TypeInContext(context)) }); // null-terminate
+            // Each literal is emitted once per module, and loaded through a slot.
+            // Slots are updated at module initialization to the interned string of same content (so that literals are unique across modules).
+            ValueRef stringLiteralSlot;
+            if (!stringLiterals.TryGetValue(operand, out stringLiteralSlot))
+            {
+                var utf16String = operand.Select(x => LLVM.ConstInt(LLVM.Int16TypeInContext(context), x, false)); // string
+                utf16String = utf16String.Concat(new[] { LLVM.ConstNull(LLVM.Int16TypeInContext(context)) }); // null-terminate
 
-            var stringConstantData = LLVM.ConstArray(LLVM.Int16TypeInContext(context), utf16String.ToArray());
+                var stringConstantData = LLVM.ConstArray(LLVM.Int16TypeInContext(context), utf16String.ToArray());
 
-            var stringConstant = LLVM.ConstStructInContext(context, new[]
-            {
-                stringClass.GeneratedEETypeRuntimeLLVM,
-                LLVM.ConstInt(int32LLVM, (ulong)operand.Length, false),
-                stringConstantData
-            }, false);
+                var stringConstant = LLVM.ConstStructInContext(context, new[]
+                {
+                    stringClass.GeneratedEETypeRuntimeLLVM,
+                    LLVM.ConstNull(nativeIntLLVM), // Header
+                    LLVM.ConstInt(int32LLVM, (ulong)operand.Length, false),
+                    stringConstantData
+                }, false);
+
+                var stringConstantGlobal = LLVM.AddGlobal(module, LLVM.TypeOf(stringConstant), ".string");
+                LLVM.SetInitializer(stringConstantGlobal, stringConstant);
+                LLVM.SetLinkage(stringConstantGlobal, Linkage.PrivateLinkage);
 
-            var stringConstantGlobal = LLVM.AddGlobal(module, LLVM.TypeOf(stringConstant), ".string");
-            LLVM.SetInitializer(stringConstantGlobal, stringConstant);
-            LLVM.SetLinkage(stringConstantGlobal, Linkage.PrivateLinkage);
+                stringLiteralSlot = LLVM.AddGlobal(module, stringClass.Type.DefaultTypeLLVM, ".stringref");
+                LLVM.SetInitializer(stringLiteralSlot, LLVM.ConstPointerCast(stringConstantGlobal, stringClass.Type.DefaultTypeLLVM));
+                LLVM.SetLinkage(stringLiteralSlot, Linkage.PrivateLinkage);
+
+                stringLiterals.Add(operand, stringLiteralSlot);
+            }
 
             // Push on stack
-            stack.Add(new StackValue(StackValueType.Object, stringClass.Type, LLVM.ConstPointerCast(stringConstantGlobal, stringClass.Type.DefaultTypeLLVM)));
+            var stringLiteral = LLVM.BuildLoad(builder, stringLiteralSlot, string.Empty);
+            stack.Add(new StackValue(StackValueType.Object, stringClass.Type, stringLiteral));
         }
 
         private ValueRef CreateDataConstant(byte[] data)
@@ -570,6 +599,7 @@ namespace SharpLang.CompilerServices
 
             // Store value in field
             StoreValue(field.Type.StackType, fieldValue, fieldAddress, instructionFlags);
+            EmitWriteBarrier(field.Type, fieldAddress);
         }
 
         private void EmitLdfld(FunctionStack stack, Field field, InstructionFlags instructionFlags)
@@ -770,14 +800,16 @@ namespace SharpLang.CompilerServices
             var numElementsCasted = ConvertToNativeInt(numElements);
             var arraySize = LLVM.BuildMul(builder, typeSize, numElementsCasted, string.Empty);
 
-            // Invoke malloc
-            var allocatedData = LLVM.BuildCall(builder, allocObjectFunctionLLVM, new[] { arraySize }, string.Empty);
-            var values = LLVM.BuildPointerCast(builder, allocatedData, LLVM.PointerType(elementType.DefaultTypeLLVM, 0), string.Empty);
+            // Elements are stored right after the array object, in the same allocation (so that GC sees a single object)
+            var objectSize = LLVM.BuildIntCast(builder, LLVM.SizeOf(arrayType.ObjectTypeLLVM), nativeIntLLVM, string.Empty);
+            var totalSize = LLVM.BuildAdd(builder, objectSize, arraySize, string.Empty);
 
-            var numElementsAsPointer = LLVM.BuildIntToPtr(builder, numElements.Value, intPtrLLVM, string.Empty);
+            // Invoke allocator (it also setups vtable)
+            var @class = GetClass(arrayType);
+            var allocatedData = LLVM.BuildCall(builder, allocObjectFunctionLLVM, new[] { GetAllocObjectEEType(@class), totalSize }, string.Empty);
+            var allocatedObject = LLVM.BuildPointerCast(builder, allocatedData, LLVM.PointerType(arrayType.ObjectTypeLLVM, 0), string.Empty);
 
-            // Allocate object
-            var allocatedObject = AllocateObject(arrayType);
+            var numElementsAsPointer = LLVM.BuildIntToPtr(builder, numElements.Value, intPtrLLVM, string.Empty);
 
             // Prepare indices
             var indices = new[]
@@ -787,14 +819,10 @@ namespace SharpLang.CompilerServices
                 LLVM.ConstInt(int32LLVM, 1, false),                         // Access length
             };
 
-            // Update array with size and 0 data
+            // Update array with size (elements are already zeroed)
             var sizeLocation = LLVM.BuildInBoundsGEP(builder, allocatedObject, indices, string.Empty);
             LLVM.BuildStore(builder, numElementsAsPointer, sizeLocation);
 
-            indices[2] = LLVM.ConstInt(int32LLVM, 2, false);                // Access data pointer
-            var dataPointerLocation = LLVM.BuildInBoundsGEP(builder, allocatedObject, indices, string.Empty);
-            LLVM.BuildStore(builder, values, dataPointerLocation);
-
             // Push on stack
             stack.Add(new StackValue(StackValueType.Object, arrayType, allocatedObject));
         }
@@ -901,6 +929,7 @@ namespace SharpLang.CompilerServices
 
             // Store element
             StoreValue(elementType.StackType, convertedElement, arrayElementPointer, InstructionFlags.None);
+            EmitWriteBarrier(elementType, arrayElementPointer);
         }
 
         private ValueRef LoadArrayDataPointer(StackValue array)
@@ -910,12 +939,12 @@ namespace SharpLang.CompilerServices
             {
                 LLVM.ConstInt(int32LLVM, 0, false),                         // Pointer indirection
                 LLVM.ConstInt(int32LLVM, (int) ObjectFields.Data, false),   // Data
-                LLVM.ConstInt(int32LLVM, 2, false),                         // Access data pointer
+                LLVM.ConstInt(int32LLVM, 2, false),                         // Access elements
+                LLVM.ConstInt(int32LLVM, 0, false),                         // First element
             };
 
-            // Load data pointer
-            var dataPointerLocation = LLVM.BuildInBoundsGEP(builder, array.Value, indices, string.Empty);
-            var dataPointer = LLVM.BuildLoad(builder, dataPointerLocation, string.Empty);
+            // Elements are stored inline, no need to load anything
+            var dataPointer = LLVM.BuildInBoundsGEP(builder, array.Value, indices, string.Empty);
 
             return dataPointer;
         }
@@ -1011,11 +1040,69 @@ namespace SharpLang.CompilerServices
 
             BasicBlockRef typeCheckBlock;
 
+            // Types compatible through generic variance or array covariance are not found by inline checks: let runtime decide
+            var typeMismatchBlock = typeNotMatchBlock;
+            var needsRuntimeCastCheck = GetGenericVariance(@class) != 0 || @class.Type.TypeReferenceCecil is ArrayType;
+            if (needsRuntimeCastCheck)
+            {
+                typeMismatchBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, string.Format("L_{0:x4}_type_runtime_check", instructionOffset));
+                LLVM.MoveBasicBlockBefore(typeMismatchBlock, typeNotMatchBlock);
+            }
+
             if (@class.Type.TypeReferenceCecil.Resolve().IsInterface)
             {
                 // Cast as appropriate pointer type (for next PHI incoming if success)
                 castedPointerObject = LLVM.BuildPointerCast(builder, obj.Value, castedPointerType, string.Empty);
 
+                typeCheckBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, string.Format("L_{0:x4}_type_check", instructionOffset));
+                var typeHashCollisionBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, string.Format("L_{0:x4}_type_hash_collision", instructionOffset));
+                var typeHashMissBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, string.Format("L_{0:x4}_type_hash_miss", instructionOffset));
+                LLVM.MoveBasicBlockBefore(typeCheckBlock, typeNotMatchBlock);
+                LLVM.MoveBasicBlockBefore(typeHashMissBlock, typeCheckBlock);
+                LLVM.MoveBasicBlockBefore(typeHashCollisionBlock, typeCheckBlock);
+
+                // Cast to object type (enough to have interface map)
+                var objectRttiPointer = LLVM.BuildPointerCast(builder, rttiPointer, LLVM.TypeOf(GetClass(@object).GeneratedEETypeRuntimeLLVM), string.Empty);
+
+                // Interface map is followed by a hash table, so probe slot interfaceMap[interfacesCount + (interfaceId & interfaceHashMask)]
+                indices = new[]
+                {
+                    LLVM.ConstInt(int32LLVM, 0, false), // Pointer indirection
+                    LLVM.ConstInt(int32LLVM, (int)RuntimeTypeInfoFields.InterfaceHashMask, false), // Interface hash mask
+                };
+                var interfaceHashMask = LLVM.BuildLoad(builder, LLVM.BuildInBoundsGEP(builder, objectRttiPointer, indices, string.Empty), string.Empty);
+                interfaceHashMask = LLVM.BuildZExt(builder, interfaceHashMask, int32LLVM, string.Empty);
+
+                indices = new[]
+                {
+                    LLVM.ConstInt(int32LLVM, 0, false), // Pointer indirection
+                    LLVM.ConstInt(int32LLVM, (int)RuntimeTypeInfoFields.InterfacesCount, false), // Interfaces count
+                };
+                var interfacesCount = LLVM.BuildLoad(builder, LLVM.BuildInBoundsGEP(builder, objectRttiPointer, indices, string.Empty), string.Empty);
+
+                indices = new[]
+                {
+                    LLVM.ConstInt(int32LLVM, 0, false), // Pointer indirection
+                    LLVM.ConstInt(int32LLVM, (int)RuntimeTypeInfoFields.InterfaceMap, false), // Interface map
+                };
+                var interfaceMap = LLVM.BuildLoad(builder, LLVM.BuildInBoundsGEP(builder, objectRttiPointer, indices, string.Empty), string.Empty);
+
+                var interfaceSlot = LLVM.BuildAnd(builder, LLVM.ConstInt(int32LLVM, GetInterfaceId(@class), false), interfaceHashMask, string.Empty);
+                interfaceSlot = LLVM.BuildAdd(builder, interfacesCount, interfaceSlot, string.Empty);
+                interfaceSlot = LLVM.BuildZExt(builder, interfaceSlot, nativeIntLLVM, string.Empty);
+                var interfaceHashEntry = LLVM.BuildLoad(builder, LLVM.BuildInBoundsGEP(builder, interfaceMap, new[] { interfaceSlot }, string.Empty), string.Empty);
+
+                var expectedInterface = LLVM.BuildPointerCast(builder, @class.GeneratedEETypeTokenLLVM, intPtrLLVM, string.Empty);
+                var interfaceHashEntryMatch = LLVM.BuildICmp(builder, IntPredicate.IntEQ, interfaceHashEntry, expectedInterface, string.Empty);
+                LLVM.BuildCondBr(builder, interfaceHashEntryMatch, typeCheckBlock, typeHashMissBlock);
+
+                // Empty slot: type doesn't implement interface
+                LLVM.PositionBuilderAtEnd(builder, typeHashMissBlock);
+                var interfaceHashEntryEmpty = LLVM.BuildICmp(builder, IntPredicate.IntEQ, interfaceHashEntry, LLVM.ConstPointerNull(intPtrLLVM), string.Empty);
+                LLVM.BuildCondBr(builder, interfaceHashEntryEmpty, typeMismatchBlock, typeHashCollisionBlock);
+
+                // Slot used by another interface (rare since hash table is at most half full): check full interface map
+                LLVM.PositionBuilderAtEnd(builder, typeHashCollisionBlock);
                 var inlineRuntimeTypeInfoType = LLVM.TypeOf(LLVM.GetParam(isInstInterfaceFunctionLLVM, 0));
                 var isInstInterfaceResult = LLVM.BuildCall(builder, isInstInterfaceFunctionLLVM, new[]
                 {
@@ -1023,15 +1110,16 @@ namespace SharpLang.CompilerServices
                     LLVM.BuildPointerCast(builder, @class.GeneratedEETypeTokenLLVM, inlineRuntimeTypeInfoType, string.Empty),
                 }, string.Empty);
 
-                LLVM.BuildCondBr(builder, isInstInterfaceResult, typeCheckDoneBlock, typeNotMatchBlock);
+                LLVM.BuildCondBr(builder, isInstInterfaceResult, typeCheckBlock, typeMismatchBlock);
 
-                typeCheckBlock = LLVM.GetInsertBlock(builder);
+                // Type matches
+                LLVM.PositionBuilderAtEnd(builder, typeCheckBlock);
+                LLVM.BuildBr(builder, typeCheckDoneBlock);
             }
             else
             {
-                // TODO: Probably better to rewrite this in C, but need to make sure depth will be inlined as constant
+                // Class hierarchy check (Cohen display): superTypeCount > Depth && superTypes[Depth] == @class
                 // Get super type count
-                // Get method stored in IMT slot
                 indices = new[]
                 {
                     LLVM.ConstInt(int32LLVM, 0, false), // Pointer indirection
@@ -1044,8 +1132,9 @@ namespace SharpLang.CompilerServices
                 var superTypeCount = LLVM.BuildInBoundsGEP(builder, rttiPointer, indices, string.Empty);
                 superTypeCount = LLVM.BuildLoad(builder, superTypeCount, string.Empty);
 
-                var depthCompareResult = LLVM.BuildICmp(builder, IntPredicate.IntSGE, superTypeCount, LLVM.ConstInt(int32LLVM, (ulong)@class.Depth, false), string.Empty);
-                LLVM.BuildCondBr(builder, depthCompareResult, typeCheckBlock, typeNotMatchBlock);
+                // Super types contains Depth + 1 entries (from System.Object to type itself)
+                var depthCompareResult = LLVM.BuildICmp(builder, IntPredicate.IntUGT, superTypeCount, LLVM.ConstInt(int32LLVM, (ulong)@class.Depth, false), string.Empty);
+                LLVM.BuildCondBr(builder, depthCompareResult, typeCheckBlock, typeMismatchBlock);
 
                 // Start new typeCheckBlock
                 LLVM.PositionBuilderAtEnd(builder, typeCheckBlock);
@@ -1073,7 +1162,29 @@ namespace SharpLang.CompilerServices
 
                 // Compare super type in array at given depth with expected one
                 var typeCompareResult = LLVM.BuildICmp(builder, IntPredicate.IntEQ, superType, LLVM.ConstPointerCast(@class.GeneratedEETypeRuntimeLLVM, intPtrLLVM), string.Empty);
-                LLVM.BuildCondBr(builder, typeCompareResult, typeCheckDoneBlock, typeNotMatchBlock);
+                LLVM.BuildCondBr(builder, typeCompareResult, typeCheckDoneBlock, typeMismatchBlock);
+            }
+
+            // Runtime check (results are cached by runtime)
+            var runtimeTypeMatchBlock = default(BasicBlockRef);
+            var runtimeCastedPointerObject = default(ValueRef);
+            if (needsRuntimeCastCheck)
+            {
+                LLVM.PositionBuilderAtEnd(builder, typeMismatchBlock);
+                var runtimeTypeInfoType = LLVM.TypeOf(LLVM.GetParam(canCastToFunctionLLVM, 0));
+                var canCastToResult = LLVM.BuildCall(builder, canCastToFunctionLLVM, new[]
+                {
+                    LLVM.BuildPointerCast(builder, rttiPointer, runtimeTypeInfoType, string.Empty),
+                    LLVM.BuildPointerCast(builder, @class.GeneratedEETypeTokenLLVM, runtimeTypeInfoType, string.Empty),
+                }, string.Empty);
+
+                runtimeTypeMatchBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, string.Format("L_{0:x4}_type_runtime_match", instructionOffset));
+                LLVM.MoveBasicBlockAfter(runtimeTypeMatchBlock, typeMismatchBlock);
+                LLVM.BuildCondBr(builder, canCastToResult, runtimeTypeMatchBlock, typeNotMatchBlock);
+
+                LLVM.PositionBuilderAtEnd(builder, runtimeTypeMatchBlock);
+                runtimeCastedPointerObject = LLVM.BuildPointerCast(builder, obj.Value, castedPointerType, string.Empty);
+                LLVM.BuildBr(builder, typeCheckDoneBlock);
             }
 
             // Start new typeNotMatchBlock: set object to null and jump to typeCheckDoneBlock
@@ -1112,6 +1223,8 @@ namespace SharpLang.CompilerServices
                     new[] {castedPointerObject, LLVM.ConstPointerNull(castedPointerType)},
                     new[] {typeCheckBlock, typeNotMatchBlock});
             }
+            if (needsRuntimeCastCheck)
+                LLVM.AddIncoming(mergedVariable, new[] { runtimeCastedPointerObject }, new[] { runtimeTypeMatchBlock });
             stack.Add(new StackValue(obj.StackType, @class.Type, mergedVariable));
         }
 
@@ -1733,6 +1846,8 @@ namespace SharpLang.CompilerServices
             // Store value at address
             var pointerCast = LLVM.BuildPointerCast(builder, address.Value, LLVM.PointerType(LLVM.TypeOf(sourceValue), 0), string.Empty);
             StoreValue(type.StackType, sourceValue, pointerCast, functionContext.InstructionFlags);
+            if (opcode == Code.Stind_Ref)
+                EmitWriteBarrier(type, pointerCast);
             functionContext.InstructionFlags = InstructionFlags.None;
         }
 
@@ -604,6 +604,10 @@ namespace SharpLang.CompilerServices
 
             PrepareScopes(functionContext, function);
 
+            // Recursion needs a safe point poll as well (leaf methods can't recurse)
+            if (body.Instructions.Any(x => x.OpCode.FlowControl == FlowControl.Call))
+                EmitSafepointPoll(functionContext);
+
             foreach (var instruction in body.Instructions)
             {
                 try
@@ -620,6 +624,10 @@ namespace SharpLang.CompilerServices
                     // Reset states
                     functionContext.FlowingNextInstructionMode = FlowingNextInstructionMode.Implicit;
 
+                    // Loops need a safe point poll, so that suspending threads (i.e. for GC) doesn't wait for them to end
+                    if (IsBackwardBranch(instruction))
+                        EmitSafepointPoll(functionContext);
+
                     EmitInstruction(functionContext, instruction);
 
                     // If we do a jump, let's merge stack
@@ -880,6 +888,10 @@ namespace SharpLang.CompilerServices
                     var targetMethodReference = ResolveGenericsVisitor.Process(methodReference, (MethodReference)instruction.Operand);
                     var targetMethod = GetFunction(targetMethodReference);
 
+                    // Atomics and memory barriers are emitted inline
+                    if (TryEmitIntrinsic(functionContext, targetMethod))
+                        break;
+
                     // If calling a static method, make sure .cctor has been called
                     if (!targetMethodReference.HasThis)
                         EnsureClassInitialized(functionContext, GetClass(targetMethod.DeclaringType));
@@ -1940,6 +1952,58 @@ namespace SharpLang.CompilerServices
                         // Cast to object type (enough to have IMT)
                         rttiPointer = LLVM.BuildPointerCast(builder, rttiPointer, LLVM.TypeOf(GetClass(@object).GeneratedEETypeRuntimeLLVM), string.Empty);
 
+                        // Call site inline cache (EEType => target), only filled by runtime
+                        var interfaceCallCache = LLVM.AddGlobal(module, interfaceCallCacheLLVM, "interface_call_cache");
+                        LLVM.SetLinkage(interfaceCallCache, Linkage.PrivateLinkage);
+                        LLVM.SetInitializer(interfaceCallCache, LLVM.ConstNull(interfaceCallCacheLLVM));
+
+                        var functionGlobal = functionContext.FunctionGlobal;
+                        var cacheHitBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, "icache.hit");
+                        var cacheMissBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, "icache.miss");
+                        var nextBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, string.Empty);
+
+                        LLVM.MoveBasicBlockAfter(cacheHitBlock, LLVM.GetInsertBlock(builder));
+                        LLVM.MoveBasicBlockAfter(cacheMissBlock, cacheHitBlock);
+                        LLVM.MoveBasicBlockAfter(nextBlock, cacheMissBlock);
+
+                        // Check first cache entry inline
+                        var eeType = LLVM.BuildPointerCast(builder, rttiPointer, intPtrLLVM, string.Empty);
+                        var cachedEEType = LLVM.BuildLoad(builder, LLVM.BuildInBoundsGEP(builder, interfaceCallCache, new[]
+                        {
+                            LLVM.ConstInt(int32LLVM, 0, false), // Pointer indirection
+                            LLVM.ConstInt(int32LLVM, 0, false), // Access eeTypes
+                            LLVM.ConstInt(int32LLVM, 0, false), // First entry
+                        }, string.Empty), string.Empty);
+
+                        // Acquire, so that target (written by runtime before publishing eeType) is visible on hit
+                        LLVM.SetAtomicOrdering(cachedEEType, AtomicOrdering.AtomicOrderingAcquire);
+                        LLVM.SetAlignment(cachedEEType, LLVM.ABIAlignmentOfType(targetData, intPtrLLVM));
+                        var cacheHit = LLVM.BuildICmp(builder, IntPredicate.IntEQ, cachedEEType, eeType, string.Empty);
+                        LLVM.BuildCondBr(builder, cacheHit, cacheHitBlock, cacheMissBlock);
+
+                        // Cache hit: use cached target
+                        LLVM.PositionBuilderAtEnd(builder, cacheHitBlock);
+                        var cachedTarget = LLVM.BuildLoad(builder, LLVM.BuildInBoundsGEP(builder, interfaceCallCache, new[]
+                        {
+                            LLVM.ConstInt(int32LLVM, 0, false), // Pointer indirection
+                            LLVM.ConstInt(int32LLVM, 1, false), // Access targets
+                            LLVM.ConstInt(int32LLVM, 0, false), // First entry
+                        }, string.Empty), string.Empty);
+
+                        if (InterfaceCallCacheStats)
+                        {
+                            var inlineHits = LLVM.BuildInBoundsGEP(builder, interfaceCallCache, new[]
+                            {
+                                LLVM.ConstInt(int32LLVM, 0, false), // Pointer indirection
+                                LLVM.ConstInt(int32LLVM, 5, false), // Access inlineHits
+                            }, string.Empty);
+                            LLVM.BuildAtomicRMW(builder, AtomicRMWBinOp.AtomicRMWBinOpAdd, inlineHits, LLVM.ConstInt(int32LLVM, 1, false), AtomicOrdering.AtomicOrderingMonotonic, false);
+                        }
+                        LLVM.BuildBr(builder, nextBlock);
+
+                        // Cache miss: check other entries, or resolve using IMT (and fill cache)
+                        LLVM.PositionBuilderAtEnd(builder, cacheMissBlock);
+
                         // Get method stored in IMT slot
                         indices = new[]
                         {
@@ -1952,14 +2016,62 @@ namespace SharpLang.CompilerServices
 
                         var methodPointer = LLVM.BuildLoad(builder, imtEntry, string.Empty);
 
-                        // Resolve interface call
-                        // TODO: Improve resolveInterfaceCall(): if no match is found, it's likely due to covariance/contravariance, so we will need a fallback
-                        resolvedMethod = LLVM.BuildCall(builder, resolveInterfaceCallFunctionLLVM, new[]
+                        // Receivers of invariant interfaces implement this exact interface, so a single IMT entry is the target
+                        // (generic method instantiations are never in IMT)
+                        var interfaceMethodIndex = GetInterfaceMethodIndex(targetMethod.MethodReference);
+                        var singleImtEntryIsTarget = interfaceMethodIndex >= 0 && GetGenericVariance(GetClass(targetMethod.DeclaringType)) == 0;
+                        var imtDirectBlock = default(BasicBlockRef);
+                        if (singleImtEntryIsTarget)
+                        {
+                            imtDirectBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, "icache.imt");
+                            var resolveBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, "icache.resolve");
+                            LLVM.MoveBasicBlockAfter(imtDirectBlock, cacheMissBlock);
+                            LLVM.MoveBasicBlockAfter(resolveBlock, imtDirectBlock);
+
+                            // Once cache is full, runtime won't fill it anymore: take single IMT entries directly, as if there was no cache
+                            var lastCachedEEType = LLVM.BuildLoad(builder, LLVM.BuildInBoundsGEP(builder, interfaceCallCache, new[]
+                            {
+                                LLVM.ConstInt(int32LLVM, 0, false), // Pointer indirection
+                                LLVM.ConstInt(int32LLVM, 0, false), // Access eeTypes
+                                LLVM.ConstInt(int32LLVM, (ulong)(InterfaceCallCacheSize - 1), false), // Last entry
+                            }, string.Empty), string.Empty);
+                            LLVM.SetAtomicOrdering(lastCachedEEType, AtomicOrdering.AtomicOrderingMonotonic);
+                            LLVM.SetAlignment(lastCachedEEType, LLVM.ABIAlignmentOfType(targetData, intPtrLLVM));
+
+                            var cacheFull = LLVM.BuildICmp(builder, IntPredicate.IntNE, lastCachedEEType, LLVM.ConstNull(intPtrLLVM), string.Empty);
+                            var singleEntry = LLVM.BuildAnd(builder,
+                                LLVM.BuildICmp(builder, IntPredicate.IntNE, methodPointer, LLVM.ConstNull(intPtrLLVM), string.Empty),
+                                LLVM.BuildICmp(builder, IntPredicate.IntEQ, LLVM.BuildAnd(builder, methodPointer, LLVM.ConstInt(intPtrLLVM, 1, false), string.Empty), LLVM.ConstNull(intPtrLLVM), string.Empty),
+                                string.Empty);
+                            LLVM.BuildCondBr(builder, LLVM.BuildAnd(builder, cacheFull, singleEntry, string.Empty), imtDirectBlock, resolveBlock);
+
+                            LLVM.PositionBuilderAtEnd(builder, imtDirectBlock);
+                            LLVM.BuildBr(builder, nextBlock);
+
+                            LLVM.PositionBuilderAtEnd(builder, resolveBlock);
+                            cacheMissBlock = resolveBlock;
+                        }
+
+                        // Resolve interface call (runtime falls back to dispatch tables if not found in IMT, i.e. variance)
+                        var resolvedTarget = LLVM.BuildCall(builder, resolveInterfaceCallCachedFunctionLLVM, new[]
                         {
-                            //LLVM.ConstInt(int32LLVM, methodId, false),
+                            LLVM.BuildPointerCast(builder, interfaceCallCache, LLVM.TypeOf(LLVM.GetParam(resolveInterfaceCallCachedFunctionLLVM, 0)), string.Empty),
+                            LLVM.BuildPointerCast(builder, eeType, LLVM.TypeOf(LLVM.GetParam(resolveInterfaceCallCachedFunctionLLVM, 1)), string.Empty),
                             LLVM.ConstPointerCast(targetMethod.GeneratedValue, intPtrLLVM),
                             methodPointer,
+                            LLVM.BuildPointerCast(builder, GetClass(targetMethod.DeclaringType).GeneratedEETypeTokenLLVM, LLVM.TypeOf(LLVM.GetParam(resolveInterfaceCallCachedFunctionLLVM, 4)), string.Empty),
+                            LLVM.ConstInt(int32LLVM, (ulong)interfaceMethodIndex, true),
                         }, string.Empty);
+                        LLVM.BuildBr(builder, nextBlock);
+
+                        LLVM.PositionBuilderAtEnd(builder, nextBlock);
+                        functionContext.BasicBlock = nextBlock;
+
+                        resolvedMethod = LLVM.BuildPhi(builder, intPtrLLVM, string.Empty);
+                        LLVM.AddIncoming(resolvedMethod, new[] { cachedTarget, resolvedTarget }, new[] { cacheHitBlock, cacheMissBlock });
+                        if (singleImtEntryIsTarget)
+                            LLVM.AddIncoming(resolvedMethod, new[] { methodPointer }, new[] { imtDirectBlock });
+
                         resolvedMethod = LLVM.BuildPointerCast(builder, resolvedMethod,
                             LLVM.PointerType(targetMethod.FunctionType, 0), string.Empty);
                     }
@@ -2103,6 +2215,73 @@ namespace SharpLang.CompilerServices
             return dataPointer;
         }
 
+        /// <summary>
+        /// Determines whether the instruction is a branch with a target at or before itself (i.e. a loop back-edge).
+        /// </summary>
+        /// <param name="instruction">The instruction.</param>
+        private static bool IsBackwardBranch(Instruction instruction)
+        {
+            var flowControl = instruction.OpCode.FlowControl;
+            if (flowControl != FlowControl.Cond_Branch && flowControl != FlowControl.Branch)
+                return false;
+
+            var targets = instruction.Operand is Instruction[] ? (Instruction[])instruction.Operand : new[] { (Instruction)instruction.Operand };
+            return targets.Any(target => target.Offset <= instruction.Offset);
+        }
+
+        /// <summary>
+        /// Emits a safe point poll: if threads are being suspended (i.e. by GC), current thread stops there until they are resumed.
+        /// </summary>
+        /// <param name="functionContext">The function context.</param>
+        private void EmitSafepointPoll(FunctionCompilerContext functionContext)
+        {
+            switch (SafepointMode)
+            {
+                case SafepointMode.None:
+                    break;
+                case SafepointMode.Flag:
+                {
+                    // if (safepointPollFlag != 0)
+                    //     safepointPoll();
+                    var pollFlag = LLVM.BuildLoad(builder, safepointPollFlagLLVM, string.Empty);
+                    LLVM.SetVolatile(pollFlag, true);
+
+                    // Poll is rarely needed
+                    var expectIntrinsic = LLVM.IntrinsicGetDeclaration(module, (uint)Intrinsics.expect, new[] { int32LLVM });
+                    pollFlag = LLVM.BuildCall(builder, expectIntrinsic, new[] { pollFlag, LLVM.ConstInt(int32LLVM, 0, false) }, string.Empty);
+                    var pollRequested = LLVM.BuildICmp(builder, IntPredicate.IntNE, pollFlag, LLVM.ConstInt(int32LLVM, 0, false), string.Empty);
+
+                    var functionGlobal = functionContext.FunctionGlobal;
+                    var pollBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, "safepoint.poll");
+                    var nextBlock = LLVM.AppendBasicBlockInContext(context, functionGlobal, string.Empty);
+
+                    LLVM.MoveBasicBlockAfter(pollBlock, LLVM.GetInsertBlock(builder));
+                    LLVM.MoveBasicBlockAfter(nextBlock, pollBlock);
+
+                    LLVM.BuildCondBr(builder, pollRequested, pollBlock, nextBlock);
+
+                    LLVM.PositionBuilderAtEnd(builder, pollBlock);
+                    LLVM.BuildCall(builder, safepointPollFunctionLLVM, new ValueRef[0], string.Empty);
+                    LLVM.BuildBr(builder, nextBlock);
+
+                    // Normal path
+                    LLVM.PositionBuilderAtEnd(builder, nextBlock);
+                    functionContext.BasicBlock = nextBlock;
+                    break;
+                }
+                case SafepointMode.GuardPage:
+                {
+                    // Runtime makes poll page unreadable while threads are being suspended, and handles the fault as a safe point
+                    var pollPage = LLVM.BuildLoad(builder, safepointPollPageLLVM, string.Empty);
+                    var pollRead = LLVM.BuildLoad(builder, pollPage, string.Empty);
+                    LLVM.SetVolatile(pollRead, true);
+                    break;
+                }
+                default:
+                    throw new ArgumentOutOfRangeException();
+            }
+        }
+
         /// <summary>
         /// Merges all the stacks of this instruction targets.
         /// </summary>
@@ -0,0 +1,254 @@
+﻿using System.Threading;
+using SharpLLVM;
+
+namespace SharpLang.CompilerServices
+{
+    public partial class Compiler
+    {
+        /// <summary>
+        /// Emits methods that map directly to LLVM instructions (Interlocked, Volatile and memory barriers) inline, instead of calling them.
+        /// </summary>
+        /// <param name="functionContext">The function context.</param>
+        /// <param name="targetMethod">The called method.</param>
+        /// <returns>True if instructions were emitted, false if method should be called normally.</returns>
+        private bool TryEmitIntrinsic(FunctionCompilerContext functionContext, Function targetMethod)
+        {
+            var declaringType = targetMethod.MethodReference.DeclaringType.FullName;
+            var methodName = targetMethod.MethodReference.Name;
+
+            if (declaringType == typeof(Interlocked).FullName)
+            {
+                switch (methodName)
+                {
+                    case "Exchange":
+                        return TryEmitAtomicRMW(functionContext, targetMethod, AtomicRMWBinOp.AtomicRMWBinOpXchg, 0, false);
+                    case "ExchangeAdd":
+                        return TryEmitAtomicRMW(functionContext, targetMethod, AtomicRMWBinOp.AtomicRMWBinOpAdd, 0, false);
+                    case "Add":
+                        return TryEmitAtomicRMW(functionContext, targetMethod, AtomicRMWBinOp.AtomicRMWBinOpAdd, 0, true);
+                    case "Increment":
+                        return TryEmitAtomicRMW(functionContext, targetMethod, AtomicRMWBinOp.AtomicRMWBinOpAdd, 1, true);
+                    case "Decrement":
+                        return TryEmitAtomicRMW(functionContext, targetMethod, AtomicRMWBinOp.AtomicRMWBinOpAdd, -1, true);
+                    case "CompareExchange":
+                        return TryEmitCompareExchange(functionContext, targetMethod);
+                    case "Read":
+                        return TryEmitAtomicLoad(functionContext, targetMethod, AtomicOrdering.AtomicOrderingSequentiallyConsistent);
+                    case "MemoryBarrier":
+                        LLVM.BuildFence(builder, AtomicOrdering.AtomicOrderingSequentiallyConsistent, false, string.Empty);
+                        return true;
+                }
+            }
+            else if (declaringType == typeof(Volatile).FullName)
+            {
+                switch (methodName)
+                {
+                    case "Read":
+                        return TryEmitAtomicLoad(functionContext, targetMethod, AtomicOrdering.AtomicOrderingAcquire);
+                    case "Write":
+                        return TryEmitAtomicStore(functionContext, targetMethod, AtomicOrdering.AtomicOrderingRelease);
+                }
+            }
+            else if (declaringType == typeof(Thread).FullName && methodName == "MemoryBarrier")
+            {
+                LLVM.BuildFence(builder, AtomicOrdering.AtomicOrderingSequentiallyConsistent, false, string.Empty);
+                return true;
+            }
+
+            return false;
+        }
+
+        /// <summary>
+        /// Gets the integer type used to access a value of the given type atomically (LLVM atomics only work on integers).
+        /// </summary>
+        /// <param name="valueType">LLVM type of the value.</param>
+        /// <returns>The integer type, or TypeRef.Empty if value can't be accessed atomically.</returns>
+        private TypeRef GetAtomicIntegerType(TypeRef valueType)
+        {
+            switch (LLVM.GetTypeKind(valueType))
+            {
+                case TypeKind.IntegerTypeKind:
+                    return valueType;
+                case TypeKind.PointerTypeKind:
+                    return nativeIntLLVM;
+                case TypeKind.FloatTypeKind:
+                    return int32LLVM;
+                case TypeKind.DoubleTypeKind:
+                    return int64LLVM;
+                default:
+                    return TypeRef.Empty;
+            }
+        }
+
+        private ValueRef ConvertToAtomicInteger(ValueRef value, TypeRef integerType)
+        {
+            var valueType = LLVM.TypeOf(value);
+            if (valueType == integerType)
+                return value;
+
+            if (LLVM.GetTypeKind(valueType) == TypeKind.PointerTypeKind)
+                return LLVM.BuildPtrToInt(builder, value, integerType, string.Empty);
+
+            return LLVM.BuildBitCast(builder, value, integerType, string.Empty);
+        }
+
+        private ValueRef ConvertFromAtomicInteger(ValueRef value, TypeRef valueType)
+        {
+            if (LLVM.TypeOf(value) == valueType)
+                return value;
+
+            if (LLVM.GetTypeKind(valueType) == TypeKind.PointerTypeKind)
+                return LLVM.BuildIntToPtr(builder, value, valueType, string.Empty);
+
+            return LLVM.BuildBitCast(builder, value, valueType, string.Empty);
+        }
+
+        /// <summary>
+        /// Pops intrinsic arguments from the stack, converted to their parameter types.
+        /// </summary>
+        private ValueRef[] PopIntrinsicArguments(FunctionCompilerContext functionContext, Function targetMethod)
+        {
+            var stack = functionContext.Stack;
+            var parameterTypes = targetMethod.Signature.ParameterTypes;
+
+            var args = new ValueRef[parameterTypes.Length];
+            for (int index = 0; index < parameterTypes.Length; index++)
+                args[index] = ConvertFromStackToLocal(parameterTypes[index].Type, stack[stack.Count - parameterTypes.Length + index]);
+
+            stack.RemoveRange(stack.Count - parameterTypes.Length, parameterTypes.Length);
+
+            return args;
+        }
+
+        private void PushIntrinsicResult(FunctionCompilerContext functionContext, Function targetMethod, ValueRef result)
+        {
+            var returnType = targetMethod.Signature.ReturnType.Type;
+            functionContext.Stack.Add(new StackValue(returnType.StackType, returnType, ConvertFromLocalToStack(returnType, result)));
+        }
+
+        /// <summary>
+        /// Checks that first parameter is a reference to a value that can be accessed atomically, and returns its integer type.
+        /// </summary>
+        private TypeRef GetIntrinsicLocationType(Function targetMethod)
+        {
+            var parameterTypes = targetMethod.Signature.ParameterTypes;
+            if (parameterTypes.Length == 0 || LLVM.GetTypeKind(parameterTypes[0].Type.DefaultTypeLLVM) != TypeKind.PointerTypeKind)
+                return TypeRef.Empty;
+
+            var valueType = LLVM.GetElementType(parameterTypes[0].Type.DefaultTypeLLVM);
+            if (LLVM.GetTypeKind(valueType) == TypeKind.StructTypeKind)
+                return TypeRef.Empty;
+
+            return GetAtomicIntegerType(valueType);
+        }
+
+        private ValueRef GetAtomicLocation(ValueRef location, TypeRef integerType)
+        {
+            return LLVM.BuildPointerCast(builder, location, LLVM.PointerType(integerType, 0), string.Empty);
+        }
+
+        /// <summary>
+        /// Exchange, ExchangeAdd, Add, Increment and Decrement.
+        /// </summary>
+        /// <param name="functionContext">The function context.</param>
+        /// <param name="targetMethod">The called method.</param>
+        /// <param name="operation">The atomic operation.</param>
+        /// <param name="constantOperand">Operand if method doesn't take one (Increment and Decrement).</param>
+        /// <param name="returnNewValue">If true, returns value after the operation instead of before.</param>
+        private bool TryEmitAtomicRMW(FunctionCompilerContext functionContext, Function targetMethod, AtomicRMWBinOp operation, int constantOperand, bool returnNewValue)
+        {
+            var parameterTypes = targetMethod.Signature.ParameterTypes;
+            var integerType = GetIntrinsicLocationType(targetMethod);
+            if (integerType == TypeRef.Empty || parameterTypes.Length > 2)
+                return false;
+
+            var valueType = LLVM.GetElementType(parameterTypes[0].Type.DefaultTypeLLVM);
+            var args = PopIntrinsicArguments(functionContext, targetMethod);
+
+            var location = GetAtomicLocation(args[0], integerType);
+            var operand = args.Length > 1
+                ? ConvertToAtomicInteger(args[1], integerType)
+                : LLVM.ConstInt(integerType, unchecked((ulong)constantOperand), true);
+
+            var result = LLVM.BuildAtomicRMW(builder, operation, location, operand, AtomicOrdering.AtomicOrderingSequentiallyConsistent, false);
+            if (returnNewValue)
+                result = LLVM.BuildAdd(builder, result, operand, string.Empty);
+
+            // Exchange might store an object
+            if (args.Length > 1)
+                EmitWriteBarrier(parameterTypes[1].Type, args[0]);
+
+            PushIntrinsicResult(functionContext, targetMethod, ConvertFromAtomicInteger(result, valueType));
+            return true;
+        }
+
+        /// <summary>
+        /// CompareExchange(ref location, value, comparand), and its variant returning success in a ref bool.
+        /// </summary>
+        private bool TryEmitCompareExchange(FunctionCompilerContext functionContext, Function targetMethod)
+        {
+            var parameterTypes = targetMethod.Signature.ParameterTypes;
+            var integerType = GetIntrinsicLocationType(targetMethod);
+            if (integerType == TypeRef.Empty || parameterTypes.Length < 3)
+                return false;
+
+            var valueType = LLVM.GetElementType(parameterTypes[0].Type.DefaultTypeLLVM);
+            var args = PopIntrinsicArguments(functionContext, targetMethod);
+
+            var location = GetAtomicLocation(args[0], integerType);
+            var value = ConvertToAtomicInteger(args[1], integerType);
+            var comparand = ConvertToAtomicInteger(args[2], integerType);
+
+            var compareExchange = LLVM.BuildAtomicCompareExchange(builder, location, comparand, value,
+                AtomicOrdering.AtomicOrderingSequentiallyConsistent, AtomicOrdering.AtomicOrderingSequentiallyConsistent, false);
+            var result = LLVM.BuildExtractValue(builder, compareExchange, 0, string.Empty);
+
+            if (args.Length > 3)
+            {
+                var succeeded = LLVM.BuildExtractValue(builder, compareExchange, 1, string.Empty);
+                var succeededType = LLVM.GetElementType(LLVM.TypeOf(args[3]));
+                LLVM.BuildStore(builder, LLVM.BuildZExt(builder, succeeded, succeededType, string.Empty), args[3]);
+            }
+
+            EmitWriteBarrier(parameterTypes[1].Type, args[0]);
+
+            PushIntrinsicResult(functionContext, targetMethod, ConvertFromAtomicInteger(result, valueType));
+            return true;
+        }
+
+        private bool TryEmitAtomicLoad(FunctionCompilerContext functionContext, Function targetMethod, AtomicOrdering ordering)
+        {
+            var integerType = GetIntrinsicLocationType(targetMethod);
+            if (integerType == TypeRef.Empty || targetMethod.Signature.ParameterTypes.Length != 1)
+                return false;
+
+            var valueType = LLVM.GetElementType(targetMethod.Signature.ParameterTypes[0].Type.DefaultTypeLLVM);
+            var args = PopIntrinsicArguments(functionContext, targetMethod);
+
+            var load = LLVM.BuildLoad(builder, GetAtomicLocation(args[0], integerType), string.Empty);
+            LLVM.SetAtomicOrdering(load, ordering);
+            LLVM.SetAlignment(load, LLVM.ABIAlignmentOfType(targetData, integerType));
+
+            PushIntrinsicResult(functionContext, targetMethod, ConvertFromAtomicInteger(load, valueType));
+            return true;
+        }
+
+        private bool TryEmitAtomicStore(FunctionCompilerContext functionContext, Function targetMethod, AtomicOrdering ordering)
+        {
+            var parameterTypes = targetMethod.Signature.ParameterTypes;
+            var integerType = GetIntrinsicLocationType(targetMethod);
+            if (integerType == TypeRef.Empty || parameterTypes.Length != 2)
+                return false;
+
+            var args = PopIntrinsicArguments(functionContext, targetMethod);
+
+            var store = LLVM.BuildStore(builder, ConvertToAtomicInteger(args[1], integerType), GetAtomicLocation(args[0], integerType));
+            LLVM.SetAtomicOrdering(store, ordering);
+            LLVM.SetAlignment(store, LLVM.ABIAlignmentOfType(targetData, integerType));
+
+            EmitWriteBarrier(parameterTypes[1].Type, args[0]);
+
+            return true;
+        }
+    }
+}
@@ -4,6 +4,8 @@
     {
         private bool charUsesUtf8 = false;
         private bool stringSliceable = false;
+        private SafepointMode safepointMode = SafepointMode.Flag;
+        private bool interfaceCallCacheStats = false;
 
         /// <summary>
         /// Gets or sets a value indicating whether char and string types uses UTF8 or UTF16.
@@ -22,5 +24,29 @@
             get { return stringSliceable; }
             set { stringSliceable = value; }
         }
+
+        /// <summary>
+        /// Gets or sets how safe point polls are emitted at loop back-edges and method prologs.
+        /// </summary>
+        /// <value>
+        /// The safe point poll mode.
+        /// </value>
+        public SafepointMode SafepointMode
+        {
+            get { return safepointMode; }
+            set { safepointMode = value; }
+        }
+
+        /// <summary>
+        /// Gets or sets a value indicating whether interface call sites count hits of their first inline cache entry.
+        /// </summary>
+        /// <value>
+        ///   <c>true</c> if generated code atomically increments a counter on each inline cache hit; otherwise, <c>false</c>.
+        /// </value>
+        public bool InterfaceCallCacheStats
+        {
+            get { return interfaceCallCacheStats; }
+            set { interfaceCallCacheStats = value; }
+        }
     }
 }
\ No newline at end of file
@@ -315,11 +315,11 @@ namespace SharpLang.CompilerServices
                 // Special cases: Array
                 if (typeReference.MetadataType == MetadataType.Array)
                 {
-                    // String: length (native int) + first element pointer
+                    // Array: length (native int) + elements stored inline (zero-sized, so that object size is the header size)
                     var arrayType = (ArrayType)typeReference;
                     var elementType = GetType(arrayType.ElementType, TypeState.StackComplete);
                     fieldTypes.Add(intPtrLLVM);
-                    fieldTypes.Add(LLVM.PointerType(elementType.DefaultTypeLLVM, 0));
+                    fieldTypes.Add(LLVM.ArrayType(elementType.DefaultTypeLLVM, 0));
                 }
                 else
                 {
@@ -52,6 +52,9 @@ namespace SharpLang.CompilerServices
 
         private Dictionary<Mono.Cecil.ModuleDefinition, ValueRef> metadataPerModule;
 
+        /// <summary> String literal to slot global mapping (slots are registered in the runtime intern table at module initialization). </summary>
+        private Dictionary<string, ValueRef> stringLiterals = new Dictionary<string, ValueRef>();
+
         private IABI abi;
 
         /// <summary> True when running unit tests. This will try to avoid using real mscorlib for faster codegen, linking and testing. </summary>
@@ -203,6 +206,10 @@ namespace SharpLang.CompilerServices
             LLVM.SetLinkage(globalCtor, Linkage.PrivateLinkage);
             LLVM.PositionBuilderAtEnd(builder, LLVM.AppendBasicBlockInContext(context, globalCtor, string.Empty));
 
+            // Runtime only makes the poll page unreadable during suspensions if a loaded module polls it
+            if (SafepointMode == SafepointMode.GuardPage)
+                LLVM.BuildCall(builder, enableSafepointGuardPageFunctionLLVM, new ValueRef[0], string.Empty);
+
             Function entryPoint = null;
             if (assembly.EntryPoint != null)
                 functions.TryGetValue(assembly.EntryPoint, out entryPoint);
@@ -281,6 +288,21 @@ namespace SharpLang.CompilerServices
                 functionContext.Stack.Add(new StackValue(StackValueType.Int32, int32, LLVM.ConstInt(int32LLVM, (ulong)typesToRegister.Count, false)));
                 EmitCall(functionContext, registerTypesMethod.Signature, registerTypesMethod.GeneratedValue);
 
+                // Register string literal slots in runtime intern table (no literal should be emitted after this point)
+                if (stringLiterals.Count > 0)
+                {
+                    var stringLiteralSlots = stringLiterals.Values.Select(x => LLVM.ConstPointerCast(x, intPtrLLVM)).ToArray();
+                    var stringLiteralSlotsGlobal = LLVM.AddGlobal(module, LLVM.ArrayType(intPtrLLVM, (uint)stringLiteralSlots.Length), ".stringrefs");
+                    LLVM.SetInitializer(stringLiteralSlotsGlobal, LLVM.ConstArray(intPtrLLVM, stringLiteralSlots));
+                    LLVM.SetLinkage(stringLiteralSlotsGlobal, Linkage.PrivateLinkage);
+
+                    LLVM.BuildCall(builder, registerStringLiteralsFunctionLLVM, new[]
+                    {
+                        LLVM.BuildPointerCast(builder, stringLiteralSlotsGlobal, LLVM.TypeOf(LLVM.GetParam(registerStringLiteralsFunctionLLVM, 0)), string.Empty),
+                        LLVM.ConstInt(int32LLVM, (ulong)stringLiteralSlots.Length, false),
+                    }, string.Empty);
+                }
+
                 // Register unmanaged delegate callbacks
                 var delegateWrappers = assembly.MainModule.GetType("DelegateWrappers");
                 if (delegateWrappers != null)
@@ -21,6 +21,7 @@ namespace SharpLang.CompilerServices
         {
             LLC = "llc";
             Clang = "clang++";
+            SafepointMode = SafepointMode.Flag;
         }
 
         /// <summary>
@@ -39,6 +40,22 @@ namespace SharpLang.CompilerServices
         /// </value>
         public static string Clang { get; set; }
 
+        /// <summary>
+        /// Gets or sets how safe point polls are emitted in compiled code.
+        /// </summary>
+        /// <value>
+        /// The safe point poll mode.
+        /// </value>
+        public static SafepointMode SafepointMode { get; set; }
+
+        /// <summary>
+        /// Gets or sets a value indicating whether interface call sites count their inline cache hits.
+        /// </summary>
+        /// <value>
+        ///   <c>true</c> to count inline cache hits; otherwise, <c>false</c>.
+        /// </value>
+        public static bool InterfaceCallCacheStats { get; set; }
+
         public static string GetDefaultTriple()
         {
             return LLVM.GetDefaultTargetTriple().Replace("msvc", "gnu");
@@ -55,6 +72,8 @@ namespace SharpLang.CompilerServices
 
             var compiler = new Compiler(triple);
             compiler.TestMode = additionalTypes != null;
+            compiler.SafepointMode = SafepointMode;
+            compiler.InterfaceCallCacheStats = InterfaceCallCacheStats;
             compiler.PrepareAssembly(assemblyDefinition);
 
             if (additionalTypes != null)
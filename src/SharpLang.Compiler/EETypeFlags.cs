@@ -0,0 +1,16 @@
+﻿// Copyright (c) 2014 SharpLang - Virgile Bello
+using System;
+
+namespace SharpLang.CompilerServices
+{
+    /// <summary>
+    /// Flags stored in RTTI (should match MethodTable::EETypeFlags in runtime).
+    /// </summary>
+    [Flags]
+    enum EETypeFlags : byte
+    {
+        None = 0,
+        HasFinalizer = 1,
+        IsValueType = 2,
+    }
+}
\ No newline at end of file
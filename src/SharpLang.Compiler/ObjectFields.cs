@@ -6,6 +6,7 @@ namespace SharpLang.CompilerServices
     enum ObjectFields
     {
         RuntimeTypeInfo = 0,
+        Header, // Hash code and lock state (see ObjectHeader.h in runtime)
         Data,
     }
 }
\ No newline at end of file
@@ -34,6 +34,8 @@ namespace SharpLang.CompilerServices
                     { "o|output=", "Output filename. Default to [inputfilename].bc", v => outputFile = v },
                     { "d", "Generate debug LLVM IR assembly output", v => generateIR = true },
                     { "target", "Choose target triple", v => target = v },
+                    { "safepoints=", "Safe point polls: none, flag (default) or guardpage", v => Driver.SafepointMode = (SafepointMode)Enum.Parse(typeof(SafepointMode), v, true) },
+                    { "icache-stats", "Count inline cache hits of interface call sites", v => Driver.InterfaceCallCacheStats = v != null },
                 };
 
             try
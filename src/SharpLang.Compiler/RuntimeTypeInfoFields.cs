@@ -11,6 +11,7 @@ namespace SharpLang.CompilerServices
         // There is no info past "Type".
         IsConcreteType,
         CorElementType,
+        GenericVariance, // Variance of generic parameters, 2 bits each (1: covariant, 2: contravariant)
 
         // Metadata/Reflection
         // TypeDef or GenericType
@@ -22,7 +23,7 @@ namespace SharpLang.CompilerServices
         Type,
 
         // Fields
-        GarbageCollectableFieldCount, // First fields in FieldDescriptions will be the one interesting for GC: instance fields of referencable types
+        GarbageCollectableFieldCount, // First fields in FieldDescriptions will be the one interesting for GC: instance fields of referencable types (arrays: references in one element)
         FieldCount,
         FieldDescriptions,
 
@@ -32,6 +33,8 @@ namespace SharpLang.CompilerServices
         SuperTypes,
         InterfaceMap,
         TypeInitialized,
+        Flags, // See EETypeFlags
+        InterfaceHashMask, // InterfaceMap is followed by a hash table of (InterfaceHashMask + 1) interfaces, indexed by interface id
         ObjectSize,
         ElementSize,
         
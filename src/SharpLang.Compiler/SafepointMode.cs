@@ -0,0 +1,24 @@
+namespace SharpLang.CompilerServices
+{
+    /// <summary>
+    /// Specifies how safe point polls are emitted at loop back-edges and method prologs,
+    /// so that threads running managed code can be suspended (i.e. by GC).
+    /// </summary>
+    public enum SafepointMode
+    {
+        /// <summary>
+        /// No poll is emitted (threads only reach safe points when they call into runtime).
+        /// </summary>
+        None = 0,
+
+        /// <summary>
+        /// Tests runtime poll flag, and calls runtime when it is set.
+        /// </summary>
+        Flag = 1,
+
+        /// <summary>
+        /// Reads a byte from runtime poll page, which becomes unreadable (and faults) while threads are being suspended.
+        /// </summary>
+        GuardPage = 2,
+    }
+}
@@ -14,6 +14,7 @@ namespace System
 
         public byte IsConcreteType;
         public CorElementType CorElementType;
+        public ushort GenericVariance;
 
         // Metadata
         public SharpLangEETypeDefinition TypeDefinition;
@@ -21,7 +22,7 @@ namespace System
         public IntPtr CachedTypeField;
 
         // Field infos
-        public ushort GarbageCollectableFieldCount; // First entries in FieldDescriptions will be for the GC: instance fields of referencable types
+        public ushort GarbageCollectableFieldCount; // First entries in FieldDescriptions will be for the GC: instance fields of referencable types (arrays: references in one element)
         public ushort FieldCount;
 
         public SharpLangFieldDescription* FieldDescriptions;
@@ -32,6 +33,8 @@ namespace System
         public SharpLangEEType** SuperTypes;
         public SharpLangEEType** InterfaceMap;
         public byte Initialized;
+        public byte Flags;
+        public ushort InterfaceHashMask;
         public uint ObjectSize;
         public uint ElementSize;
 
@@ -100,6 +103,11 @@ namespace System
             for (int fieldIndex = 0; fieldIndex < fieldCount; ++fieldIndex)
             {
                 var fieldDesc = &FieldDescriptions[fieldIndex];
+
+                // Skip GC entries for references embedded in value type fields
+                if (fieldDesc->FieldDefinitionHandle.IsNil)
+                    continue;
+
                 var field = module.MetadataReader.GetFieldDefinition(fieldDesc->FieldDefinitionHandle);
                 if (stringComparer.Equals(field.Name, name))
                 {
@@ -12,5 +12,22 @@ namespace System
 
         [MethodImpl(MethodImplOptions.InternalCall)]
         public static extern unsafe T UnsafeCast<T>(object value) where T : class;
+
+        /// <summary>
+        /// Collects counters of all interface call site caches resolved so far into a <see cref="InterfaceCallCacheStats"/>.
+        /// </summary>
+        [MethodImpl(MethodImplOptions.InternalCall)]
+        public extern static unsafe void GetInterfaceCallCacheStats(void* stats);
+    }
+
+    // Layout should match InterfaceCallCacheStats in RuntimeType.h
+    struct InterfaceCallCacheStats
+    {
+        public uint SiteCount;
+        public uint PolymorphicSiteCount;
+        public uint MegamorphicSiteCount;
+        public ulong Hits;
+        public ulong Misses;
+        public ulong InlineHits;
     }
 }
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <pthread.h>
+#endif
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include "RuntimeType.h"
+#include "Heap.h"
+#include "SpinLock.h"
+#include "AllocationProfiler.h"
+
+// Bytes allocated by a thread between two call stack samples (can be changed with COMPlus_AllocationProfileSampleKB)
+#define DEFAULT_SAMPLE_INTERVAL (512 * 1024)
+
+#define MAX_SAMPLE_FRAMES 32
+
+// SIGUSR1 and SIGUSR2 are used by PAL for thread suspension
+#if defined(SIGRTMIN)
+#define DUMP_SIGNAL (SIGRTMIN + 1)
+#elif defined(SIGINFO)
+#define DUMP_SIGNAL SIGINFO
+#endif
+
+// Needs to be a power of two
+#define INITIAL_TYPE_TABLE_SIZE 256
+
+// Defined in Exception.cpp
+uint32_t CaptureCallStack(uintptr_t* frames, uint32_t maxFrames);
+
+struct TypeAllocationStats
+{
+	EEType* eeType;
+	size_t objects;
+	size_t bytes;
+};
+
+// Each thread counts in its own open addressing table (keyed by EEType), so that common path doesn't need any lock.
+// Profiles are never freed, so that counts of exited threads are still reported.
+struct ThreadAllocationProfile
+{
+	ThreadAllocationProfile* next;
+
+	TypeAllocationStats* types;
+	size_t typeTableSize;
+	size_t typeCount;
+
+	// A call stack is sampled when it goes below zero
+	ptrdiff_t bytesUntilSample;
+};
+
+struct AllocationStack
+{
+	EEType* eeType;
+	uint32_t frameCount;
+	uintptr_t frames[MAX_SAMPLE_FRAMES];
+
+	bool operator==(const AllocationStack& other) const
+	{
+		return eeType == other.eeType
+			&& frameCount == other.frameCount
+			&& memcmp(frames, other.frames, sizeof(uintptr_t) * frameCount) == 0;
+	}
+};
+
+struct AllocationStackHash
+{
+	size_t operator()(const AllocationStack& stack) const
+	{
+		size_t hash = (size_t)stack.eeType;
+		for (uint32_t i = 0; i < stack.frameCount; ++i)
+			hash = hash * 31 + stack.frames[i];
+		return hash;
+	}
+};
+
+bool allocationProfilerEnabled;
+
+static const char* outputPath;
+static size_t sampleInterval = DEFAULT_SAMPLE_INTERVAL;
+
+// Protects thread profile list, type table resizing and sampled stacks
+static SpinLock profilerLock;
+static ThreadAllocationProfile* threadProfiles;
+static std::unordered_map<AllocationStack, size_t, AllocationStackHash> sampledStacks; // Value is number of samples
+
+static thread_local ThreadAllocationProfile* threadProfile;
+
+#ifdef DUMP_SIGNAL
+// Signal handler can't do I/O safely, it wakes up dump thread through this pipe instead
+static int dumpPipe[2];
+static struct sigaction previousDumpAction;
+#endif
+
+static inline size_t HashType(EEType* eeType)
+{
+	// EETypes are aligned, low bits carry no information
+	auto address = (uintptr_t)eeType;
+	return (size_t)((address >> 3) ^ (address >> 12));
+}
+
+static TypeAllocationStats* FindTypeStats(TypeAllocationStats* types, size_t typeTableSize, EEType* eeType)
+{
+	// Linear probing: returns matching entry, or empty entry where it should be inserted
+	auto mask = typeTableSize - 1;
+	for (auto index = HashType(eeType) & mask; ; index = (index + 1) & mask)
+	{
+		auto entry = &types[index];
+		if (entry->eeType == eeType || entry->eeType == NULL)
+			return entry;
+	}
+}
+
+static ThreadAllocationProfile* CreateThreadProfile()
+{
+	auto profile = (ThreadAllocationProfile*)calloc(1, sizeof(ThreadAllocationProfile));
+	auto types = (TypeAllocationStats*)calloc(INITIAL_TYPE_TABLE_SIZE, sizeof(TypeAllocationStats));
+	if (profile == NULL || types == NULL)
+		abort();
+
+	profile->types = types;
+	profile->typeTableSize = INITIAL_TYPE_TABLE_SIZE;
+	profile->bytesUntilSample = (ptrdiff_t)sampleInterval;
+
+	profilerLock.Enter();
+	profile->next = threadProfiles;
+	threadProfiles = profile;
+	profilerLock.Leave();
+
+	threadProfile = profile;
+	return profile;
+}
+
+static void GrowTypeTable(ThreadAllocationProfile* profile)
+{
+	auto typeTableSize = profile->typeTableSize * 2;
+	auto types = (TypeAllocationStats*)calloc(typeTableSize, sizeof(TypeAllocationStats));
+	if (types == NULL)
+		abort();
+
+	// Only current thread updates its table, so it can be copied without lock
+	for (size_t i = 0; i < profile->typeTableSize; ++i)
+	{
+		auto& entry = profile->types[i];
+		if (entry.eeType != NULL)
+			*FindTypeStats(types, typeTableSize, entry.eeType) = entry;
+	}
+
+	// Swap under lock, in case table is being dumped
+	profilerLock.Enter();
+	auto oldTypes = profile->types;
+	profile->types = types;
+	profile->typeTableSize = typeTableSize;
+	profilerLock.Leave();
+
+	free(oldTypes);
+}
+
+static void SampleAllocation(ThreadAllocationProfile* profile, EEType* eeType)
+{
+	// Big allocations might span several sample intervals
+	auto sampleCount = 1 + (size_t)(-profile->bytesUntilSample) / sampleInterval;
+	profile->bytesUntilSample += (ptrdiff_t)(sampleCount * sampleInterval);
+
+	AllocationStack stack;
+	stack.eeType = eeType;
+	stack.frameCount = CaptureCallStack(stack.frames, MAX_SAMPLE_FRAMES);
+
+	profilerLock.Enter();
+	sampledStacks[stack] += sampleCount;
+	profilerLock.Leave();
+}
+
+void ProfileAllocation(EEType* eeType, size_t size)
+{
+	auto profile = threadProfile;
+	if (profile == NULL)
+		profile = CreateThreadProfile();
+
+	size = HEAP_ALIGN(size);
+
+	auto stats = FindTypeStats(profile->types, profile->typeTableSize, eeType);
+	if (stats->eeType == NULL)
+	{
+		// Keep table at most half full
+		if ((profile->typeCount + 1) * 2 > profile->typeTableSize)
+		{
+			GrowTypeTable(profile);
+			stats = FindTypeStats(profile->types, profile->typeTableSize, eeType);
+		}
+
+		stats->eeType = eeType;
+		profile->typeCount++;
+	}
+
+	stats->objects++;
+	stats->bytes += size;
+
+	profile->bytesUntilSample -= (ptrdiff_t)size;
+	if (profile->bytesUntilSample <= 0)
+		SampleAllocation(profile, eeType);
+}
+
+// CSV format: kind,type,token,objects,bytes,stack
+// "type" rows have exact counts for each type.
+// "stack" rows have number of samples in objects column, and estimated bytes (samples * sample interval).
+// Types are written as EEType address (and TypeDef token); stack frames are function start addresses.
+void DumpAllocationProfile()
+{
+	if (outputPath == NULL)
+		return;
+
+	std::unordered_map<EEType*, TypeAllocationStats> typeTotals;
+	std::vector<std::pair<AllocationStack, size_t>> stacks;
+
+	// Counters of other threads are read while they might be updated; this is fine for reporting purposes
+	profilerLock.Enter();
+	for (auto profile = threadProfiles; profile != NULL; profile = profile->next)
+	{
+		for (size_t i = 0; i < profile->typeTableSize; ++i)
+		{
+			auto& entry = profile->types[i];
+			if (entry.eeType == NULL)
+				continue;
+
+			auto& total = typeTotals[entry.eeType];
+			total.eeType = entry.eeType;
+			total.objects += entry.objects;
+			total.bytes += entry.bytes;
+		}
+	}
+	stacks.assign(sampledStacks.begin(), sampledStacks.end());
+	profilerLock.Leave();
+
+	std::vector<TypeAllocationStats> types;
+	types.reserve(typeTotals.size());
+	for (auto& typeTotal : typeTotals)
+		types.push_back(typeTotal.second);
+
+	std::sort(types.begin(), types.end(), [](const TypeAllocationStats& a, const TypeAllocationStats& b) { return a.bytes > b.bytes; });
+	std::sort(stacks.begin(), stacks.end(), [](const std::pair<AllocationStack, size_t>& a, const std::pair<AllocationStack, size_t>& b) { return a.second > b.second; });
+
+	auto file = fopen(outputPath, "w");
+	if (file == NULL)
+		return;
+
+	fprintf(file, "kind,type,token,objects,bytes,stack\n");
+
+	for (auto& type : types)
+	{
+		fprintf(file, "type,0x%llx,0x%08x,%llu,%llu,\n",
+			(unsigned long long)(uintptr_t)type.eeType, type.eeType->typeDef.token,
+			(unsigned long long)type.objects, (unsigned long long)type.bytes);
+	}
+
+	for (auto& stack : stacks)
+	{
+		auto eeType = stack.first.eeType;
+		fprintf(file, "stack,0x%llx,0x%08x,%llu,%llu,",
+			(unsigned long long)(uintptr_t)eeType, eeType->typeDef.token,
+			(unsigned long long)stack.second, (unsigned long long)(stack.second * sampleInterval));
+
+		for (uint32_t i = 0; i < stack.first.frameCount; ++i)
+			fprintf(file, i == 0 ? "0x%llx" : " 0x%llx", (unsigned long long)stack.first.frames[i]);
+		fprintf(file, "\n");
+	}
+
+	fclose(file);
+}
+
+#ifdef DUMP_SIGNAL
+static void RequestDump(int signal, siginfo_t* info, void* context)
+{
+	char request = 0;
+	auto result = write(dumpPipe[1], &request, 1);
+	(void)result;
+
+	// Chain to previous handler, in case something else uses the same signal
+	if (previousDumpAction.sa_flags & SA_SIGINFO)
+		previousDumpAction.sa_sigaction(signal, info, context);
+	else if (previousDumpAction.sa_handler != SIG_DFL && previousDumpAction.sa_handler != SIG_IGN)
+		previousDumpAction.sa_handler(signal);
+}
+
+static void* DumpThreadStart(void* parameter)
+{
+	char request;
+	while (read(dumpPipe[0], &request, 1) != 0)
+		DumpAllocationProfile();
+	return NULL;
+}
+
+static void StartDumpThread()
+{
+	if (pipe(dumpPipe) != 0)
+		return;
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, DumpThreadStart, NULL) != 0)
+		return;
+	pthread_detach(thread);
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = &RequestDump;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(DUMP_SIGNAL, &action, &previousDumpAction);
+}
+#endif
+
+// Reads settings at startup (needs to be declared after sampledStacks, so that it is constructed first)
+static struct AllocationProfilerInitializer
+{
+	AllocationProfilerInitializer()
+	{
+		outputPath = getenv("COMPlus_AllocationProfile");
+		if (outputPath == NULL || *outputPath == 0)
+		{
+			outputPath = NULL;
+			return;
+		}
+
+		auto value = getenv("COMPlus_AllocationProfileSampleKB");
+		if (value != NULL)
+		{
+			auto kilobytes = strtoull(value, NULL, 16);
+			if (kilobytes > 0)
+				sampleInterval = (size_t)kilobytes * 1024;
+		}
+
+		atexit(&DumpAllocationProfile);
+#ifdef DUMP_SIGNAL
+		StartDumpThread();
+#endif
+
+		allocationProfilerEnabled = true;
+	}
+} allocationProfilerInitializer;
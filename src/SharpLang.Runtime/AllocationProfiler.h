@@ -0,0 +1,21 @@
+#ifndef SHARPLANG_ALLOCATION_PROFILER_H
+#define SHARPLANG_ALLOCATION_PROFILER_H
+
+#include <stddef.h>
+
+class MethodTable;
+typedef MethodTable EEType;
+
+// Allocation profiling is enabled by setting COMPlus_AllocationProfile to an output file.
+// Objects and bytes are counted per type, and a call stack is sampled every
+// COMPlus_AllocationProfileSampleKB kilobytes allocated by a thread (hex, default 0x200).
+// Results are written as CSV at exit, and by a dedicated thread on SIGRTMIN+1 (SIGINFO where there is no real-time signal).
+extern bool allocationProfilerEnabled;
+
+// Called for every allocated object when profiling is enabled
+void ProfileAllocation(EEType* eeType, size_t size);
+
+// Writes current results to the output file (overwriting it)
+void DumpAllocationProfile();
+
+#endif
@@ -11,6 +11,8 @@
 #include "llvm/Support/Dwarf.h"
 
 #include "RuntimeType.h"
+#include "Heap.h"
+#include "ManagedThread.h"
 
 // TODO: Improve and unify code so that SEH and DWARF shares most of the code
 // TODO: cleanupException is not called
@@ -217,16 +219,11 @@ static bool handleActionValue(int64_t *resultAction,
 			// Actual exception type
 			EEType* exceptionType = exceptionInfo->exceptionObject->eeType;
 
-			// Check if they match (by testing each class in hierarchy)
-			while (exceptionType != NULL)
+			// Check if they match (expected type is in exception type hierarchy)
+			if (isSubclassOf(exceptionType, expectedExceptionType))
 			{
-				if (exceptionType == expectedExceptionType)
-				{
-					*resultAction = typeOffset; // or should it be i + 1?
-					return true;
-				}
-
-				exceptionType = exceptionType->base;
+				*resultAction = typeOffset; // or should it be i + 1?
+				return true;
 			}
 		}
 
@@ -494,6 +491,9 @@ void cleanupException(_Unwind_Reason_Code reason, struct _Unwind_Exception* ex)
 
 extern "C" void throwException(Object* obj)
 {
+	// Exception being thrown lives in malloc memory during unwinding, keep it alive for GC
+	GetCurrentManagedThread()->inFlightException = obj;
+
 #if _WIN32
 	struct ExceptionInfo* ex = (struct ExceptionInfo*)_aligned_malloc(sizeof(struct ExceptionInfo), 16);
 #else
@@ -507,8 +507,9 @@ extern "C" void throwException(Object* obj)
 	__builtin_unreachable(); 
 }
 
+// Fills frames with the start address of functions in current callstack, returns number of entries
 #ifdef __SEH__
-extern "C" uint32_t System_Reflection_Assembly__GetCallStack_System_IntPtr___(Array<uintptr_t>* result)
+uint32_t CaptureCallStack(uintptr_t* frames, uint32_t maxFrames)
 {
 	UNWIND_HISTORY_TABLE history;
 	CONTEXT context;
@@ -520,9 +521,9 @@ extern "C" uint32_t System_Reflection_Assembly__GetCallStack_System_IntPtr___(Ar
 	context.ContextFlags = CONTEXT_ALL;
 	RtlCaptureContext(&context);
 
-	int entryCount = 0;
+	uint32_t entryCount = 0;
 
-	while (true)
+	while (entryCount < maxFrames)
 	{
 		// Find function start
 		ULONGLONG imageBase;
@@ -532,11 +533,7 @@ extern "C" uint32_t System_Reflection_Assembly__GetCallStack_System_IntPtr___(Ar
 			break;
 
 		// Add result
-		result->value[entryCount++] = imageBase + functionEntry->BeginAddress;
-
-		// Too many entries?
-		if (entryCount == result->length)
-			break;
+		frames[entryCount++] = imageBase + functionEntry->BeginAddress;
 
 		// Unwind next frame
 		PVOID handlerData;
@@ -553,10 +550,11 @@ extern "C" uint32_t System_Reflection_Assembly__GetCallStack_System_IntPtr___(Ar
 #else
 struct CallstackData
 {
-	CallstackData(Array<uintptr_t>* callback) : callstack(callback), entries(0) {}
+	CallstackData(uintptr_t* frames, uint32_t maxFrames) : frames(frames), maxFrames(maxFrames), entries(0) {}
 
-	Array<uintptr_t>* callstack;
-	int entries;
+	uintptr_t* frames;
+	uint32_t maxFrames;
+	uint32_t entries;
 };
 
 static _Unwind_Reason_Code trace_func(struct _Unwind_Context* context, void* arg)
@@ -566,19 +564,27 @@ static _Unwind_Reason_Code trace_func(struct _Unwind_Context* context, void* arg
 	if (pc != 0)
 	{
 		uintptr_t funcStart = _Unwind_GetRegionStart(context);
-		data->callstack->value[data->entries++] = funcStart;
-		if (data->entries == data->callstack->length)
+		data->frames[data->entries++] = funcStart;
+		if (data->entries == data->maxFrames)
 			return _URC_NORMAL_STOP;
 	}
 
 	return(_URC_NO_REASON);
 }
 
-// TODO: A variant that can take a List, so that it can appends instead of predetermined size
-extern "C" uint32_t System_Reflection_Assembly__GetCallStack_System_IntPtr___(Array<uintptr_t>* result)
+uint32_t CaptureCallStack(uintptr_t* frames, uint32_t maxFrames)
 {
-	CallstackData data(result);
+	if (maxFrames == 0)
+		return 0;
+
+	CallstackData data(frames, maxFrames);
 	_Unwind_Backtrace(&trace_func, &data);
 	return data.entries;
 }
 #endif
+
+// TODO: A variant that can take a List, so that it can appends instead of predetermined size
+extern "C" uint32_t System_Reflection_Assembly__GetCallStack_System_IntPtr___(Array<uintptr_t>* result)
+{
+	return CaptureCallStack(result->value, (uint32_t)result->length);
+}
@@ -0,0 +1,448 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <unordered_set>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "RuntimeType.h"
+#include "Heap.h"
+#include "SpinLock.h"
+#include "Finalizer.h"
+#include "ManagedThread.h"
+
+// Defined in mscorlib
+extern EEType System_Object_rtti;
+extern "C" void System_Object__Finalize__(Object* obj);
+
+typedef void (*FinalizeMethod)(Object* obj);
+
+struct FinalizationNode
+{
+	FinalizationNode* next;
+	Object* object; // Cleared once finalized
+};
+
+// Nodes are allocated in blocks and recycled: each thread takes a batch of them from the shared free list,
+// so that registering an object doesn't need any lock
+#define FINALIZATION_NODE_BATCH_SIZE 64
+static SpinLock freeNodesLock;
+static FinalizationNode* freeNodes;
+static thread_local FinalizationNode* threadFreeNodes;
+
+// Registered objects, pushed on the young list when allocated (lock-free).
+// Each collection takes the young list as a whole, and moves surviving objects to the old list (only checked by full collections).
+static std::atomic<FinalizationNode*> youngFinalizableObjects;
+static FinalizationNode* oldFinalizableObjects;
+static std::atomic<bool> finalizerThreadStartRequested;
+
+// Objects that are still registered, but shouldn't be finalized anymore (created on first suppression).
+// GC.SuppressFinalize is much less frequent than registration, a node doesn't need to be found for each call.
+static SpinLock suppressedObjectsLock;
+static std::unordered_set<Object*>* suppressedObjects;
+
+// Queue filled by GC (lock-free push), and taken as a whole by finalizer thread.
+// Lock only makes sure GC doesn't scan nodes while they are taken or freed.
+static std::atomic<FinalizationNode*> finalizationQueue;
+static FinalizationNode* finalizingNodes;
+static SpinLock finalizationQueueLock;
+
+// Finalizer thread state (protected by finalizerMutex)
+// Waits are done in preemptive mode, and mutex is never held while leaving it (GC might be waiting for the owner)
+#ifdef _WIN32
+static SRWLOCK finalizerMutex = SRWLOCK_INIT;
+static CONDITION_VARIABLE finalizationRequestedCondition = CONDITION_VARIABLE_INIT;
+static CONDITION_VARIABLE finalizationDoneCondition = CONDITION_VARIABLE_INIT;
+#else
+static pthread_mutex_t finalizerMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t finalizationRequestedCondition = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t finalizationDoneCondition = PTHREAD_COND_INITIALIZER;
+#endif
+static bool finalizerThreadStarted;
+static bool finalizationRequested;
+static bool finalizationRunning;
+static uint64_t finalizationPassCount;
+
+static thread_local bool isFinalizerThread;
+
+static void LockFinalizer()
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&finalizerMutex);
+#else
+	pthread_mutex_lock(&finalizerMutex);
+#endif
+}
+
+static void UnlockFinalizer()
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&finalizerMutex);
+#else
+	pthread_mutex_unlock(&finalizerMutex);
+#endif
+}
+
+#ifdef _WIN32
+static void WaitFinalizer(CONDITION_VARIABLE* condition)
+{
+	SleepConditionVariableSRW(condition, &finalizerMutex, INFINITE, 0);
+}
+
+static void WakeFinalizer(CONDITION_VARIABLE* condition)
+{
+	WakeAllConditionVariable(condition);
+}
+#else
+static void WaitFinalizer(pthread_cond_t* condition)
+{
+	pthread_cond_wait(condition, &finalizerMutex);
+}
+
+static void WakeFinalizer(pthread_cond_t* condition)
+{
+	pthread_cond_broadcast(condition);
+}
+#endif
+
+static uint32_t FindFinalizeSlot()
+{
+	for (uint32_t i = 0; i < System_Object_rtti.virtualTableSize; ++i)
+	{
+		if (System_Object_rtti.virtualTable[i] == (void*)&System_Object__Finalize__)
+			return i;
+	}
+
+	abort();
+}
+
+static FinalizeMethod GetFinalizeMethod(Object* obj)
+{
+	// Object.Finalize has the same slot in every vtable
+	static uint32_t finalizeSlot = FindFinalizeSlot();
+	return (FinalizeMethod)obj->eeType->virtualTable[finalizeSlot];
+}
+
+static FinalizationNode* TakeFreeNodes()
+{
+	FinalizationNode* nodes = NULL;
+
+	freeNodesLock.Enter();
+	for (int i = 0; i < FINALIZATION_NODE_BATCH_SIZE && freeNodes != NULL; ++i)
+	{
+		auto node = freeNodes;
+		freeNodes = node->next;
+		node->next = nodes;
+		nodes = node;
+	}
+	freeNodesLock.Leave();
+
+	if (nodes != NULL)
+		return nodes;
+
+	// Blocks are never freed, their nodes are recycled
+	nodes = (FinalizationNode*)malloc(sizeof(FinalizationNode) * FINALIZATION_NODE_BATCH_SIZE);
+	if (nodes == NULL)
+		abort();
+
+	for (int i = 0; i < FINALIZATION_NODE_BATCH_SIZE - 1; ++i)
+		nodes[i].next = &nodes[i + 1];
+	nodes[FINALIZATION_NODE_BATCH_SIZE - 1].next = NULL;
+
+	return nodes;
+}
+
+static void FreeNodes(FinalizationNode* first, FinalizationNode* last)
+{
+	freeNodesLock.Enter();
+	last->next = freeNodes;
+	freeNodes = first;
+	freeNodesLock.Leave();
+}
+
+static FinalizationNode* AllocateNode()
+{
+	auto node = threadFreeNodes;
+	if (node == NULL)
+		node = TakeFreeNodes();
+
+	threadFreeNodes = node->next;
+	return node;
+}
+
+// Object isn't registered anymore: suppression doesn't apply to it, and its address might be reused
+static void ForgetSuppressedObject(Object* obj)
+{
+	suppressedObjectsLock.Enter();
+	if (suppressedObjects != NULL)
+		suppressedObjects->erase(obj);
+	suppressedObjectsLock.Leave();
+}
+
+static void RunFinalizers()
+{
+	while (true)
+	{
+		finalizationQueueLock.Enter();
+		auto nodes = finalizationQueue.exchange(NULL, std::memory_order_acquire);
+		finalizingNodes = nodes;
+		finalizationQueueLock.Leave();
+
+		if (nodes == NULL)
+			break;
+
+		// Objects stay alive through their node until their finalizer has run
+		// Note: exceptions thrown by finalizers are not caught, they terminate the process
+		for (auto node = nodes; node != NULL; node = node->next)
+		{
+			auto obj = node->object;
+			GetFinalizeMethod(obj)(obj);
+			ForgetSuppressedObject(obj);
+			node->object = NULL;
+		}
+
+		finalizationQueueLock.Enter();
+		finalizingNodes = NULL;
+		finalizationQueueLock.Leave();
+
+		auto last = nodes;
+		while (last->next != NULL)
+			last = last->next;
+		FreeNodes(nodes, last);
+	}
+}
+
+static void FinalizerThreadLoop()
+{
+	isFinalizerThread = true;
+
+	while (true)
+	{
+		RunPreemptive([]
+		{
+			LockFinalizer();
+			while (!finalizationRequested)
+				WaitFinalizer(&finalizationRequestedCondition);
+
+			finalizationRequested = false;
+			finalizationRunning = true;
+			UnlockFinalizer();
+		});
+
+		RunFinalizers();
+
+		LockFinalizer();
+		finalizationRunning = false;
+		finalizationPassCount++;
+		WakeFinalizer(&finalizationDoneCondition);
+		UnlockFinalizer();
+	}
+}
+
+#ifdef _WIN32
+static DWORD WINAPI FinalizerThreadStart(LPVOID parameter)
+{
+	FinalizerThreadLoop();
+	return 0;
+}
+#else
+static void* FinalizerThreadStart(void* parameter)
+{
+	FinalizerThreadLoop();
+	return NULL;
+}
+#endif
+
+static void StartFinalizerThread()
+{
+#ifdef _WIN32
+	auto thread = CreateThread(NULL, 0, FinalizerThreadStart, NULL, 0, NULL);
+	if (thread == NULL)
+		abort();
+	CloseHandle(thread);
+#else
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, FinalizerThreadStart, NULL) != 0)
+		abort();
+	pthread_detach(thread);
+#endif
+
+	LockFinalizer();
+	finalizerThreadStarted = true;
+	UnlockFinalizer();
+}
+
+void RegisterForFinalization(Object* obj)
+{
+	// Finalizer thread is only started if there is anything to finalize
+	if (!finalizerThreadStartRequested.load(std::memory_order_relaxed) && !finalizerThreadStartRequested.exchange(true))
+		StartFinalizerThread();
+
+	auto node = AllocateNode();
+	node->object = obj;
+	node->next = youngFinalizableObjects.load(std::memory_order_relaxed);
+	while (!youngFinalizableObjects.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+}
+
+void ReRegisterForFinalization(Object* obj)
+{
+	if (!obj->eeType->HasFinalizer())
+		return;
+
+	// Still registered if finalization was only suppressed
+	suppressedObjectsLock.Enter();
+	auto wasSuppressed = suppressedObjects != NULL && suppressedObjects->erase(obj) != 0;
+	suppressedObjectsLock.Leave();
+
+	if (!wasSuppressed)
+		RegisterForFinalization(obj);
+}
+
+void SuppressFinalization(Object* obj)
+{
+	// Only objects of types overriding Finalize are registered
+	if (!obj->eeType->HasFinalizer())
+		return;
+
+	suppressedObjectsLock.Enter();
+	if (suppressedObjects == NULL)
+		suppressedObjects = new std::unordered_set<Object*>();
+	suppressedObjects->insert(obj);
+	suppressedObjectsLock.Leave();
+}
+
+void ReleaseFinalizationNodes()
+{
+	auto nodes = threadFreeNodes;
+	if (nodes == NULL)
+		return;
+
+	auto last = nodes;
+	while (last->next != NULL)
+		last = last->next;
+	FreeNodes(nodes, last);
+	threadFreeNodes = NULL;
+}
+
+void ScanFinalizationQueue(FinalizationMarkCallback mark)
+{
+	finalizationQueueLock.Enter();
+	for (auto node = finalizationQueue.load(std::memory_order_acquire); node != NULL; node = node->next)
+		mark(node->object);
+
+	for (auto node = finalizingNodes; node != NULL; node = node->next)
+	{
+		auto obj = node->object;
+		if (obj != NULL)
+			mark(obj);
+	}
+	finalizationQueueLock.Leave();
+}
+
+bool ScanFinalizableObjects(FinalizationIsAliveCallback isAlive, FinalizationMarkCallback mark, bool fullCollection)
+{
+	bool queued = false;
+
+	// Threads are suspended, nobody is registering objects (young objects that survive are old after this collection)
+	FinalizationNode* lists[2] = { youngFinalizableObjects.exchange(NULL, std::memory_order_acquire), NULL };
+	if (fullCollection)
+	{
+		lists[1] = oldFinalizableObjects;
+		oldFinalizableObjects = NULL;
+	}
+
+	FinalizationNode* freedFirst = NULL;
+	FinalizationNode* freedLast = NULL;
+
+	suppressedObjectsLock.Enter();
+	for (auto list : lists)
+	{
+		for (auto node = list; node != NULL; )
+		{
+			auto next = node->next;
+			auto obj = node->object;
+
+			if (isAlive(obj))
+			{
+				node->next = oldFinalizableObjects;
+				oldFinalizableObjects = node;
+			}
+			else if (suppressedObjects != NULL && suppressedObjects->erase(obj) != 0)
+			{
+				node->next = freedFirst;
+				freedFirst = node;
+				if (freedLast == NULL)
+					freedLast = node;
+			}
+			else
+			{
+				// Same node is used in finalization queue
+				node->next = finalizationQueue.load(std::memory_order_relaxed);
+				while (!finalizationQueue.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+				{
+				}
+
+				// Resurrect object (and everything it references) until it is finalized
+				mark(obj);
+				queued = true;
+			}
+
+			node = next;
+		}
+	}
+
+	// Suppression of objects that are not registered anymore (i.e. resurrected after being finalized), which died since then
+	if (suppressedObjects != NULL)
+	{
+		for (auto it = suppressedObjects->begin(); it != suppressedObjects->end(); )
+		{
+			if (isAlive(*it))
+				++it;
+			else
+				it = suppressedObjects->erase(it);
+		}
+	}
+	suppressedObjectsLock.Leave();
+
+	if (freedFirst != NULL)
+		FreeNodes(freedFirst, freedLast);
+
+	return queued;
+}
+
+void StartFinalization()
+{
+	LockFinalizer();
+	finalizationRequested = true;
+	WakeFinalizer(&finalizationRequestedCondition);
+	UnlockFinalizer();
+}
+
+void WaitForPendingFinalizers()
+{
+	// Finalizers waiting for themselves would never complete
+	if (isFinalizerThread)
+		return;
+
+	RunPreemptive([]
+	{
+		LockFinalizer();
+		if (finalizerThreadStarted)
+		{
+			// A pass already running might have taken the queue before latest objects were added, so wait for next one
+			auto targetPassCount = finalizationPassCount + (finalizationRunning ? 2 : 1);
+
+			finalizationRequested = true;
+			WakeFinalizer(&finalizationRequestedCondition);
+
+			while (finalizationPassCount < targetPassCount)
+				WaitFinalizer(&finalizationDoneCondition);
+		}
+		UnlockFinalizer();
+	});
+}
@@ -0,0 +1,32 @@
+#ifndef SHARPLANG_FINALIZER_H
+#define SHARPLANG_FINALIZER_H
+
+class Object;
+
+// Objects of types overriding Object.Finalize are registered when allocated
+void RegisterForFinalization(Object* obj);
+void ReRegisterForFinalization(Object* obj);
+void SuppressFinalization(Object* obj);
+
+// Gives back nodes cached by current thread for registrations (called when thread exits)
+void ReleaseFinalizationNodes();
+
+// Used by GC to scan registered objects
+typedef bool (*FinalizationIsAliveCallback)(Object* obj);
+typedef void (*FinalizationMarkCallback)(Object* obj);
+
+// Marks objects queued for finalization (they are alive until their finalizer has run)
+void ScanFinalizationQueue(FinalizationMarkCallback mark);
+
+// Queues registered objects that are not alive anymore, and marks them so that they survive until finalized.
+// Young collections only check objects registered since previous collection.
+// Returns true if any object has been queued.
+bool ScanFinalizableObjects(FinalizationIsAliveCallback isAlive, FinalizationMarkCallback mark, bool fullCollection);
+
+// Wakes up finalizer thread (called once collection is done)
+void StartFinalization();
+
+// Blocks until objects queued for finalization have been finalized
+void WaitForPendingFinalizers();
+
+#endif
@@ -0,0 +1,138 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "RuntimeType.h"
+#include "HandleTable.h"
+#include "SpinLock.h"
+
+// Slabs are aligned on their size, so that a handle can find its slab (and its type)
+#define HANDLE_SLAB_SIZE 4096
+
+struct HandleSlab
+{
+	HandleSlab* next;
+	int32_t handleType;
+};
+
+#define HANDLES_PER_SLAB ((HANDLE_SLAB_SIZE - sizeof(HandleSlab)) / sizeof(GCHandle))
+
+// Free handles are linked through their value, tagged with lowest bit so that scanning can skip them
+#define FREE_HANDLE_TAG 1
+
+struct HandleBucket
+{
+	HandleSlab* slabs;
+	GCHandle* freeList;
+};
+
+static SpinLock handleTableLock;
+static HandleBucket handleBuckets[HNDTYPE_COUNT];
+
+static inline GCHandle* GetSlabHandles(HandleSlab* slab)
+{
+	return (GCHandle*)(slab + 1);
+}
+
+static inline HandleSlab* GetHandleSlab(GCHandle* handle)
+{
+	return (HandleSlab*)((uintptr_t)handle & ~(uintptr_t)(HANDLE_SLAB_SIZE - 1));
+}
+
+static inline bool IsFreeHandle(GCHandle* handle)
+{
+	return ((uintptr_t)handle->value & FREE_HANDLE_TAG) != 0;
+}
+
+static inline void AddToFreeList(HandleBucket& bucket, GCHandle* handle)
+{
+	handle->value = (Object*)((uintptr_t)bucket.freeList | FREE_HANDLE_TAG);
+	bucket.freeList = handle;
+}
+
+// Note: handleTableLock should be held
+static void AddSlab(HandleBucket& bucket, int handleType)
+{
+	void* memory;
+#ifdef _WIN32
+	memory = _aligned_malloc(HANDLE_SLAB_SIZE, HANDLE_SLAB_SIZE);
+#else
+	if (posix_memalign(&memory, HANDLE_SLAB_SIZE, HANDLE_SLAB_SIZE) != 0)
+		memory = NULL;
+#endif
+	if (memory == NULL)
+	{
+		// TODO: Throw OutOfMemoryException
+		abort();
+	}
+
+	auto slab = (HandleSlab*)memory;
+	slab->handleType = handleType;
+	slab->next = bucket.slabs;
+	bucket.slabs = slab;
+
+	// Every handle goes to free list (in reverse order, so that they are handed out in address order)
+	auto handles = GetSlabHandles(slab);
+	for (size_t i = HANDLES_PER_SLAB; i > 0; --i)
+		AddToFreeList(bucket, &handles[i - 1]);
+}
+
+GCHandle* CreateHandle(Object* value, int handleType)
+{
+	assert(handleType >= 0 && handleType < HNDTYPE_COUNT);
+	auto& bucket = handleBuckets[handleType];
+
+	handleTableLock.Enter();
+
+	if (bucket.freeList == NULL)
+		AddSlab(bucket, handleType);
+
+	auto handle = bucket.freeList;
+	bucket.freeList = (GCHandle*)((uintptr_t)handle->value & ~(uintptr_t)FREE_HANDLE_TAG);
+	handle->value = value;
+
+	handleTableLock.Leave();
+
+	return handle;
+}
+
+void DestroyHandle(GCHandle* handle)
+{
+	auto& bucket = handleBuckets[GetHandleType(handle)];
+
+	handleTableLock.Enter();
+	assert(!IsFreeHandle(handle));
+	AddToFreeList(bucket, handle);
+	handleTableLock.Leave();
+}
+
+int GetHandleType(GCHandle* handle)
+{
+	return GetHandleSlab(handle)->handleType;
+}
+
+void LockHandleTable()
+{
+	handleTableLock.Enter();
+}
+
+void UnlockHandleTable()
+{
+	handleTableLock.Leave();
+}
+
+void ScanHandles(int handleType, HandleScanCallback callback, void* context)
+{
+	for (auto slab = handleBuckets[handleType].slabs; slab != NULL; slab = slab->next)
+	{
+		auto handles = GetSlabHandles(slab);
+		for (size_t i = 0; i < HANDLES_PER_SLAB; ++i)
+		{
+			if (!IsFreeHandle(&handles[i]))
+				callback(&handles[i], context);
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef SHARPLANG_HANDLE_TABLE_H
+#define SHARPLANG_HANDLE_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class Object;
+struct GCHandle;
+
+// Handle types (should match System.Runtime.InteropServices.GCHandleType)
+enum HandleType
+{
+	HNDTYPE_WEAK_SHORT = 0,
+	HNDTYPE_WEAK_LONG = 1,
+	HNDTYPE_STRONG = 2,
+	HNDTYPE_PINNED = 3,
+
+	HNDTYPE_COUNT
+};
+
+// Handles are slots of fixed size slabs, each slab only containing handles of a single type
+GCHandle* CreateHandle(Object* value, int handleType);
+void DestroyHandle(GCHandle* handle);
+int GetHandleType(GCHandle* handle);
+
+// Calls callback for every allocated handle of given type (used by GC to scan handles in bulk)
+// Note: handle table should be locked
+typedef void (*HandleScanCallback)(GCHandle* handle, void* context);
+void LockHandleTable();
+void UnlockHandleTable();
+void ScanHandles(int handleType, HandleScanCallback callback, void* context);
+
+#endif
@@ -0,0 +1,1320 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <setjmp.h>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sched.h>
+#include <pthread.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#include <mach-o/getsect.h>
+#else
+#include <link.h>
+#endif
+#endif
+
+#include "RuntimeType.h"
+#include "Heap.h"
+#include "SpinLock.h"
+#include "HandleTable.h"
+#include "AllocationProfiler.h"
+#include "Finalizer.h"
+#include "ObjectHeader.h"
+#include "ManagedThread.h"
+#include "ThreadPool.h"
+
+#define ELEMENT_TYPE_STRING 0x0e
+#define ELEMENT_TYPE_SZARRAY 0x1d
+#define ELEMENT_TYPE_ARRAY 0x14
+
+// Size of the chunks handed out to thread allocation contexts
+#define ALLOCATION_QUANTUM (8 * 1024)
+
+// Usable size of the segments reserved from the OS (objects bigger than that get their own segment)
+#define SEGMENT_SIZE (4 * 1024 * 1024)
+
+// Free space smaller than that is not worth tracking in the free list
+#define MIN_FREE_LIST_SIZE 512
+
+// Amount of allocated bytes between two young collections
+#define NURSERY_BUDGET (4 * 1024 * 1024)
+
+// Minimum amount of promoted bytes between two full collections
+#define MIN_COLLECTION_BUDGET (8 * 1024 * 1024)
+
+// Objects at least that big go to the large object space (can be changed with COMPlus_GCLOHThreshold)
+#define DEFAULT_LARGE_OBJECT_THRESHOLD 85000
+
+// Address space of released large objects kept around for reuse (their pages are given back to the OS)
+#define LARGE_OBJECT_CACHE_SIZE (64 * 1024 * 1024)
+
+#define OS_PAGE_SIZE 4096
+
+// Card table: one byte per 512 bytes of memory. Addresses are hashed in a fixed size table,
+// so aliasing only costs extra scanning.
+#define CARD_SHIFT 9
+#define CARD_TABLE_SIZE (1024 * 1024)
+#define CARD_TABLE_MASK (CARD_TABLE_SIZE - 1)
+
+// Segment layout: header, mark bits (one per HEAP_ALIGNMENT bytes of [start, end)), then objects.
+// Mark bits are sticky: objects that survived a collection stay marked, which is what makes them old.
+struct HeapSegment
+{
+	HeapSegment* next;
+
+	// [start, allocated) contains objects, [allocated, end) has not been handed out yet
+	uint8_t* start;
+	uint8_t* allocated;
+	uint8_t* end;
+
+	size_t* markBits;
+};
+
+#define SEGMENT_HEADER_SIZE HEAP_ALIGN(sizeof(HeapSegment))
+#define MARK_BITS_PER_WORD (sizeof(size_t) * 8)
+
+// Unused space in segments is described by free objects, so that heap can be walked linearly.
+// Their size is stored in the header word (free objects are never hashed or locked).
+struct FreeObject : Object
+{
+	size_t GetSize() { return header; }
+	void SetSize(size_t size) { header = size; }
+
+	FreeObject* next; // Only valid if in free list
+};
+
+// Free objects use freeObjectEEType, except single word gaps that are too small to store their size
+static EEType freeObjectEEType;
+static EEType freeWordEEType;
+
+// Large objects get their own mapping: header, then the object.
+// Fresh (or reset) pages are zeroed lazily by the OS, so they don't need to be touched up front.
+struct LargeObject
+{
+	LargeObject* next;
+	size_t mappingSize;
+	size_t size;
+
+	// Sticky, as segment mark bits
+	bool marked;
+};
+
+#define LARGE_OBJECT_HEADER_SIZE HEAP_ALIGN(sizeof(LargeObject))
+
+static inline uint8_t* GetLargeObjectStart(LargeObject* largeObject)
+{
+	return (uint8_t*)largeObject + LARGE_OBJECT_HEADER_SIZE;
+}
+
+// Released large object mapping, waiting to be reused
+struct CachedMapping
+{
+	void* address;
+	size_t size;
+};
+
+static SpinLock heapLock;
+static HeapSegment* segments;
+static HeapSegment* currentSegment;
+static FreeObject* freeList;
+static AllocationContext* allocationContexts;
+
+static thread_local AllocationContext allocationContext;
+
+static size_t largeObjectThreshold;
+static LargeObject* largeObjects;
+static std::vector<CachedMapping> cachedMappings;
+static size_t cachedMappingsSize;
+
+// Memory handed out since last collection (chunks and large objects); this is where young objects live
+struct YoungRegion
+{
+	uint8_t* start;
+	uint8_t* end;
+
+	bool operator<(const YoungRegion& other) const { return start < other.start; }
+};
+
+static std::vector<YoungRegion> youngRegions;
+
+// Written by the write barrier when a reference is stored in the heap
+static uint8_t cardTable[CARD_TABLE_SIZE];
+
+// Collection state
+static std::vector<Object**> registeredRoots;
+static std::vector<HeapSegment*> sortedSegments;
+static std::vector<LargeObject*> sortedLargeObjects;
+static std::vector<uint8_t*> conservativeRoots;
+static std::vector<Object*> markStack;
+static uint8_t* heapLow;
+static uint8_t* heapHigh;
+
+// Statistics
+static uint32_t collectionCount;
+static uint32_t fullCollectionCount;
+static size_t bytesAllocatedSinceCollection;
+static size_t promotedBytesSinceFullCollection;
+static size_t liveBytesAfterFullCollection;
+static size_t fullCollectionBudget = MIN_COLLECTION_BUDGET;
+static size_t largeObjectBytes;
+static size_t largeObjectBytesAllocatedSinceCollection;
+static size_t largeObjectBytesAfterFullCollection;
+
+// Unmanaged memory reported with GC.AddMemoryPressure (counts toward collection budgets)
+static size_t memoryPressure;
+static size_t memoryPressureAddedSinceCollection;
+static size_t memoryPressureAfterFullCollection;
+
+static void CollectGarbage(int generation);
+
+static inline size_t AlignObjectSize(size_t size)
+{
+	// Every object needs at least room for its EEType
+	return size < sizeof(Object) ? HEAP_ALIGN(sizeof(Object)) : HEAP_ALIGN(size);
+}
+
+static inline bool IsFreeObject(Object* obj)
+{
+	return obj->eeType == &freeObjectEEType || obj->eeType == &freeWordEEType;
+}
+
+size_t GetObjectSize(Object* obj)
+{
+	auto eeType = obj->eeType;
+	if (eeType == &freeObjectEEType)
+		return ((FreeObject*)obj)->GetSize();
+	if (eeType == &freeWordEEType)
+		return HEAP_ALIGNMENT;
+
+	switch (eeType->corElementType)
+	{
+	case ELEMENT_TYPE_STRING:
+		return AlignObjectSize(sizeof(StringObject) + sizeof(char16_t) * ((StringObject*)obj)->length);
+	case ELEMENT_TYPE_SZARRAY:
+	case ELEMENT_TYPE_ARRAY:
+		return AlignObjectSize(sizeof(ArrayBase) + eeType->elementSize * ((ArrayBase*)obj)->length);
+	default:
+		return AlignObjectSize(eeType->objectSize);
+	}
+}
+
+static void* AllocateVirtualMemory(size_t size)
+{
+	// Fresh pages from the OS are already zeroed
+#ifdef _WIN32
+	return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	auto result = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return result != MAP_FAILED ? result : NULL;
+#endif
+}
+
+static void FreeVirtualMemory(void* address, size_t size)
+{
+#ifdef _WIN32
+	VirtualFree(address, 0, MEM_RELEASE);
+#else
+	munmap(address, size);
+#endif
+}
+
+// Gives pages back to the OS but keeps the address range; pages will be zeroed on next access
+static void ResetVirtualMemory(void* address, size_t size)
+{
+#ifdef _WIN32
+	VirtualFree(address, size, MEM_DECOMMIT);
+	VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE);
+#else
+	madvise(address, size, MADV_DONTNEED);
+#endif
+}
+
+// TODO: Throw OutOfMemoryException (heap lock needs to be released first, and exception object preallocated)
+static void FatalOutOfMemory(size_t size)
+{
+	fprintf(stderr, "Out of memory: could not allocate %llu bytes for the managed heap\n", (unsigned long long)size);
+	abort();
+}
+
+// Turns [start, start + size) into a free object (and track it in free list if big enough)
+// Note: heapLock should be held
+static void MakeFreeSpace(uint8_t* start, size_t size)
+{
+	if (size == 0)
+		return;
+
+	auto freeObject = (FreeObject*)start;
+	if (size < sizeof(Object))
+	{
+		assert(size == HEAP_ALIGNMENT);
+		freeObject->eeType = &freeWordEEType;
+		return;
+	}
+
+	freeObject->eeType = &freeObjectEEType;
+	freeObject->SetSize(size);
+
+	if (size >= MIN_FREE_LIST_SIZE)
+	{
+		freeObject->next = freeList;
+		freeList = freeObject;
+	}
+}
+
+// Note: heapLock should be held
+static HeapSegment* CreateSegment(size_t size)
+{
+	auto markBitsSize = HEAP_ALIGN((size / HEAP_ALIGNMENT + MARK_BITS_PER_WORD - 1) / MARK_BITS_PER_WORD * sizeof(size_t));
+	auto totalSize = SEGMENT_HEADER_SIZE + markBitsSize + size;
+
+	auto segment = (HeapSegment*)AllocateVirtualMemory(totalSize);
+	if (segment == NULL)
+		FatalOutOfMemory(totalSize);
+
+	segment->markBits = (size_t*)((uint8_t*)segment + SEGMENT_HEADER_SIZE);
+	segment->start = (uint8_t*)segment + SEGMENT_HEADER_SIZE + markBitsSize;
+	segment->allocated = segment->start;
+	segment->end = (uint8_t*)segment + totalSize;
+
+	// Register segment
+	segment->next = segments;
+	segments = segment;
+
+	return segment;
+}
+
+// Note: heapLock should be held
+static uint8_t* AllocateFromSegment(size_t size)
+{
+	if (currentSegment == NULL || size > (size_t)(currentSegment->end - currentSegment->allocated))
+	{
+		// Huge object: give it its own segment
+		if (size > SEGMENT_SIZE)
+		{
+			auto segment = CreateSegment(size);
+			segment->allocated = segment->end;
+			return segment->start;
+		}
+
+		// Remaining space of current segment goes to the free list
+		if (currentSegment != NULL)
+		{
+			MakeFreeSpace(currentSegment->allocated, currentSegment->end - currentSegment->allocated);
+			currentSegment->allocated = currentSegment->end;
+		}
+
+		currentSegment = CreateSegment(SEGMENT_SIZE);
+	}
+
+	auto result = currentSegment->allocated;
+	currentSegment->allocated += size;
+	return result;
+}
+
+// Takes between minSize and maxSize bytes from the first free object big enough (first fit)
+// Note: heapLock should be held
+static uint8_t* AllocateFromFreeList(size_t minSize, size_t maxSize, size_t* allocatedSize)
+{
+	for (FreeObject** previous = &freeList; *previous != NULL; previous = &(*previous)->next)
+	{
+		auto freeObject = *previous;
+		auto freeSize = freeObject->GetSize();
+		if (freeSize < minSize)
+			continue;
+
+		// Take everything if remaining part would be too small to be reused
+		auto size = freeSize > maxSize && freeSize - maxSize >= MIN_FREE_LIST_SIZE ? maxSize : freeSize;
+
+		// Remove from free list, and put back remaining part (if any)
+		*previous = freeObject->next;
+		MakeFreeSpace((uint8_t*)freeObject + size, freeSize - size);
+
+		// Free list memory is not zeroed
+		auto memory = (uint8_t*)freeObject;
+		memset(memory, 0, size);
+
+		*allocatedSize = size;
+		return memory;
+	}
+
+	return NULL;
+}
+
+// Fills unused part of an allocation context, so that heap stays parsable
+// Note: heapLock should be held
+static void RetireAllocationContext(AllocationContext* context)
+{
+	if (context->allocPtr != NULL)
+		MakeFreeSpace(context->allocPtr, context->allocLimit - context->allocPtr);
+
+	context->allocPtr = NULL;
+	context->allocLimit = NULL;
+}
+
+static size_t ReadLargeObjectThreshold()
+{
+	// Same setting (and hexadecimal format) as CoreCLR
+	auto value = getenv("COMPlus_GCLOHThreshold");
+	auto threshold = value != NULL ? (size_t)strtoull(value, NULL, 16) : 0;
+	if (threshold == 0)
+		threshold = DEFAULT_LARGE_OBJECT_THRESHOLD;
+
+	// Smaller objects are bump allocated in allocation contexts
+	return std::max(threshold, (size_t)ALLOCATION_QUANTUM + 1);
+}
+
+size_t GetLargeObjectThreshold()
+{
+	// Note: might be computed concurrently, but always to the same value
+	if (largeObjectThreshold == 0)
+		largeObjectThreshold = ReadLargeObjectThreshold();
+
+	return largeObjectThreshold;
+}
+
+// Note: heapLock should be held
+static uint8_t* AllocateLargeObject(size_t size)
+{
+	auto mappingSize = (LARGE_OBJECT_HEADER_SIZE + size + OS_PAGE_SIZE - 1) & ~(size_t)(OS_PAGE_SIZE - 1);
+
+	// Reuse a released mapping if one is big enough (without wasting more than a quarter of it)
+	LargeObject* largeObject = NULL;
+	for (auto it = cachedMappings.begin(); it != cachedMappings.end(); ++it)
+	{
+		if (it->size >= mappingSize && it->size - mappingSize <= it->size / 4)
+		{
+			largeObject = (LargeObject*)it->address;
+			mappingSize = it->size;
+			cachedMappingsSize -= it->size;
+			*it = cachedMappings.back();
+			cachedMappings.pop_back();
+			break;
+		}
+	}
+
+	if (largeObject == NULL)
+	{
+		largeObject = (LargeObject*)AllocateVirtualMemory(mappingSize);
+		if (largeObject == NULL)
+			FatalOutOfMemory(mappingSize);
+	}
+
+	largeObject->mappingSize = mappingSize;
+	largeObject->size = size;
+	largeObject->marked = false;
+	largeObject->next = largeObjects;
+	largeObjects = largeObject;
+
+	largeObjectBytes += size;
+	largeObjectBytesAllocatedSinceCollection += size;
+
+	return GetLargeObjectStart(largeObject);
+}
+
+// Note: heapLock should be held
+static void ReleaseLargeObject(LargeObject* largeObject)
+{
+	auto mappingSize = largeObject->mappingSize;
+	largeObjectBytes -= largeObject->size;
+
+	if (cachedMappingsSize + mappingSize > LARGE_OBJECT_CACHE_SIZE)
+	{
+		FreeVirtualMemory(largeObject, mappingSize);
+		return;
+	}
+
+	ResetVirtualMemory(largeObject, mappingSize);
+
+	CachedMapping mapping = { largeObject, mappingSize };
+	cachedMappings.push_back(mapping);
+	cachedMappingsSize += mappingSize;
+}
+
+// Large objects and unmanaged memory added since last full collection count as promoted
+static size_t GetPromotedBytes()
+{
+	auto promotedBytes = promotedBytesSinceFullCollection + (largeObjectBytes - largeObjectBytesAfterFullCollection);
+	if (memoryPressure > memoryPressureAfterFullCollection)
+		promotedBytes += memoryPressure - memoryPressureAfterFullCollection;
+	return promotedBytes;
+}
+
+static inline size_t GetBytesAllocatedSinceCollection()
+{
+	return bytesAllocatedSinceCollection + largeObjectBytesAllocatedSinceCollection + memoryPressureAddedSinceCollection;
+}
+
+// Note: heapLock should be held
+static void CollectIfBudgetExceeded()
+{
+	if (GetBytesAllocatedSinceCollection() < NURSERY_BUDGET)
+		return;
+
+	CollectGarbage(GetPromotedBytes() >= fullCollectionBudget ? MAX_GENERATION : 0);
+}
+
+// Threads waiting for heapLock go to preemptive mode: its owner might be collecting, waiting for every thread to reach a safe point
+static void EnterHeapLock()
+{
+	if (heapLock.TryEnter())
+		return;
+
+	RunPreemptive([] { heapLock.Enter(); });
+}
+
+static void* AllocateMemorySlow(AllocationContext* context, size_t size)
+{
+	// Threads are tracked by GC from their first allocation
+	GetCurrentManagedThread();
+
+	EnterHeapLock();
+
+	if (!context->registered)
+	{
+		// Unregistered when thread exits
+		context->registered = true;
+		context->next = allocationContexts;
+		allocationContexts = context;
+	}
+
+	CollectIfBudgetExceeded();
+
+	if (size >= GetLargeObjectThreshold())
+	{
+		auto result = AllocateLargeObject(size);
+		heapLock.Leave();
+		return result;
+	}
+
+	uint8_t* result;
+	size_t allocatedSize = size;
+	if (size > ALLOCATION_QUANTUM)
+	{
+		// Large object: allocate it directly and keep current chunk
+		result = AllocateFromFreeList(size, size, &allocatedSize);
+		if (result == NULL)
+		{
+			result = AllocateFromSegment(size);
+		}
+		else if (allocatedSize > size)
+		{
+			MakeFreeSpace(result + size, allocatedSize - size);
+			allocatedSize = size;
+		}
+	}
+	else
+	{
+		// Refill allocation context with a new chunk
+		RetireAllocationContext(context);
+
+		result = AllocateFromFreeList(size, ALLOCATION_QUANTUM, &allocatedSize);
+		if (result == NULL)
+		{
+			allocatedSize = ALLOCATION_QUANTUM;
+			result = AllocateFromSegment(ALLOCATION_QUANTUM);
+		}
+
+		context->allocPtr = result + size;
+		context->allocLimit = result + allocatedSize;
+	}
+
+	bytesAllocatedSinceCollection += allocatedSize;
+
+	YoungRegion region = { result, result + allocatedSize };
+	youngRegions.push_back(region);
+
+	heapLock.Leave();
+
+	return result;
+}
+
+AllocationContext* GetAllocationContext()
+{
+	return &allocationContext;
+}
+
+void ReleaseAllocationContext()
+{
+	auto context = &allocationContext;
+	if (!context->registered)
+		return;
+
+	EnterHeapLock();
+	RetireAllocationContext(context);
+	for (auto previous = &allocationContexts; *previous != NULL; previous = &(*previous)->next)
+	{
+		if (*previous == context)
+		{
+			*previous = context->next;
+			break;
+		}
+	}
+	context->next = NULL;
+	context->registered = false;
+	heapLock.Leave();
+}
+
+void* AllocateMemory(size_t size)
+{
+	size = AlignObjectSize(size);
+
+	// Fast path: bump pointer in current chunk
+	auto context = &allocationContext;
+	auto result = context->allocPtr;
+	if (size <= (size_t)(context->allocLimit - result))
+	{
+		context->allocPtr = result + size;
+		return result;
+	}
+
+	return AllocateMemorySlow(context, size);
+}
+
+Object* AllocateObject(EEType* eeType, size_t size)
+{
+	if (allocationProfilerEnabled)
+		ProfileAllocation(eeType, size);
+
+	auto object = (Object*)AllocateMemory(size);
+	object->eeType = eeType;
+
+	if (eeType->HasFinalizer())
+		RegisterForFinalization(object);
+
+	return object;
+}
+
+Object* AllocateObject(EEType* eeType)
+{
+	return AllocateObject(eeType, eeType->objectSize);
+}
+
+ArrayBase* AllocateArray(EEType* arrayType, size_t length)
+{
+	auto result = (ArrayBase*)AllocateObject(arrayType, sizeof(ArrayBase) + arrayType->elementSize * length);
+	result->length = length;
+	return result;
+}
+
+extern "C" Object* allocObject(EEType* eeType, size_t size)
+{
+	return AllocateObject(eeType, size);
+}
+
+void RegisterGCRoot(Object** root)
+{
+	EnterHeapLock();
+	registeredRoots.push_back(root);
+	heapLock.Leave();
+}
+
+void UnregisterGCRoot(Object** root)
+{
+	EnterHeapLock();
+	auto it = std::find(registeredRoots.begin(), registeredRoots.end(), root);
+	if (it != registeredRoots.end())
+	{
+		*it = registeredRoots.back();
+		registeredRoots.pop_back();
+	}
+	heapLock.Leave();
+}
+
+// Finds the segment containing given address (only valid during a collection)
+static HeapSegment* FindSegment(uint8_t* address)
+{
+	if (address < heapLow || address >= heapHigh)
+		return NULL;
+
+	// Find last segment starting before address
+	auto it = std::upper_bound(sortedSegments.begin(), sortedSegments.end(), address,
+		[](uint8_t* value, HeapSegment* segment) { return value < segment->start; });
+	if (it == sortedSegments.begin())
+		return NULL;
+
+	auto segment = *(it - 1);
+	return address < segment->allocated ? segment : NULL;
+}
+
+static inline bool TestAndSetMark(HeapSegment* segment, Object* obj)
+{
+	auto index = ((uint8_t*)obj - segment->start) / HEAP_ALIGNMENT;
+	auto& word = segment->markBits[index / MARK_BITS_PER_WORD];
+	auto bit = (size_t)1 << (index % MARK_BITS_PER_WORD);
+	if (word & bit)
+		return false;
+
+	word |= bit;
+	return true;
+}
+
+static inline bool IsMarked(HeapSegment* segment, uint8_t* address)
+{
+	auto index = (address - segment->start) / HEAP_ALIGNMENT;
+	return (segment->markBits[index / MARK_BITS_PER_WORD] & ((size_t)1 << (index % MARK_BITS_PER_WORD))) != 0;
+}
+
+// Finds the large object containing given address (only valid during a collection)
+static LargeObject* FindLargeObject(uint8_t* address)
+{
+	if (address < heapLow || address >= heapHigh)
+		return NULL;
+
+	auto it = std::upper_bound(sortedLargeObjects.begin(), sortedLargeObjects.end(), address,
+		[](uint8_t* value, LargeObject* largeObject) { return value < GetLargeObjectStart(largeObject); });
+	if (it == sortedLargeObjects.begin())
+		return NULL;
+
+	auto largeObject = *(it - 1);
+	return address < GetLargeObjectStart(largeObject) + largeObject->size ? largeObject : NULL;
+}
+
+static inline void MarkLargeObject(LargeObject* largeObject)
+{
+	if (largeObject->marked)
+		return;
+
+	largeObject->marked = true;
+	markStack.push_back((Object*)GetLargeObjectStart(largeObject));
+}
+
+static inline void MarkObject(Object* obj)
+{
+	// Ignore null and objects outside of the heap (i.e. string literals)
+	auto segment = FindSegment((uint8_t*)obj);
+	if (segment == NULL)
+	{
+		auto largeObject = FindLargeObject((uint8_t*)obj);
+		if (largeObject != NULL)
+			MarkLargeObject(largeObject);
+		return;
+	}
+
+	if (TestAndSetMark(segment, obj))
+		markStack.push_back(obj);
+}
+
+// Marks objects referenced by fields of obj, using GC entries of field descriptions
+static void ScanObject(Object* obj)
+{
+	auto eeType = obj->eeType;
+
+	if (eeType->corElementType == ELEMENT_TYPE_SZARRAY || eeType->corElementType == ELEMENT_TYPE_ARRAY)
+	{
+		// Array: GC entries describe references in a single element
+		auto fieldCount = eeType->garbageCollectableFieldCount;
+		if (fieldCount == 0)
+			return;
+
+		auto array = (ArrayBase*)obj;
+		auto elementSize = eeType->elementSize;
+		auto element = array->GetDataPtr();
+		for (size_t i = 0; i < array->length; ++i, element += elementSize)
+		{
+			for (uint32_t fieldIndex = 0; fieldIndex < fieldCount; ++fieldIndex)
+				MarkObject(*(Object**)(element + eeType->fieldDescriptions[fieldIndex].GetOffset()));
+		}
+		return;
+	}
+
+	// Each class in the hierarchy describes its own fields
+	for (; eeType != NULL; eeType = eeType->base)
+	{
+		for (uint32_t fieldIndex = 0; fieldIndex < eeType->garbageCollectableFieldCount; ++fieldIndex)
+			MarkObject(eeType->fieldDescriptions[fieldIndex].GetRefValue(obj));
+	}
+}
+
+// Objects outside of the heap (i.e. string literals) are always alive
+// Note: only valid between mark and sweep
+static bool IsAlive(Object* obj)
+{
+	auto segment = FindSegment((uint8_t*)obj);
+	if (segment != NULL)
+		return IsMarked(segment, (uint8_t*)obj);
+
+	auto largeObject = FindLargeObject((uint8_t*)obj);
+	if (largeObject != NULL)
+		return largeObject->marked;
+
+	return true;
+}
+
+static void MarkHandle(GCHandle* handle, void* context)
+{
+	MarkObject(handle->value);
+}
+
+static void ClearDeadHandle(GCHandle* handle, void* context)
+{
+	if (handle->value != NULL && !IsAlive(handle->value))
+		handle->value = NULL;
+}
+
+static void ProcessMarkStack()
+{
+	while (!markStack.empty())
+	{
+		auto obj = markStack.back();
+		markStack.pop_back();
+		ScanObject(obj);
+	}
+}
+
+// Considers every pointer-sized value in [start, end) as a potential reference (possibly interior)
+static void ScanConservatively(uint8_t* start, uint8_t* end)
+{
+	auto current = (uint8_t**)(((uintptr_t)start + sizeof(void*) - 1) & ~(uintptr_t)(sizeof(void*) - 1));
+	for (; (uint8_t*)(current + 1) <= end; ++current)
+	{
+		auto value = *current;
+		if (value >= heapLow && value < heapHigh)
+			conservativeRoots.push_back(value);
+	}
+}
+
+static __attribute__((noinline)) void ScanCurrentStack()
+{
+	// Spill callee-saved registers on the stack, so that they get scanned too
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_unwind_init();
+#endif
+	jmp_buf registers;
+	setjmp(registers);
+
+	ScanConservatively((uint8_t*)&registers, GetCurrentManagedThread()->stackBase);
+}
+
+// Other threads are suspended in preemptive mode: their stack is scanned from where they left managed code
+static void ScanThread(ManagedThread* thread)
+{
+	if (thread != GetCurrentManagedThread() && thread->stackBase != NULL)
+		ScanConservatively(thread->stackPointer, thread->stackBase);
+	if (thread->signalContextStart != NULL)
+		ScanConservatively(thread->signalContextStart, thread->signalContextEnd);
+
+	MarkObject((Object*)thread->exposedObject);
+	MarkObject(thread->inFlightException);
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+static int ScanModuleDataSections(struct dl_phdr_info* info, size_t size, void* data)
+{
+	for (int i = 0; i < info->dlpi_phnum; ++i)
+	{
+		auto& programHeader = info->dlpi_phdr[i];
+		if (programHeader.p_type == PT_LOAD && (programHeader.p_flags & PF_W))
+		{
+			auto start = (uint8_t*)(info->dlpi_addr + programHeader.p_vaddr);
+			ScanConservatively(start, start + programHeader.p_memsz);
+		}
+	}
+
+	// First entry is the main program, which contains runtime and compiled code
+	return 1;
+}
+#endif
+
+// Static fields and EEType caches live in writable data sections of the main module
+static void ScanDataSections()
+{
+#ifdef _WIN32
+	auto module = (uint8_t*)GetModuleHandle(NULL);
+	auto ntHeaders = (IMAGE_NT_HEADERS*)(module + ((IMAGE_DOS_HEADER*)module)->e_lfanew);
+	auto section = IMAGE_FIRST_SECTION(ntHeaders);
+	for (int i = 0; i < ntHeaders->FileHeader.NumberOfSections; ++i, ++section)
+	{
+		if (section->Characteristics & IMAGE_SCN_MEM_WRITE)
+			ScanConservatively(module + section->VirtualAddress, module + section->VirtualAddress + section->Misc.VirtualSize);
+	}
+#elif defined(__APPLE__)
+	// First image is the main program, which contains runtime and compiled code
+#ifdef __LP64__
+	auto header = (const struct mach_header_64*)_dyld_get_image_header(0);
+#else
+	auto header = _dyld_get_image_header(0);
+#endif
+	static const char* const segmentNames[] = { "__DATA", "__DATA_DIRTY" };
+	for (auto segmentName : segmentNames)
+	{
+		unsigned long size;
+		auto start = getsegmentdata(header, segmentName, &size);
+		if (start != NULL)
+			ScanConservatively(start, start + size);
+	}
+#else
+	dl_iterate_phdr(ScanModuleDataSections, NULL);
+#endif
+}
+
+// Marks objects of [start, end) containing conservative roots, returns first root after end
+static std::vector<uint8_t*>::iterator MarkConservativeRoots(HeapSegment* segment, uint8_t* start, uint8_t* end, std::vector<uint8_t*>::iterator root)
+{
+	while (root != conservativeRoots.end() && *root < start)
+		++root;
+
+	// Walk objects until there is no more roots in this range
+	auto current = start;
+	while (root != conservativeRoots.end() && *root < end)
+	{
+		auto obj = (Object*)current;
+		auto next = current + GetObjectSize(obj);
+		if (*root < next)
+		{
+			if (!IsFreeObject(obj) && TestAndSetMark(segment, obj))
+				markStack.push_back(obj);
+
+			while (root != conservativeRoots.end() && *root < next)
+				++root;
+		}
+		current = next;
+	}
+
+	return root;
+}
+
+// Resolves conservative roots to the objects containing them
+// (only young objects need to be found during a young collection)
+static void MarkConservativeRoots(bool fullCollection)
+{
+	std::sort(conservativeRoots.begin(), conservativeRoots.end());
+	conservativeRoots.erase(std::unique(conservativeRoots.begin(), conservativeRoots.end()), conservativeRoots.end());
+
+	auto root = conservativeRoots.begin();
+	if (fullCollection)
+	{
+		for (auto segment : sortedSegments)
+			root = MarkConservativeRoots(segment, segment->start, segment->allocated, root);
+	}
+	else
+	{
+		for (auto& region : youngRegions)
+			root = MarkConservativeRoots(FindSegment(region.start), region.start, region.end, root);
+	}
+
+	// Large objects (old ones are already marked during a young collection)
+	root = conservativeRoots.begin();
+	for (auto largeObject : sortedLargeObjects)
+	{
+		auto start = GetLargeObjectStart(largeObject);
+		root = std::lower_bound(root, conservativeRoots.end(), start);
+		if (root == conservativeRoots.end())
+			break;
+
+		if (*root < start + largeObject->size)
+			MarkLargeObject(largeObject);
+	}
+
+	conservativeRoots.clear();
+}
+
+// Scans dirty cards of [start, end) for references to young objects
+static void ScanDirtyCards(uint8_t* start, uint8_t* end)
+{
+	auto lastCard = ((uintptr_t)end - 1) >> CARD_SHIFT;
+	for (auto card = (uintptr_t)start >> CARD_SHIFT; card <= lastCard; ++card)
+	{
+		if (cardTable[card & CARD_TABLE_MASK] == 0)
+			continue;
+
+		// Objects boundaries are not known, so card content is scanned conservatively
+		auto cardStart = std::max(start, (uint8_t*)(card << CARD_SHIFT));
+		auto cardEnd = std::min(end, (uint8_t*)((card + 1) << CARD_SHIFT));
+		ScanConservatively(cardStart, cardEnd);
+	}
+}
+
+// Old objects referencing young ones have been recorded by the write barrier
+// Note: young regions should be sorted
+static void ScanDirtyCards()
+{
+	auto region = youngRegions.begin();
+	for (auto segment : sortedSegments)
+	{
+		auto current = segment->start;
+		while (current < segment->allocated)
+		{
+			while (region != youngRegions.end() && region->end <= current)
+				++region;
+
+			// Young regions are traced from roots, skip them
+			if (region != youngRegions.end() && region->start <= current)
+			{
+				current = region->end;
+				continue;
+			}
+
+			auto oldEnd = region != youngRegions.end() && region->start < segment->allocated ? region->start : segment->allocated;
+			ScanDirtyCards(current, oldEnd);
+			current = oldEnd;
+		}
+	}
+
+	// Large objects are old once marked
+	for (auto largeObject : sortedLargeObjects)
+	{
+		if (largeObject->marked)
+			ScanDirtyCards(GetLargeObjectStart(largeObject), GetLargeObjectStart(largeObject) + largeObject->size);
+	}
+}
+
+static bool HasMarkedObjects(HeapSegment* segment)
+{
+	auto markBitsCount = ((segment->end - segment->start) / HEAP_ALIGNMENT + MARK_BITS_PER_WORD - 1) / MARK_BITS_PER_WORD;
+	for (size_t i = 0; i < markBitsCount; ++i)
+	{
+		if (segment->markBits[i] != 0)
+			return true;
+	}
+
+	return false;
+}
+
+// Turns dead objects of [start, end) into free space, returns live bytes
+static size_t SweepRange(HeapSegment* segment, uint8_t* start, uint8_t* end)
+{
+	size_t liveBytes = 0;
+	uint8_t* freeStart = NULL;
+
+	for (auto current = start; current < end; )
+	{
+		auto size = GetObjectSize((Object*)current);
+		if (IsMarked(segment, current))
+		{
+			if (freeStart != NULL)
+			{
+				MakeFreeSpace(freeStart, current - freeStart);
+				freeStart = NULL;
+			}
+			liveBytes += size;
+		}
+		else if (freeStart == NULL)
+		{
+			freeStart = current;
+		}
+		current += size;
+	}
+
+	if (freeStart != NULL)
+		MakeFreeSpace(freeStart, end - freeStart);
+
+	return liveBytes;
+}
+
+static void ClearMarkBits(HeapSegment* segment)
+{
+	memset(segment->markBits, 0, segment->start - (uint8_t*)segment->markBits);
+}
+
+static void Sweep()
+{
+	// Free list is rebuilt from scratch
+	freeList = NULL;
+
+	size_t liveBytes = 0;
+	for (HeapSegment** previous = &segments; *previous != NULL; )
+	{
+		auto segment = *previous;
+
+		if (!HasMarkedObjects(segment))
+		{
+			// Nothing alive, give memory back to the OS
+			*previous = segment->next;
+			if (segment == currentSegment)
+				currentSegment = NULL;
+			FreeVirtualMemory(segment, segment->end - (uint8_t*)segment);
+			continue;
+		}
+
+		liveBytes += SweepRange(segment, segment->start, segment->allocated);
+		previous = &segment->next;
+	}
+
+	liveBytesAfterFullCollection = liveBytes;
+	promotedBytesSinceFullCollection = 0;
+}
+
+static bool IsInYoungRegion(uint8_t* address)
+{
+	// Find last region starting before address (regions are sorted)
+	auto it = std::upper_bound(youngRegions.begin(), youngRegions.end(), address,
+		[](uint8_t* value, const YoungRegion& region) { return value < region.start; });
+	return it != youngRegions.begin() && address < (it - 1)->end;
+}
+
+// Only memory handed out since last collection can contain dead young objects
+// TODO: Release huge segments of dead young objects right away
+static void SweepYoungRegions()
+{
+	// Free space inside young regions (i.e. unused part of retired allocation contexts) is already in free list:
+	// unlink it, since sweeping these regions will add it again (merged with dead objects around it)
+	for (FreeObject** previous = &freeList; *previous != NULL; )
+	{
+		if (IsInYoungRegion((uint8_t*)*previous))
+			*previous = (*previous)->next;
+		else
+			previous = &(*previous)->next;
+	}
+
+	for (auto& region : youngRegions)
+		promotedBytesSinceFullCollection += SweepRange(FindSegment(region.start), region.start, region.end);
+}
+
+// Releases large objects that are not marked (only young ones during a young collection)
+static void SweepLargeObjects()
+{
+	for (LargeObject** previous = &largeObjects; *previous != NULL; )
+	{
+		auto largeObject = *previous;
+		if (largeObject->marked)
+		{
+			previous = &largeObject->next;
+			continue;
+		}
+
+		*previous = largeObject->next;
+		ReleaseLargeObject(largeObject);
+	}
+}
+
+// Note: heapLock should be held
+static void CollectGarbage(int generation)
+{
+	bool fullCollection = generation != 0;
+	bool finalizationQueued = false;
+
+	// Current thread needs to be attached before others are suspended (so that its stack range is known)
+	GetCurrentManagedThread();
+
+	// Other threads stop at their next safe point, so that they don't use heap or their allocation context while it is collected
+	SuspendManagedThreads();
+
+	// Make heap parsable
+	for (auto context = allocationContexts; context != NULL; context = context->next)
+		RetireAllocationContext(context);
+
+	// Sort segments and young regions for fast lookup during marking
+	sortedSegments.clear();
+	for (auto segment = segments; segment != NULL; segment = segment->next)
+		sortedSegments.push_back(segment);
+	std::sort(sortedSegments.begin(), sortedSegments.end());
+	std::sort(youngRegions.begin(), youngRegions.end());
+
+	sortedLargeObjects.clear();
+	for (auto largeObject = largeObjects; largeObject != NULL; largeObject = largeObject->next)
+		sortedLargeObjects.push_back(largeObject);
+	std::sort(sortedLargeObjects.begin(), sortedLargeObjects.end());
+
+	if (!sortedSegments.empty() || !sortedLargeObjects.empty())
+	{
+		heapLow = (uint8_t*)UINTPTR_MAX;
+		heapHigh = NULL;
+		if (!sortedSegments.empty())
+		{
+			heapLow = sortedSegments.front()->start;
+			heapHigh = sortedSegments.back()->allocated;
+		}
+		if (!sortedLargeObjects.empty())
+		{
+			heapLow = std::min(heapLow, GetLargeObjectStart(sortedLargeObjects.front()));
+			heapHigh = std::max(heapHigh, GetLargeObjectStart(sortedLargeObjects.back()) + sortedLargeObjects.back()->size);
+		}
+
+		// Full collection: old objects need to be traced again
+		if (fullCollection)
+		{
+			for (auto segment : sortedSegments)
+				ClearMarkBits(segment);
+			for (auto largeObject : sortedLargeObjects)
+				largeObject->marked = false;
+		}
+
+		// Mark
+		ScanCurrentStack();
+		EnumerateManagedThreads(ScanThread);
+		ScanDataSections();
+		if (!fullCollection)
+			ScanDirtyCards();
+		MarkConservativeRoots(fullCollection);
+
+		for (auto root : registeredRoots)
+			MarkObject(*root);
+
+		// Strong and pinned handles are roots (objects never move, so pinning needs nothing else)
+		LockHandleTable();
+		ScanHandles(HNDTYPE_STRONG, MarkHandle, NULL);
+		ScanHandles(HNDTYPE_PINNED, MarkHandle, NULL);
+
+		// Objects waiting for their finalizer are still alive
+		ScanFinalizationQueue(MarkObject);
+
+		// Queued thread pool work items
+		ScanThreadPoolQueues(MarkObject);
+
+		ProcessMarkStack();
+
+		// Weak handles don't keep their target alive (short ones are cleared before finalization resurrects objects)
+		ScanHandles(HNDTYPE_WEAK_SHORT, ClearDeadHandle, NULL);
+
+		finalizationQueued = ScanFinalizableObjects(IsAlive, MarkObject, fullCollection);
+		ProcessMarkStack();
+
+		ScanHandles(HNDTYPE_WEAK_LONG, ClearDeadHandle, NULL);
+		UnlockHandleTable();
+
+		FreeDeadSyncBlocks(IsAlive);
+
+		// Sweep
+		if (fullCollection)
+			Sweep();
+		else
+			SweepYoungRegions();
+		SweepLargeObjects();
+	}
+
+	// Survivors are old now, so there is no more old to young references to remember
+	youngRegions.clear();
+	memset(cardTable, 0, sizeof(cardTable));
+
+	collectionCount++;
+	if (fullCollection)
+	{
+		fullCollectionCount++;
+		largeObjectBytesAfterFullCollection = largeObjectBytes;
+		memoryPressureAfterFullCollection = memoryPressure;
+		fullCollectionBudget = std::max((size_t)MIN_COLLECTION_BUDGET, liveBytesAfterFullCollection + largeObjectBytesAfterFullCollection + memoryPressure);
+	}
+	bytesAllocatedSinceCollection = 0;
+	largeObjectBytesAllocatedSinceCollection = 0;
+	memoryPressureAddedSinceCollection = 0;
+
+	ResumeManagedThreads();
+
+	if (finalizationQueued)
+		StartFinalization();
+}
+
+void GarbageCollect(int generation)
+{
+	EnterHeapLock();
+	CollectGarbage(generation);
+	heapLock.Leave();
+}
+
+uint32_t GetCollectionCount(int generation)
+{
+	// Every collection collects young generation
+	return generation == 0 ? collectionCount : fullCollectionCount;
+}
+
+int GetGeneration(Object* obj)
+{
+	int generation = MAX_GENERATION;
+
+	EnterHeapLock();
+	for (auto segment = segments; segment != NULL; segment = segment->next)
+	{
+		if ((uint8_t*)obj >= segment->start && (uint8_t*)obj < segment->allocated)
+		{
+			// Objects not marked yet haven't survived any collection
+			if (!IsMarked(segment, (uint8_t*)obj))
+				generation = 0;
+			break;
+		}
+	}
+	for (auto largeObject = largeObjects; largeObject != NULL; largeObject = largeObject->next)
+	{
+		if ((Object*)GetLargeObjectStart(largeObject) == obj)
+		{
+			if (!largeObject->marked)
+				generation = 0;
+			break;
+		}
+	}
+	heapLock.Leave();
+
+	return generation;
+}
+
+size_t GetTotalBytesInUse()
+{
+	return liveBytesAfterFullCollection + promotedBytesSinceFullCollection + bytesAllocatedSinceCollection;
+}
+
+size_t GetLargeObjectBytesInUse()
+{
+	return largeObjectBytes;
+}
+
+void AddMemoryPressure(size_t bytesAllocated)
+{
+	EnterHeapLock();
+	memoryPressure += bytesAllocated;
+	memoryPressureAddedSinceCollection += bytesAllocated;
+	CollectIfBudgetExceeded();
+	heapLock.Leave();
+}
+
+void RemoveMemoryPressure(size_t bytesAllocated)
+{
+	EnterHeapLock();
+	memoryPressure -= std::min(memoryPressure, bytesAllocated);
+	memoryPressureAddedSinceCollection -= std::min(memoryPressureAddedSinceCollection, bytesAllocated);
+	heapLock.Leave();
+}
+
+void GetHeapStats(HeapStats* stats)
+{
+	EnterHeapLock();
+	stats->bytesInUse = GetTotalBytesInUse();
+	stats->largeObjectBytesInUse = largeObjectBytes;
+	stats->memoryPressure = memoryPressure;
+	stats->bytesAllocatedSinceCollection = GetBytesAllocatedSinceCollection();
+	stats->collectionBudget = NURSERY_BUDGET;
+	stats->promotedBytesSinceFullCollection = GetPromotedBytes();
+	stats->fullCollectionBudget = fullCollectionBudget;
+	stats->collectionCount = collectionCount;
+	stats->fullCollectionCount = fullCollectionCount;
+	heapLock.Leave();
+}
+
+extern "C" void getHeapStats(HeapStats* stats)
+{
+	GetHeapStats(stats);
+}
+
+extern "C" void suspendManagedThreads()
+{
+	// Collections suspend threads as well, and would wait for suspended threads
+	EnterHeapLock();
+	SuspendManagedThreads();
+}
+
+extern "C" void resumeManagedThreads()
+{
+	ResumeManagedThreads();
+	heapLock.Leave();
+}
+
+extern "C" void writeBarrier(void* address)
+{
+	cardTable[((uintptr_t)address >> CARD_SHIFT) & CARD_TABLE_MASK] = 1;
+}
+
+extern "C" void writeBarrierRange(void* address, size_t size)
+{
+	if (size == 0)
+		return;
+
+	auto lastCard = ((uintptr_t)address + size - 1) >> CARD_SHIFT;
+	for (auto card = (uintptr_t)address >> CARD_SHIFT; card <= lastCard; ++card)
+		cardTable[card & CARD_TABLE_MASK] = 1;
+}
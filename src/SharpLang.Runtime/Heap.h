@@ -0,0 +1,106 @@
+#ifndef SHARPLANG_HEAP_H
+#define SHARPLANG_HEAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class Object;
+class ArrayBase;
+class MethodTable;
+typedef MethodTable EEType;
+
+// All heap allocations are rounded up to this alignment
+#define HEAP_ALIGNMENT 8
+#define HEAP_ALIGN(size) (((size) + (HEAP_ALIGNMENT - 1)) & ~(size_t)(HEAP_ALIGNMENT - 1))
+
+// Per-thread allocation context: objects are bump allocated in [allocPtr, allocLimit).
+// Memory in this range has already been zeroed.
+struct AllocationContext
+{
+	uint8_t* allocPtr;
+	uint8_t* allocLimit;
+
+	// Contexts are registered on first use, so that GC can retire them
+	AllocationContext* next;
+	bool registered;
+};
+
+AllocationContext* GetAllocationContext();
+
+// Called when current thread exits: remaining space is retired, and context is unregistered
+void ReleaseAllocationContext();
+
+// Allocates zeroed memory in the managed heap
+void* AllocateMemory(size_t size);
+
+// Allocates a zeroed object and setup its EEType
+Object* AllocateObject(EEType* eeType);
+Object* AllocateObject(EEType* eeType, size_t size);
+
+// Allocates an array, with its elements stored right after the header
+ArrayBase* AllocateArray(EEType* arrayType, size_t length);
+
+// Size taken by an object in the heap (including array elements and string characters)
+size_t GetObjectSize(Object* obj);
+
+// Roots outside of stack and data sections (i.e. malloc memory) need to be registered
+void RegisterGCRoot(Object** root);
+void UnregisterGCRoot(Object** root);
+
+// Objects are young (generation 0) until they survive a collection, then they are old (max generation)
+#define MAX_GENERATION 2
+
+// Objects at least that big are allocated in the large object space, in their own mapping
+size_t GetLargeObjectThreshold();
+
+// Performs a blocking collection (young objects only if generation is 0, full otherwise)
+void GarbageCollect(int generation);
+uint32_t GetCollectionCount(int generation);
+
+int GetGeneration(Object* obj);
+
+// Bytes used by small objects and by the large object space
+size_t GetTotalBytesInUse();
+size_t GetLargeObjectBytesInUse();
+
+// Unmanaged memory kept alive by managed objects: it counts as allocated (young collection budget) and promoted (full collection budget)
+void AddMemoryPressure(size_t bytesAllocated);
+void RemoveMemoryPressure(size_t bytesAllocated);
+
+// Snapshot of heap usage and collection budgets
+struct HeapStats
+{
+	size_t bytesInUse;
+	size_t largeObjectBytesInUse;
+	size_t memoryPressure;
+
+	// A young collection happens when this goes over collectionBudget (includes large objects and memory pressure)
+	size_t bytesAllocatedSinceCollection;
+	size_t collectionBudget;
+
+	// Collection is a full one when this goes over fullCollectionBudget
+	size_t promotedBytesSinceFullCollection;
+	size_t fullCollectionBudget;
+
+	uint32_t collectionCount;
+	uint32_t fullCollectionCount;
+};
+
+void GetHeapStats(HeapStats* stats);
+
+// Write barrier: needs to be called after storing references in heap memory
+extern "C" void writeBarrier(void* address);
+extern "C" void writeBarrierRange(void* address, size_t size);
+
+// Used by generated code for newobj/newarr
+extern "C" Object* allocObject(EEType* eeType, size_t size);
+
+// Can be used by host or native code to query heap statistics
+extern "C" void getHeapStats(HeapStats* stats);
+
+// Can be used by host or native code (i.e. a sampling profiler) to stop every other managed thread at a safe point.
+// No collection happens until threads are resumed. Time-to-safepoint is recorded (see getSafepointStats).
+extern "C" void suspendManagedThreads();
+extern "C" void resumeManagedThreads();
+
+#endif
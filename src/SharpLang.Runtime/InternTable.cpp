@@ -0,0 +1,189 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "RuntimeType.h"
+#include "HandleTable.h"
+#include "SpinLock.h"
+#include "InternTable.h"
+
+// Strings are spread over independently locked shards, using highest bits of their hash (needs to be a power of two)
+#define INTERN_SHARD_COUNT 16
+#define INTERN_SHARD_SHIFT 28
+
+// Needs to be a power of two
+#define INITIAL_SHARD_SIZE 64
+
+struct InternEntry
+{
+	uint32_t hash;
+	StringObject* value;
+};
+
+// Open addressing table, only using zero-initialized state so that module initializers can use it at any time
+struct InternShard
+{
+	SpinLock lock;
+	InternEntry* entries;
+	size_t size;
+	size_t count;
+};
+
+static InternShard internShards[INTERN_SHARD_COUNT];
+
+static inline uint32_t HashChars(const char16_t* chars, uint32_t length)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261U;
+	for (uint32_t i = 0; i < length; ++i)
+	{
+		hash ^= chars[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static inline InternShard& GetShard(uint32_t hash)
+{
+	return internShards[hash >> INTERN_SHARD_SHIFT];
+}
+
+// Note: shard lock should be held
+static InternEntry* FindEntry(InternEntry* entries, size_t size, uint32_t hash, const char16_t* chars, uint32_t length)
+{
+	// Linear probing: returns matching entry, or empty entry where it should be inserted
+	auto mask = size - 1;
+	for (auto index = hash & mask; ; index = (index + 1) & mask)
+	{
+		auto entry = &entries[index];
+		if (entry->value == NULL)
+			return entry;
+
+		if (entry->hash == hash
+			&& entry->value->length == length
+			&& memcmp(&entry->value->firstChar, chars, sizeof(char16_t) * length) == 0)
+			return entry;
+	}
+}
+
+// Note: shard lock should be held
+static void GrowShard(InternShard& shard)
+{
+	auto size = shard.size == 0 ? INITIAL_SHARD_SIZE : shard.size * 2;
+	auto entries = (InternEntry*)calloc(size, sizeof(InternEntry));
+	if (entries == NULL)
+	{
+		// TODO: Throw OutOfMemoryException
+		abort();
+	}
+
+	for (size_t i = 0; i < shard.size; ++i)
+	{
+		auto& entry = shard.entries[i];
+		if (entry.value != NULL)
+		{
+			auto mask = size - 1;
+			auto index = entry.hash & mask;
+			while (entries[index].value != NULL)
+				index = (index + 1) & mask;
+			entries[index] = entry;
+		}
+	}
+
+	free(shard.entries);
+	shard.entries = entries;
+	shard.size = size;
+}
+
+static StringObject* Find(InternShard& shard, uint32_t hash, const char16_t* chars, uint32_t length)
+{
+	StringObject* result = NULL;
+
+	shard.lock.Enter();
+	if (shard.size > 0)
+		result = FindEntry(shard.entries, shard.size, hash, chars, length)->value;
+	shard.lock.Leave();
+
+	return result;
+}
+
+// Looks up string content; if missing, inserts value returned by createValue (can't be NULL)
+// createValue can allocate (and trigger a GC, which would wait for any thread spinning on the shard lock),
+// so it runs outside of the lock; if another thread inserted the same content meanwhile, the handle it created is destroyed
+template <class CreateValue>
+static StringObject* FindOrAdd(const char16_t* chars, uint32_t length, CreateValue createValue)
+{
+	auto hash = HashChars(chars, length);
+	auto& shard = GetShard(hash);
+
+	auto result = Find(shard, hash, chars, length);
+	if (result != NULL)
+		return result;
+
+	GCHandle* handle = NULL;
+	auto value = createValue(handle);
+
+	shard.lock.Enter();
+
+	// Keep table at most half full
+	if ((shard.count + 1) * 2 > shard.size)
+		GrowShard(shard);
+
+	auto entry = FindEntry(shard.entries, shard.size, hash, chars, length);
+	if (entry->value == NULL)
+	{
+		entry->hash = hash;
+		entry->value = value;
+		shard.count++;
+	}
+
+	result = entry->value;
+	shard.lock.Leave();
+
+	if (result != value && handle != NULL)
+		DestroyHandle(handle);
+
+	return result;
+}
+
+StringObject* InternString(StringObject* str)
+{
+	return FindOrAdd(&str->firstChar, str->length, [=](GCHandle*& handle)
+	{
+		// Table memory is not scanned by GC, so keep interned heap strings alive with a handle
+		handle = CreateHandle(str, HNDTYPE_STRONG);
+		return str;
+	});
+}
+
+StringObject* InternString(const char16_t* chars, uint32_t length)
+{
+	return FindOrAdd(chars, length, [=](GCHandle*& handle)
+	{
+		auto str = StringObject::NewString(chars, length);
+		handle = CreateHandle(str, HNDTYPE_STRONG);
+		return str;
+	});
+}
+
+StringObject* InternString(const char16_t* chars)
+{
+	return InternString(chars, std::char_traits<char16_t>::length(chars));
+}
+
+StringObject* FindInternedString(StringObject* str)
+{
+	auto hash = HashChars(&str->firstChar, str->length);
+	return Find(GetShard(hash), hash, &str->firstChar, str->length);
+}
+
+extern "C" void registerStringLiterals(StringObject** literalSlots[], uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		// Literals are not in the heap, they don't need a handle
+		auto literal = *literalSlots[i];
+		*literalSlots[i] = FindOrAdd(&literal->firstChar, literal->length, [=](GCHandle*&) { return literal; });
+	}
+}
@@ -0,0 +1,21 @@
+#ifndef SHARPLANG_INTERN_TABLE_H
+#define SHARPLANG_INTERN_TABLE_H
+
+#include <stdint.h>
+
+class StringObject;
+
+// Returns the interned string with same content, interning str itself if there is none yet.
+// Interned strings are kept alive forever.
+StringObject* InternString(StringObject* str);
+StringObject* InternString(const char16_t* chars, uint32_t length);
+StringObject* InternString(const char16_t* chars);
+
+// Returns the interned string with same content, or NULL if none
+StringObject* FindInternedString(StringObject* str);
+
+// Called by module initializers with the slots through which generated code loads string literals:
+// each slot is updated to the interned string with same content, so that literals are unique across modules
+extern "C" void registerStringLiterals(StringObject** literalSlots[], uint32_t count);
+
+#endif
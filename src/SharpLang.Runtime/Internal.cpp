@@ -1,12 +1,23 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
 #include "RuntimeType.h"
 #include "ConvertUTF.h"
+#include "Heap.h"
+#include "HandleTable.h"
+#include "InternTable.h"
+#include "Finalizer.h"
+#include "ObjectHeader.h"
+#include "Monitor.h"
+#include "ManagedThread.h"
+#include "ThreadPool.h"
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <thread>
+#include <sched.h>
 #include <sys/utsname.h>
 #endif
 //#include "corhdr.h"
@@ -14,18 +25,6 @@
 #define ELEMENT_TYPE_SZARRAY 0x1d
 #define ELEMENT_TYPE_ARRAY 0x14
 
-static Object* AllocateObject(EEType* eeType)
-{
-	auto objectSize = eeType->objectSize;
-	Object* object = (Object*) malloc(objectSize);
-
-	// TODO: Maybe we could avoid zero-ing memory in various cases?
-	memset(object, 0, objectSize);
-
-	object->eeType = eeType;
-	return object;
-}
-
 // TODO: Emit IL directly?
 extern "C" Object* System_SharpLangHelper__UnsafeCast_System_Object_System_Object_(Object* obj)
 {
@@ -42,28 +41,23 @@ extern "C" Object* System_SharpLangHelper__GetObjectFromPointer_System_Void__(vo
 	return (Object*)obj;
 }
 
+extern "C" void System_SharpLangHelper__GetInterfaceCallCacheStats_System_Void__(void* stats)
+{
+	getInterfaceCallCacheStats((InterfaceCallCacheStats*)stats);
+}
+
 extern "C" Object* System_Object__MemberwiseClone__(Object* obj)
 {
-	// Object size
-	auto length = obj->eeType->objectSize;
+	// Object size (including array elements)
+	auto length = GetObjectSize(obj);
 
 	// Allocate new object of same size
-	auto objCopy = (Object*)malloc(length);
+	auto objCopy = AllocateObject(obj->eeType, length);
 
 	// Blindly copy data
-	// TODO: Improve this with write barrier?
+	// Note: no write barrier needed, copy is a young object
 	memcpy(objCopy, obj, length);
 
-	// Array: Copy referenced data as well
-	if (obj->eeType->corElementType == ELEMENT_TYPE_SZARRAY || obj->eeType->corElementType == ELEMENT_TYPE_ARRAY)
-	{
-		auto array = (ArrayBase*) obj;
-		auto arrayDataSize = array->length * array->eeType->elementSize;
-		auto arrayDataCopy = (uint8_t*) malloc(arrayDataSize);
-		memcpy(arrayDataCopy, array->GetDataPtr(), arrayDataSize);
-		((ArrayBase*) objCopy)->SetDataPtr(arrayDataCopy);
-	}
-
 	return objCopy;
 }
 
@@ -76,8 +70,10 @@ extern "C" Object* System_Object__GetType__(Object* obj)
 
 extern "C" int32_t System_Runtime_CompilerServices_RuntimeHelpers__GetHashCode_System_Object_(Object* obj)
 {
-	// We don't have a GC yet, so use object address
-	return (int32_t)(intptr_t)obj;
+	if (obj == NULL)
+		return 0;
+
+	return GetObjectHashCode(obj);
 }
 
 extern "C" bool System_Type__EqualsInternal_System_Type_(RuntimeType* a, RuntimeType* b)
@@ -95,16 +91,14 @@ extern "C" bool System_RuntimeTypeHandle__IsInterface_System_RuntimeType_(Runtim
 
 extern "C" bool System_RuntimeTypeHandle__CanCastTo_System_RuntimeType_System_RuntimeType_(RuntimeType* type, RuntimeType* target)
 {
-	// TODO: Covariance/contravariance
-	// TODO: type is interface?
+	// Use EE types (when available), rather than having to resolve System.Type at every step
+	if (type->runtimeEEType != NULL && target->runtimeEEType != NULL)
+		return CanCastTo(type->runtimeEEType, target->runtimeEEType);
+
 	if (System_RuntimeTypeHandle__IsInterface_System_RuntimeType_(target))
-	{
-		// Currently not supported
-		return isInstInterface(type->runtimeEEType, target->runtimeEEType);
-	}
+		return false;
 
-	// Note: using EE type (when available) is probably faster than having to resolve System.Type at every step
-	return System_RuntimeType__IsSubclassOf_System_Type_(target, type);
+	return System_RuntimeType__IsSubclassOf_System_Type_(type, target);
 }
 
 extern "C" Object* System_RuntimeTypeHandle__CreateInstance_System_RuntimeType_System_Boolean_System_Boolean_System_Boolean__System_RuntimeMethodHandleInternal__System_Boolean__(RuntimeType* type, bool publicOnly, bool noCheck, bool* canBeCached, void* ctor, bool* needSecurityCheck)
@@ -158,7 +152,12 @@ extern "C" bool System_Array__Copy_System_Array_System_Int32_System_Array_System
 	// Get element size
 	int32_t elementSize = source->eeType->elementSize;
 
-	memcpy((void*)(dest->value + destIndex * elementSize), (const void*)(source->value + sourceIndex * elementSize), elementSize * length);
+	// Ranges might overlap when copying inside the same array
+	memmove((void*)(dest->value + destIndex * elementSize), (const void*)(source->value + sourceIndex * elementSize), elementSize * length);
+
+	// Elements might contain references
+	if (dest->eeType->garbageCollectableFieldCount > 0)
+		writeBarrierRange((void*)(dest->value + destIndex * elementSize), elementSize * length);
 
 	return true;
 }
@@ -175,12 +174,7 @@ extern "C" ArrayBase* System_Array__CreateInstanceImpl_System_Type_System_Int32_
 
 	auto arrayType = System_SharpLangType__MakeArrayType__(elementType);
 
-	auto result = (Array<uint8_t>*)malloc(sizeof(Array<uint8_t>));
-	result->eeType = arrayType->runtimeEEType;
-	result->length = length;
-	result->value = (uint8_t*) malloc(result->eeType->elementSize * length);
-
-	return result;
+	return AllocateArray(arrayType->runtimeEEType, length);
 }
 
 extern "C" int32_t System_Environment__get_Platform__()
@@ -267,20 +261,236 @@ extern "C" StringObject* System_Environment__GetOSVersionString__()
 #endif
 }
 
+// Exceptions thrown by runtime are created with their default constructor
+extern "C" void throwException(Object* obj);
+extern EEType System_ArgumentNullException_rtti;
+extern EEType System_Threading_SynchronizationLockException_rtti;
+extern EEType System_Threading_ThreadStateException_rtti;
+extern "C" void System_ArgumentNullException___ctor__(Object* obj);
+extern "C" void System_Threading_SynchronizationLockException___ctor__(Object* obj);
+extern "C" void System_Threading_ThreadStateException___ctor__(Object* obj);
+
+static void ThrowNewException(EEType* eeType, void (*constructor)(Object* obj))
+{
+	auto exception = AllocateObject(eeType);
+	constructor(exception);
+	throwException(exception);
+}
+
+extern "C" void System_Threading_Monitor__Enter_System_Object_(Object* object)
+{
+	if (object == NULL)
+		ThrowNewException(&System_ArgumentNullException_rtti, System_ArgumentNullException___ctor__);
+
+	MonitorEnter(object, -1);
+}
+
 extern "C" void System_Threading_Monitor__ReliableEnter_System_Object_System_Boolean__(Object* object, bool& lockTaken)
 {
-	// Not implemented yet
-	lockTaken = true;
+	if (object == NULL)
+		ThrowNewException(&System_ArgumentNullException_rtti, System_ArgumentNullException___ctor__);
+
+	lockTaken = MonitorEnter(object, -1);
+}
+
+extern "C" void System_Threading_Monitor__ReliableEnterTimeout_System_Object_System_Int32_System_Boolean__(Object* object, int32_t timeout, bool& lockTaken)
+{
+	if (object == NULL)
+		ThrowNewException(&System_ArgumentNullException_rtti, System_ArgumentNullException___ctor__);
+
+	lockTaken = MonitorEnter(object, timeout);
 }
 
 extern "C" void System_Threading_Monitor__Exit_System_Object_(Object* object)
 {
-	// Not implemented yet
+	if (object == NULL)
+		ThrowNewException(&System_ArgumentNullException_rtti, System_ArgumentNullException___ctor__);
+
+	if (!MonitorExit(object))
+		ThrowNewException(&System_Threading_SynchronizationLockException_rtti, System_Threading_SynchronizationLockException___ctor__);
+}
+
+extern "C" bool System_Threading_Monitor__IsEnteredNative_System_Object_(Object* object)
+{
+	return MonitorIsEntered(object);
+}
+
+extern "C" bool System_Threading_Monitor__ObjWait_System_Boolean_System_Int32_System_Object_(bool exitContext, int32_t timeout, Object* object)
+{
+	if (!MonitorIsEntered(object))
+		ThrowNewException(&System_Threading_SynchronizationLockException_rtti, System_Threading_SynchronizationLockException___ctor__);
+
+	return MonitorWait(object, timeout);
+}
+
+extern "C" void System_Threading_Monitor__ObjPulse_System_Object_(Object* object)
+{
+	if (!MonitorIsEntered(object))
+		ThrowNewException(&System_Threading_SynchronizationLockException_rtti, System_Threading_SynchronizationLockException___ctor__);
+
+	MonitorPulse(object);
 }
 
+extern "C" void System_Threading_Monitor__ObjPulseAll_System_Object_(Object* object)
+{
+	if (!MonitorIsEntered(object))
+		ThrowNewException(&System_Threading_SynchronizationLockException_rtti, System_Threading_SynchronizationLockException___ctor__);
+
+	MonitorPulseAll(object);
+}
+
+// Calls are usually replaced by a fence by the compiler, this is only used for indirect calls
 extern "C" void System_Threading_Thread__MemoryBarrier__()
 {
-	// Not implemented yet
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+extern "C" void System_Threading_Thread__SetStart_System_Delegate_System_Int32_(ThreadBaseObject* thread, Object* start, int32_t maxStackSize)
+{
+	thread->m_Delegate = start;
+	writeBarrier(&thread->m_Delegate);
+
+	CreateManagedThread(thread, maxStackSize > 0 ? (size_t)maxStackSize : 0);
+}
+
+extern "C" void System_Threading_Thread__StartInternal_System_Security_Principal_IPrincipal_System_Threading_StackCrawlMark__(ThreadBaseObject* thread, Object* principal, int32_t* stackMark)
+{
+	if (thread->m_Delegate == NULL || !StartManagedThread(thread->m_InternalThread))
+		ThrowNewException(&System_Threading_ThreadStateException_rtti, System_Threading_ThreadStateException___ctor__);
+}
+
+extern "C" bool System_Threading_Thread__JoinInternal_System_Int32_(ThreadBaseObject* thread, int32_t timeout)
+{
+	if (GetManagedThreadState(thread->m_InternalThread) & THREAD_STATE_UNSTARTED)
+		ThrowNewException(&System_Threading_ThreadStateException_rtti, System_Threading_ThreadStateException___ctor__);
+
+	return JoinManagedThread(thread->m_InternalThread, timeout);
+}
+
+extern "C" void System_Threading_Thread__SleepInternal_System_Int32_(int32_t timeout)
+{
+	SleepCurrentThread(timeout);
+}
+
+extern "C" void System_Threading_Thread__SpinWaitInternal_System_Int32_(int32_t iterations)
+{
+	for (int32_t i = 0; i < iterations; ++i)
+	{
+#if defined(__i386__) || defined(__x86_64__)
+		__builtin_ia32_pause();
+#endif
+	}
+}
+
+extern "C" int32_t System_Threading_Thread__get_ManagedThreadId__(ThreadBaseObject* thread)
+{
+	return thread->m_ManagedThreadId;
+}
+
+extern "C" bool System_Threading_Thread__get_IsAlive__(ThreadBaseObject* thread)
+{
+	return (GetManagedThreadState(thread->m_InternalThread) & (THREAD_STATE_UNSTARTED | THREAD_STATE_STOPPED)) == 0;
+}
+
+extern "C" bool System_Threading_Thread__get_IsThreadPoolThread__(ThreadBaseObject* thread)
+{
+	return thread == GetCurrentThreadObject() && IsThreadPoolWorkerThread();
+}
+
+extern "C" bool System_Threading_Thread__IsBackgroundNative__(ThreadBaseObject* thread)
+{
+	return (GetManagedThreadState(thread->m_InternalThread) & THREAD_STATE_BACKGROUND) != 0;
+}
+
+extern "C" void System_Threading_Thread__SetBackgroundNative_System_Boolean_(ThreadBaseObject* thread, bool isBackground)
+{
+	SetManagedThreadBackground(thread->m_InternalThread, isBackground);
+}
+
+extern "C" int32_t System_Threading_Thread__GetThreadStateNative__(ThreadBaseObject* thread)
+{
+	return GetManagedThreadState(thread->m_InternalThread);
+}
+
+// Priority is only recorded, native thread priority stays the same
+extern "C" int32_t System_Threading_Thread__GetPriorityNative__(ThreadBaseObject* thread)
+{
+	return thread->m_Priority;
+}
+
+extern "C" void System_Threading_Thread__SetPriorityNative_System_Int32_(ThreadBaseObject* thread, int32_t priority)
+{
+	thread->m_Priority = priority;
+}
+
+extern "C" void System_Threading_Thread__InternalFinalize__(ThreadBaseObject* thread)
+{
+	if (thread->m_InternalThread != NULL)
+	{
+		ReleaseManagedThread(thread->m_InternalThread);
+		thread->m_InternalThread = NULL;
+	}
+}
+
+// Work items are queued natively (see ThreadPool.cpp)
+extern "C" void System_Threading_ThreadPool__EnqueueWorkItemNative_System_Threading_IThreadPoolWorkItem_System_Boolean_(Object* workItem, bool forceGlobal)
+{
+	ThreadPoolEnqueue(workItem, forceGlobal);
+}
+
+extern "C" Object* System_Threading_ThreadPool__DequeueWorkItemNative__()
+{
+	return ThreadPoolDequeue();
+}
+
+extern "C" bool System_Threading_ThreadPool__LocalFindAndPopNative_System_Threading_IThreadPoolWorkItem_(Object* workItem)
+{
+	return ThreadPoolTryPopLocal(workItem);
+}
+
+extern "C" bool System_Threading_ThreadPool__SetMinThreadsNative_System_Int32_System_Int32_(int32_t workerThreads, int32_t completionPortThreads)
+{
+	return ThreadPoolSetMinThreads(workerThreads, completionPortThreads);
+}
+
+extern "C" bool System_Threading_ThreadPool__SetMaxThreadsNative_System_Int32_System_Int32_(int32_t workerThreads, int32_t completionPortThreads)
+{
+	return ThreadPoolSetMaxThreads(workerThreads, completionPortThreads);
+}
+
+extern "C" void System_Threading_ThreadPool__GetMinThreadsNative_System_Int32__System_Int32__(int32_t* workerThreads, int32_t* completionPortThreads)
+{
+	ThreadPoolGetMinThreads(workerThreads, completionPortThreads);
+}
+
+extern "C" void System_Threading_ThreadPool__GetMaxThreadsNative_System_Int32__System_Int32__(int32_t* workerThreads, int32_t* completionPortThreads)
+{
+	ThreadPoolGetMaxThreads(workerThreads, completionPortThreads);
+}
+
+extern "C" void System_Threading_ThreadPool__GetAvailableThreadsNative_System_Int32__System_Int32__(int32_t* workerThreads, int32_t* completionPortThreads)
+{
+	ThreadPoolGetAvailableThreads(workerThreads, completionPortThreads);
+}
+
+extern "C" bool System_Threading_ThreadPool__NotifyWorkItemComplete__()
+{
+	return ThreadPoolNotifyWorkItemComplete();
+}
+
+extern "C" void System_Threading_ThreadPool__NotifyWorkItemProgressNative__()
+{
+	ThreadPoolNotifyWorkItemProgress();
+}
+
+// Worker tracking is disabled (see InitializeVMTp)
+extern "C" void System_Threading_ThreadPool__ReportThreadStatus_System_Boolean_(bool isWorking)
+{
+}
+
+extern "C" bool System_Threading_ThreadPool__IsThreadPoolHosted__()
+{
+	return false;
 }
 
 extern "C" StringObject* System_Text_Encoding__InternalCodePage_System_Int32__(int32_t* code_page)
@@ -292,8 +502,7 @@ extern "C" StringObject* System_Text_Encoding__InternalCodePage_System_Int32__(i
 
 extern "C" StringObject* System_Environment__GetNewLine__()
 {
-	// TODO: String RTTI
-	static StringObject* newline = StringObject::NewString(u"\r\n");
+	static StringObject* newline = InternString(u"\r\n");
 	return newline;
 }
 
@@ -315,7 +524,8 @@ extern "C" StringObject* System_String__FastAllocateString_System_Int32_(int32_t
 
 extern "C" int32_t System_String__GetLOSLimit__()
 {
-	return INT32_MAX;
+	// Longest string that is not allocated in the large object space
+	return (int32_t)std::min((GetLargeObjectThreshold() - sizeof(StringObject) - 1) / sizeof(char16_t), (size_t)INT32_MAX);
 }
 
 extern "C" RuntimeType* System_Type__GetTypeFromHandle_System_RuntimeTypeHandle_(RuntimeType* runtimeType)
@@ -326,15 +536,13 @@ extern "C" RuntimeType* System_Type__GetTypeFromHandle_System_RuntimeTypeHandle_
 extern "C" StringObject* System_Globalization_CultureInfo__get_current_locale_name__()
 {
 	// Redirect to invariant culture by using an empty string ("")
-	// TODO: mechanism to setup VTable
-	static StringObject* locale = StringObject::NewString(u"");
+	static StringObject* locale = InternString(u"");
 	return locale;
 }
 
 extern "C" Object* System_Threading_Thread__GetCurrentThreadNative__()
 {
-	static ThreadBaseObject* thread = (ThreadBaseObject*)AllocateObject(&System_Threading_Thread_rtti);
-	return thread;
+	return GetCurrentThreadObject();
 }
 
 extern "C" int32_t System_AppDomain__GetId__()
@@ -358,6 +566,16 @@ extern "C" bool System_AppDomain__IsUnloadingForcedFinalize__(AppDomain* domain)
 	return false;
 }
 
+extern "C" StringObject* System_AppDomain__GetOrInternString_System_String_(AppDomain* domain, StringObject* str)
+{
+	return InternString(str);
+}
+
+extern "C" StringObject* System_AppDomain__IsStringInterned_System_String_(AppDomain* domain, StringObject* str)
+{
+	return FindInternedString(str);
+}
+
 extern "C" int32_t System_BCLDebug__GetRegistryLoggingValues_System_Boolean__System_Boolean__System_Int32__System_Boolean__System_Boolean__System_Boolean__(bool& loggingEnabled, bool& logToConsole, int32_t& logLevel, bool& perfWarnings, bool& correctnessWarnings, bool& safeHandleStackTraces)
 {
 	auto logFacility = 0;
@@ -394,6 +612,12 @@ extern "C" Object* System_GC__get_ephemeron_tombstone__()
 
 extern "C" void System_GC___SuppressFinalize_System_Object_(Object* obj)
 {
+	SuppressFinalization(obj);
+}
+
+extern "C" void System_GC___ReRegisterForFinalize_System_Object_(Object* obj)
+{
+	ReRegisterForFinalization(obj);
 }
 
 extern "C" void System_Buffer__InternalBlockCopy_System_Array_System_Int32_System_Array_System_Int32_System_Int32_(Array<uint8_t>* src, int32_t srcOffset, Array<uint8_t>* dst, int32_t dstOffset, int32_t count)
@@ -467,6 +691,26 @@ extern "C" __declspec(dllexport) bool __stdcall InternalUseRandomizedHashing()
 	return false;
 }
 
+extern "C" __declspec(dllexport) bool __stdcall YieldInternal()
+{
+#ifdef _WIN32
+	return SwitchToThread() != 0;
+#else
+	return sched_yield() == 0;
+#endif
+}
+
+extern "C" __declspec(dllexport) bool __stdcall RequestWorkerThread()
+{
+	ThreadPoolRequestWorker();
+	return true;
+}
+
+extern "C" __declspec(dllexport) void __stdcall InitializeVMTp(bool* enableWorkerTracking)
+{
+	*enableWorkerTracking = false;
+}
+
 extern "C" __declspec(dllexport) int32_t __stdcall GetProcessorCount()
 {
 #ifdef _WIN32
@@ -497,9 +741,6 @@ extern "C" __declspec(dllexport) void* __stdcall NativeInternalInitSortHandle(ch
 
 extern "C" __declspec(dllexport) void* __stdcall GetGCHandle(RuntimeType* runtimeType, int32_t handleType)
 {
-	auto gcHandle = (GCHandle*)malloc(sizeof(GCHandle));
-	gcHandle->runtimeType = runtimeType;
-	gcHandle->value = NULL;
-	gcHandle->handleType = handleType;
-	return gcHandle;
+	// TODO: Handle should be freed with the type (if it is ever unloaded)
+	return CreateHandle(NULL, handleType);
 }
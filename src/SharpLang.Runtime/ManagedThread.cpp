@@ -0,0 +1,918 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/ucontext.h>
+#endif
+
+#include "RuntimeType.h"
+#include "Heap.h"
+#include "SpinLock.h"
+#include "ObjectHeader.h"
+#include "Finalizer.h"
+#include "ManagedThread.h"
+
+// Stack size of started threads can't go below that (runtime and GC need some room too)
+#define MIN_THREAD_STACK_SIZE (64 * 1024)
+
+// Defined in mscorlib
+extern EEType System_Threading_ParameterizedThreadStart_rtti;
+
+// Mirrors System.Delegate fields: _methodPtr(_target, args...) invokes the delegate
+class DelegateObject : public Object
+{
+public:
+	Object* _target;
+	Object* _methodBase;
+	void* _methodPtr;
+	void* _methodPtrAux;
+};
+
+// Attached threads, and threads started but not running yet.
+// GC holds this lock while threads are suspended, so it must only be taken in preemptive mode.
+static SpinLock threadsLock;
+static ManagedThread* threads;
+
+// Set while a collection is in progress (threads leaving preemptive mode wait until it is cleared)
+static std::atomic<bool> suspendRequested;
+
+// Polled by generated code: set and cleared along with suspendRequested, which is checked again once in safepointPoll
+volatile uint32_t safepointPollFlag = 0;
+
+// Generated code might poll before static initialization allocates the guard page: it reads a regular byte until then
+static volatile uint8_t safepointPollPlaceholder;
+volatile uint8_t* safepointPollPage = &safepointPollPlaceholder;
+static size_t safepointPollPageSize;
+
+// Set once a module compiled with guard page polls is loaded (page protection is only changed during suspensions after that)
+static std::atomic<bool> safepointGuardPageEnabled;
+
+// Whether current suspension made the poll page unreadable (protected by threadsLock)
+static bool safepointGuardPageArmed;
+
+// Time-to-safepoint statistics (protected by safepointStatsLock)
+static SpinLock safepointStatsLock;
+static SafepointStats safepointStats;
+
+static SpinLock threadIdsLock;
+static std::vector<uint32_t>* freeThreadIds;
+static uint32_t lastThreadId;
+
+static thread_local ManagedThread* currentThread;
+
+// Threads waiting for a collection to be over, or for another thread to finish (protected by threadsMutex)
+#ifdef _WIN32
+static SRWLOCK threadsMutex = SRWLOCK_INIT;
+static CONDITION_VARIABLE resumeCondition = CONDITION_VARIABLE_INIT;
+static CONDITION_VARIABLE threadFinishedCondition = CONDITION_VARIABLE_INIT;
+#else
+static pthread_mutex_t threadsMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t resumeCondition = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t threadFinishedCondition = PTHREAD_COND_INITIALIZER;
+#endif
+static uint32_t foregroundThreadCount;
+static bool exitWaitRegistered;
+
+typedef std::chrono::steady_clock::time_point WaitDeadline;
+
+static void LockThreads()
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&threadsMutex);
+#else
+	pthread_mutex_lock(&threadsMutex);
+#endif
+}
+
+static void UnlockThreads()
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&threadsMutex);
+#else
+	pthread_mutex_unlock(&threadsMutex);
+#endif
+}
+
+// Returns false if deadline expired (no deadline means infinite wait)
+#ifdef _WIN32
+static bool WaitThreads(CONDITION_VARIABLE* condition, const WaitDeadline* deadline)
+{
+	DWORD timeout = INFINITE;
+	if (deadline != NULL)
+	{
+		auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now()).count();
+		if (remaining <= 0)
+			return false;
+		timeout = (DWORD)remaining;
+	}
+
+	return SleepConditionVariableSRW(condition, &threadsMutex, timeout, 0) || GetLastError() != ERROR_TIMEOUT;
+}
+
+static void WakeThreads(CONDITION_VARIABLE* condition)
+{
+	WakeAllConditionVariable(condition);
+}
+#else
+static bool WaitThreads(pthread_cond_t* condition, const WaitDeadline* deadline)
+{
+	if (deadline == NULL)
+	{
+		pthread_cond_wait(condition, &threadsMutex);
+		return true;
+	}
+
+	auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - std::chrono::steady_clock::now()).count();
+	if (remaining <= 0)
+		return false;
+
+	// Condition uses realtime clock
+	struct timespec absoluteTimeout;
+	clock_gettime(CLOCK_REALTIME, &absoluteTimeout);
+	absoluteTimeout.tv_sec += (time_t)(remaining / 1000000000);
+	absoluteTimeout.tv_nsec += (long)(remaining % 1000000000);
+	if (absoluteTimeout.tv_nsec >= 1000000000)
+	{
+		absoluteTimeout.tv_sec++;
+		absoluteTimeout.tv_nsec -= 1000000000;
+	}
+
+	return pthread_cond_timedwait(condition, &threadsMutex, &absoluteTimeout) != ETIMEDOUT;
+}
+
+static void WakeThreads(pthread_cond_t* condition)
+{
+	pthread_cond_broadcast(condition);
+}
+#endif
+
+static inline void YieldThread()
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+static uint8_t* GetStackBase()
+{
+#ifdef _WIN32
+	return (uint8_t*)((NT_TIB*)NtCurrentTeb())->StackBase;
+#elif defined(__APPLE__)
+	return (uint8_t*)pthread_get_stackaddr_np(pthread_self());
+#else
+	pthread_attr_t attributes;
+	void* stackAddress;
+	size_t stackSize;
+	pthread_getattr_np(pthread_self(), &attributes);
+	pthread_attr_getstack(&attributes, &stackAddress, &stackSize);
+	pthread_attr_destroy(&attributes);
+	return (uint8_t*)stackAddress + stackSize;
+#endif
+}
+
+// Default stack size of started threads can be configured like in CoreCLR (hexadecimal value), 0 means platform default
+static size_t GetDefaultStackSize()
+{
+	auto value = getenv("COMPlus_DefaultStackSize");
+	return value != NULL ? (size_t)strtoull(value, NULL, 16) : 0;
+}
+
+static uint32_t AllocateThreadId()
+{
+	threadIdsLock.Enter();
+	uint32_t threadId;
+	if (freeThreadIds != NULL && !freeThreadIds->empty())
+	{
+		threadId = freeThreadIds->back();
+		freeThreadIds->pop_back();
+	}
+	else
+	{
+		threadId = ++lastThreadId;
+		if (threadId > MAX_THIN_LOCK_THREAD_ID)
+			abort();
+	}
+	threadIdsLock.Leave();
+
+	return threadId;
+}
+
+static void FreeThreadId(uint32_t threadId)
+{
+	threadIdsLock.Enter();
+	if (freeThreadIds == NULL)
+		freeThreadIds = new std::vector<uint32_t>();
+	freeThreadIds->push_back(threadId);
+	threadIdsLock.Leave();
+}
+
+// Threads started from managed code keep process alive until they finish, unless they are background threads
+// Note: threadsMutex should be held
+static bool IsForegroundThread(ManagedThread* thread)
+{
+	return !thread->attached && thread->started && !thread->finished && !thread->isBackground;
+}
+
+static void ReleaseThread(ManagedThread* thread)
+{
+	if (thread->referenceCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	FreeThreadId(thread->threadId);
+	delete thread;
+}
+
+// Note: current thread should be in preemptive mode
+static void AddThread(ManagedThread* thread)
+{
+	threadsLock.Enter();
+	thread->previous = NULL;
+	thread->next = threads;
+	if (threads != NULL)
+		threads->previous = thread;
+	threads = thread;
+	threadsLock.Leave();
+}
+
+// Note: current thread should be in preemptive mode
+static void RemoveThread(ManagedThread* thread)
+{
+	threadsLock.Enter();
+	if (thread->previous != NULL)
+		thread->previous->next = thread->next;
+	else
+		threads = thread->next;
+	if (thread->next != NULL)
+		thread->next->previous = thread->previous;
+	threadsLock.Leave();
+}
+
+static void LeavePreemptiveMode(ManagedThread* thread)
+{
+	while (true)
+	{
+		// Pairs with SuspendManagedThreads: either GC sees us in cooperative mode, or we see its request
+		thread->mode.store(THREAD_MODE_COOPERATIVE, std::memory_order_seq_cst);
+		if (!suspendRequested.load(std::memory_order_seq_cst))
+			return;
+
+		// Collection in progress: stay in preemptive mode until it is over
+		thread->mode.store(THREAD_MODE_PREEMPTIVE, std::memory_order_seq_cst);
+
+		LockThreads();
+		while (suspendRequested.load(std::memory_order_relaxed))
+			WaitThreads(&resumeCondition, NULL);
+		UnlockThreads();
+	}
+}
+
+static bool IsSafepointPollFault(void* address)
+{
+	return safepointPollPageSize != 0 && (uint8_t*)address >= safepointPollPage && (uint8_t*)address < safepointPollPage + safepointPollPageSize;
+}
+
+// Guard page polls fault in managed code, which doesn't hold any runtime lock: blocking in the handler is as safe as calling safepointPoll.
+// Registers of the interrupted code are saved in the exception context, on the stack above the handler, so they are scanned with the rest of the stack.
+#ifdef _WIN32
+static LONG CALLBACK SafepointExceptionHandler(EXCEPTION_POINTERS* exception)
+{
+	auto record = exception->ExceptionRecord;
+	if (record->ExceptionCode != EXCEPTION_ACCESS_VIOLATION || record->NumberParameters < 2
+		|| !IsSafepointPollFault((void*)record->ExceptionInformation[1]))
+		return EXCEPTION_CONTINUE_SEARCH;
+
+	// Page is readable again once threads are resumed, so faulting instruction can be executed again
+	GCPoll();
+	return EXCEPTION_CONTINUE_EXECUTION;
+}
+#else
+#ifdef __APPLE__
+#define SAFEPOINT_FAULT_SIGNAL SIGBUS
+#else
+#define SAFEPOINT_FAULT_SIGNAL SIGSEGV
+#endif
+
+// Code interrupted by a signal might still use a red zone below its stack pointer
+#if defined(__x86_64__) || defined(__APPLE__)
+#define SIGNAL_RED_ZONE_SIZE 128
+#else
+#define SIGNAL_RED_ZONE_SIZE 0
+#endif
+
+// Stack pointer and registers of the code interrupted by a signal
+static uint8_t* GetInterruptedStackPointer(ucontext_t* context, uint8_t** registersStart, uint8_t** registersEnd)
+{
+#ifdef __APPLE__
+	*registersStart = (uint8_t*)context->uc_mcontext;
+	*registersEnd = *registersStart + sizeof(*context->uc_mcontext);
+#if defined(__x86_64__)
+	return (uint8_t*)context->uc_mcontext->__ss.__rsp;
+#elif defined(__aarch64__)
+	return (uint8_t*)context->uc_mcontext->__ss.__sp;
+#else
+#error Unsupported architecture
+#endif
+#else
+	*registersStart = (uint8_t*)&context->uc_mcontext;
+	*registersEnd = *registersStart + sizeof(context->uc_mcontext);
+#if defined(__x86_64__)
+	return (uint8_t*)context->uc_mcontext.gregs[REG_RSP];
+#elif defined(__i386__)
+	return (uint8_t*)context->uc_mcontext.gregs[REG_ESP];
+#elif defined(__aarch64__)
+	return (uint8_t*)context->uc_mcontext.sp;
+#elif defined(__arm__)
+	return (uint8_t*)context->uc_mcontext.arm_sp;
+#else
+#error Unsupported architecture
+#endif
+#endif
+}
+
+// Safe point reached from a handler running on the alternate signal stack: GC scans the thread stack from the interrupted stack pointer,
+// and the interrupted registers from the signal context (they are not on the thread stack)
+static void GCPollOnAlternateSignalStack(ucontext_t* context)
+{
+	if (!suspendRequested.load(std::memory_order_relaxed))
+		return;
+
+	auto thread = GetCurrentManagedThread();
+	auto stackPointer = GetInterruptedStackPointer(context, &thread->signalContextStart, &thread->signalContextEnd);
+
+	thread->stackPointer = stackPointer - SIGNAL_RED_ZONE_SIZE;
+	thread->mode.store(THREAD_MODE_PREEMPTIVE, std::memory_order_seq_cst);
+
+	LeavePreemptiveMode(thread);
+
+	thread->signalContextStart = NULL;
+	thread->signalContextEnd = NULL;
+}
+
+// Other faults go to the handler that was installed before (i.e. the PAL one, which turns them into exceptions)
+static struct sigaction previousFaultAction;
+
+static void SafepointFaultHandler(int signalNumber, siginfo_t* info, void* context)
+{
+	if (IsSafepointPollFault(info->si_addr))
+	{
+		// Page is readable again once threads are resumed, so faulting instruction can be executed again
+		stack_t signalStack;
+		if (sigaltstack(NULL, &signalStack) == 0 && (signalStack.ss_flags & SS_ONSTACK))
+			GCPollOnAlternateSignalStack((ucontext_t*)context);
+		else
+			GCPoll();
+		return;
+	}
+
+	if (previousFaultAction.sa_flags & SA_SIGINFO)
+	{
+		previousFaultAction.sa_sigaction(signalNumber, info, context);
+	}
+	else if (previousFaultAction.sa_handler != SIG_DFL && previousFaultAction.sa_handler != SIG_IGN)
+	{
+		previousFaultAction.sa_handler(signalNumber);
+	}
+	else
+	{
+		// Faulting instruction crashes the process when executed again
+		signal(signalNumber, SIG_DFL);
+	}
+}
+
+// PAL installs its own handlers when initialized, so this is checked before each suspension that arms the guard page.
+// Runs on the alternate signal stack (if any), so that faults forwarded to the previous handler, such as stack overflows, still get handled.
+static void InstallSafepointFaultHandler()
+{
+	struct sigaction action;
+	if (sigaction(SAFEPOINT_FAULT_SIGNAL, NULL, &action) != 0)
+		return;
+	if ((action.sa_flags & SA_SIGINFO) && action.sa_sigaction == SafepointFaultHandler)
+		return;
+
+	previousFaultAction = action;
+
+	action.sa_sigaction = SafepointFaultHandler;
+	action.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+	sigemptyset(&action.sa_mask);
+	sigaction(SAFEPOINT_FAULT_SIGNAL, &action, NULL);
+}
+#endif
+
+static void ProtectSafepointPollPage(bool unreadable)
+{
+
+#ifdef _WIN32
+	DWORD previousProtection;
+	VirtualProtect((void*)safepointPollPage, safepointPollPageSize, unreadable ? PAGE_NOACCESS : PAGE_READONLY, &previousProtection);
+#else
+	if (unreadable)
+		InstallSafepointFaultHandler();
+	mprotect((void*)safepointPollPage, safepointPollPageSize, unreadable ? PROT_NONE : PROT_READ);
+#endif
+}
+
+static struct SafepointPollPageInitializer
+{
+	SafepointPollPageInitializer()
+	{
+#ifdef _WIN32
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		auto page = VirtualAlloc(NULL, systemInfo.dwPageSize, MEM_COMMIT | MEM_RESERVE, PAGE_READONLY);
+		if (page == NULL)
+			return;
+		AddVectoredExceptionHandler(1, SafepointExceptionHandler);
+		safepointPollPageSize = systemInfo.dwPageSize;
+#else
+		auto pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		auto page = mmap(NULL, pageSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (page == MAP_FAILED)
+			return;
+		safepointPollPageSize = pageSize;
+#endif
+		safepointPollPage = (uint8_t*)page;
+	}
+} safepointPollPageInitializer;
+
+extern "C" void enableSafepointGuardPage()
+{
+	safepointGuardPageEnabled.store(true, std::memory_order_relaxed);
+}
+
+static void DetachCurrentThread();
+
+#ifdef _WIN32
+static DWORD threadExitSlot = FLS_OUT_OF_INDEXES;
+
+static void WINAPI OnThreadExit(void* data)
+{
+	if (currentThread != NULL)
+		DetachCurrentThread();
+}
+#else
+static pthread_key_t threadExitKey;
+static bool threadExitKeyCreated;
+
+static void OnThreadExit(void* data)
+{
+	if (currentThread != NULL)
+		DetachCurrentThread();
+}
+#endif
+
+// Threads are detached automatically when they exit
+static struct ThreadExitCallbackInitializer
+{
+	ThreadExitCallbackInitializer()
+	{
+#ifdef _WIN32
+		threadExitSlot = FlsAlloc(OnThreadExit);
+#else
+		threadExitKeyCreated = pthread_key_create(&threadExitKey, OnThreadExit) == 0;
+#endif
+	}
+} threadExitCallbackInitializer;
+
+static void RegisterThreadExitCallback(ManagedThread* thread)
+{
+	// Threads attached before static initialization (i.e. main thread) don't need it
+#ifdef _WIN32
+	if (threadExitSlot != FLS_OUT_OF_INDEXES)
+		FlsSetValue(threadExitSlot, thread);
+#else
+	if (threadExitKeyCreated)
+		pthread_setspecific(threadExitKey, thread);
+#endif
+}
+
+// Thread should already be listed, in preemptive mode
+static void AttachCurrentThread(ManagedThread* thread)
+{
+	auto stackBase = GetStackBase();
+
+	// GC might be scanning listed threads
+	threadsLock.Enter();
+	thread->stackBase = stackBase;
+	thread->stackPointer = stackBase;
+	threadsLock.Leave();
+
+	currentThread = thread;
+	RegisterThreadExitCallback(thread);
+
+	LeavePreemptiveMode(thread);
+}
+
+static void DetachCurrentThread()
+{
+	auto thread = currentThread;
+
+	// Allocation context lives in thread local storage, GC shouldn't touch it anymore
+	ReleaseAllocationContext();
+	ReleaseFinalizationNodes();
+
+	thread->stackPointer = thread->stackBase;
+	thread->mode.store(THREAD_MODE_PREEMPTIVE, std::memory_order_seq_cst);
+	RemoveThread(thread);
+	currentThread = NULL;
+
+	LockThreads();
+	if (IsForegroundThread(thread))
+		foregroundThreadCount--;
+	thread->finished = true;
+	WakeThreads(&threadFinishedCondition);
+	UnlockThreads();
+
+	ReleaseThread(thread);
+}
+
+ManagedThread* GetCurrentManagedThread()
+{
+	auto thread = currentThread;
+	if (thread == NULL)
+	{
+		thread = new ManagedThread();
+		thread->threadId = AllocateThreadId();
+		thread->mode.store(THREAD_MODE_PREEMPTIVE, std::memory_order_relaxed);
+		thread->referenceCount.store(1, std::memory_order_relaxed);
+		thread->started = true;
+		thread->attached = true;
+
+		AddThread(thread);
+		AttachCurrentThread(thread);
+	}
+
+	return thread;
+}
+
+ThreadBaseObject* GetCurrentThreadObject()
+{
+	auto thread = GetCurrentManagedThread();
+	if (thread->exposedObject == NULL)
+	{
+		auto threadObject = (ThreadBaseObject*)AllocateObject(&System_Threading_Thread_rtti);
+		threadObject->m_InternalThread = thread;
+		threadObject->m_ManagedThreadId = (int32_t)thread->threadId;
+		threadObject->m_Priority = MANAGED_THREAD_PRIORITY_NORMAL;
+
+		// Thread object keeps native state alive until it is finalized
+		thread->referenceCount.fetch_add(1, std::memory_order_relaxed);
+		thread->exposedObject = threadObject;
+	}
+
+	return thread->exposedObject;
+}
+
+__attribute__((noinline)) void RunPreemptive(void (*function)(void* context), void* context)
+{
+	auto thread = GetCurrentManagedThread();
+
+	// Nested call
+	if (thread->mode.load(std::memory_order_relaxed) == THREAD_MODE_PREEMPTIVE)
+	{
+		function(context);
+		return;
+	}
+
+	// Spill callee-saved registers on the stack, so that GC scans them with the rest of the stack
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_unwind_init();
+#endif
+	jmp_buf registers;
+	setjmp(registers);
+
+	thread->stackPointer = (uint8_t*)&registers;
+	thread->mode.store(THREAD_MODE_PREEMPTIVE, std::memory_order_seq_cst);
+
+	function(context);
+
+	LeavePreemptiveMode(thread);
+}
+
+void GCPoll()
+{
+	if (suspendRequested.load(std::memory_order_relaxed))
+		RunPreemptive([](void* context) {}, NULL);
+}
+
+extern "C" void safepointPoll()
+{
+	GCPoll();
+}
+
+void SuspendManagedThreads()
+{
+	threadsLock.Enter();
+
+	auto requestTime = std::chrono::steady_clock::now();
+
+	LockThreads();
+	suspendRequested.store(true, std::memory_order_seq_cst);
+	UnlockThreads();
+
+	// Threads running managed code will stop at their next safe point poll
+	safepointPollFlag = 1;
+	safepointGuardPageArmed = safepointPollPageSize != 0 && safepointGuardPageEnabled.load(std::memory_order_relaxed);
+	if (safepointGuardPageArmed)
+		ProtectSafepointPollPage(true);
+
+	auto current = currentThread;
+	for (auto thread = threads; thread != NULL; thread = thread->next)
+	{
+		if (thread == current)
+			continue;
+
+		while (thread->mode.load(std::memory_order_seq_cst) != THREAD_MODE_PREEMPTIVE)
+			YieldThread();
+	}
+
+	auto timeToSafepoint = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - requestTime).count();
+
+	safepointStatsLock.Enter();
+	safepointStats.suspensionCount++;
+	safepointStats.lastTimeToSafepoint = timeToSafepoint;
+	safepointStats.totalTimeToSafepoint += timeToSafepoint;
+	if (timeToSafepoint > safepointStats.maxTimeToSafepoint)
+		safepointStats.maxTimeToSafepoint = timeToSafepoint;
+	safepointStatsLock.Leave();
+}
+
+void ResumeManagedThreads()
+{
+	// Page needs to be readable again before threads blocked in fault handler are woken up
+	if (safepointGuardPageArmed)
+		ProtectSafepointPollPage(false);
+	safepointPollFlag = 0;
+
+	LockThreads();
+	suspendRequested.store(false, std::memory_order_seq_cst);
+	WakeThreads(&resumeCondition);
+	UnlockThreads();
+
+	threadsLock.Leave();
+}
+
+void GetSafepointStats(SafepointStats* stats)
+{
+	safepointStatsLock.Enter();
+	*stats = safepointStats;
+	safepointStatsLock.Leave();
+}
+
+extern "C" void getSafepointStats(SafepointStats* stats)
+{
+	GetSafepointStats(stats);
+}
+
+void EnumerateManagedThreads(ManagedThreadCallback callback)
+{
+	for (auto thread = threads; thread != NULL; thread = thread->next)
+		callback(thread);
+}
+
+ManagedThread* CreateManagedThread(ThreadBaseObject* threadObject, size_t stackSize)
+{
+	auto thread = new ManagedThread();
+	thread->threadId = AllocateThreadId();
+	thread->exposedObject = threadObject;
+	thread->mode.store(THREAD_MODE_PREEMPTIVE, std::memory_order_relaxed);
+	thread->referenceCount.store(1, std::memory_order_relaxed);
+	thread->stackSize = stackSize;
+
+	threadObject->m_InternalThread = thread;
+	threadObject->m_ManagedThreadId = (int32_t)thread->threadId;
+	threadObject->m_Priority = MANAGED_THREAD_PRIORITY_NORMAL;
+
+	return thread;
+}
+
+static void RunThread(void* context)
+{
+	auto thread = (ManagedThread*)context;
+	AttachCurrentThread(thread);
+
+	auto threadObject = thread->exposedObject;
+	auto start = (DelegateObject*)threadObject->m_Delegate;
+	if (start->eeType == &System_Threading_ParameterizedThreadStart_rtti)
+	{
+		auto argument = threadObject->m_ThreadStartArg;
+		threadObject->m_ThreadStartArg = NULL;
+		((void (*)(Object*, Object*))start->_methodPtr)(start->_target, argument);
+	}
+	else
+	{
+		((void (*)(Object*))start->_methodPtr)(start->_target);
+	}
+
+	DetachCurrentThread();
+}
+
+struct NativeThreadStart
+{
+	void (*function)(void* context);
+	void* context;
+};
+
+static void RunNativeThread(NativeThreadStart* start)
+{
+	auto function = start->function;
+	auto context = start->context;
+	delete start;
+
+	function(context);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI NativeThreadStartRoutine(LPVOID parameter)
+{
+	RunNativeThread((NativeThreadStart*)parameter);
+	return 0;
+}
+#else
+static void* NativeThreadStartRoutine(void* parameter)
+{
+	RunNativeThread((NativeThreadStart*)parameter);
+	return NULL;
+}
+#endif
+
+bool StartNativeThread(void (*function)(void* context), void* context, size_t stackSize)
+{
+	if (stackSize == 0)
+		stackSize = GetDefaultStackSize();
+	if (stackSize != 0 && stackSize < MIN_THREAD_STACK_SIZE)
+		stackSize = MIN_THREAD_STACK_SIZE;
+
+	auto start = new NativeThreadStart();
+	start->function = function;
+	start->context = context;
+
+#ifdef _WIN32
+	auto handle = CreateThread(NULL, stackSize, NativeThreadStartRoutine, start, stackSize != 0 ? STACK_SIZE_PARAM_IS_A_RESERVATION : 0, NULL);
+	if (handle == NULL)
+	{
+		delete start;
+		return false;
+	}
+	CloseHandle(handle);
+#else
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	if (stackSize != 0)
+	{
+		// Some platforms require a multiple of page size
+		auto pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		stackSize = (stackSize + pageSize - 1) & ~(pageSize - 1);
+		auto minStackSize = (size_t)PTHREAD_STACK_MIN;
+		pthread_attr_setstacksize(&attributes, stackSize < minStackSize ? minStackSize : stackSize);
+	}
+
+	pthread_t handle;
+	auto result = pthread_create(&handle, &attributes, NativeThreadStartRoutine, start);
+	pthread_attr_destroy(&attributes);
+	if (result != 0)
+	{
+		delete start;
+		return false;
+	}
+	pthread_detach(handle);
+#endif
+
+	return true;
+}
+
+// Process only exits once foreground threads are done (like when Main returns in CLR)
+static void WaitForForegroundThreads()
+{
+	RunPreemptive([]
+	{
+		auto current = currentThread;
+
+		LockThreads();
+		// Current thread might be a foreground thread itself (i.e. calling Environment.Exit)
+		uint32_t currentCount = IsForegroundThread(current) ? 1 : 0;
+		while (foregroundThreadCount > currentCount)
+			WaitThreads(&threadFinishedCondition, NULL);
+		UnlockThreads();
+	});
+}
+
+bool StartManagedThread(ManagedThread* thread)
+{
+	LockThreads();
+	if (thread->started)
+	{
+		UnlockThreads();
+		return false;
+	}
+	thread->started = true;
+	if (IsForegroundThread(thread))
+		foregroundThreadCount++;
+	if (!exitWaitRegistered)
+	{
+		exitWaitRegistered = true;
+		atexit(WaitForForegroundThreads);
+	}
+	UnlockThreads();
+
+	// Listed right away, so that GC keeps Thread object alive until thread runs
+	thread->referenceCount.fetch_add(1, std::memory_order_relaxed);
+	RunPreemptive([thread] { AddThread(thread); });
+
+	if (!StartNativeThread(RunThread, thread, thread->stackSize))
+		abort();
+
+	return true;
+}
+
+bool JoinManagedThread(ManagedThread* thread, int32_t timeout)
+{
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout < 0 ? 0 : timeout);
+	bool finished;
+
+	RunPreemptive([thread, timeout, &deadline, &finished]
+	{
+		LockThreads();
+		while (!thread->finished && WaitThreads(&threadFinishedCondition, timeout < 0 ? NULL : &deadline))
+		{
+		}
+		finished = thread->finished;
+		UnlockThreads();
+	});
+
+	return finished;
+}
+
+void SleepCurrentThread(int32_t timeout)
+{
+	RunPreemptive([timeout]
+	{
+#ifdef _WIN32
+		Sleep(timeout < 0 ? INFINITE : (DWORD)timeout);
+#else
+		if (timeout == 0)
+		{
+			sched_yield();
+			return;
+		}
+
+		if (timeout < 0)
+		{
+			while (true)
+				pause();
+		}
+
+		struct timespec remaining;
+		remaining.tv_sec = timeout / 1000;
+		remaining.tv_nsec = (long)(timeout % 1000) * 1000000;
+		while (nanosleep(&remaining, &remaining) != 0 && errno == EINTR)
+		{
+		}
+#endif
+	});
+}
+
+int32_t GetManagedThreadState(ManagedThread* thread)
+{
+	LockThreads();
+	int32_t state = THREAD_STATE_RUNNING;
+	if (!thread->started)
+		state = THREAD_STATE_UNSTARTED;
+	else if (thread->finished)
+		state = THREAD_STATE_STOPPED;
+	if (thread->isBackground)
+		state |= THREAD_STATE_BACKGROUND;
+	UnlockThreads();
+
+	return state;
+}
+
+void SetManagedThreadBackground(ManagedThread* thread, bool isBackground)
+{
+	LockThreads();
+	if (IsForegroundThread(thread))
+		foregroundThreadCount--;
+	thread->isBackground = isBackground;
+	if (IsForegroundThread(thread))
+		foregroundThreadCount++;
+	UnlockThreads();
+}
+
+void ReleaseManagedThread(ManagedThread* thread)
+{
+	ReleaseThread(thread);
+}
@@ -0,0 +1,140 @@
+#ifndef SHARPLANG_MANAGED_THREAD_H
+#define SHARPLANG_MANAGED_THREAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+class Object;
+class ThreadBaseObject;
+
+// Threads in cooperative mode can access the managed heap, and GC waits for them to reach a safe point.
+// Threads in preemptive mode (blocked or running native code) don't touch the heap, so GC can run without waiting for them.
+#define THREAD_MODE_COOPERATIVE 0
+#define THREAD_MODE_PREEMPTIVE 1
+
+// System.Threading.ThreadState flags
+#define THREAD_STATE_RUNNING 0
+#define THREAD_STATE_BACKGROUND 4
+#define THREAD_STATE_UNSTARTED 8
+#define THREAD_STATE_STOPPED 16
+
+// System.Threading.ThreadPriority.Normal
+#define MANAGED_THREAD_PRIORITY_NORMAL 2
+
+// Native state of a thread running managed code (or of a Thread object not started yet).
+// Threads not started from managed code get one when they first need it.
+struct ManagedThread
+{
+	ManagedThread* next;
+	ManagedThread* previous;
+
+	// Small non-zero id, recycled once both thread and Thread object are gone (also used as monitor owner id)
+	uint32_t threadId;
+
+	// Thread.CurrentThread, created on demand for threads not started from managed code
+	ThreadBaseObject* exposedObject;
+
+	// Exception being thrown lives in malloc memory during unwinding, keep it alive for GC
+	Object* inFlightException;
+
+	// Stack scanned by GC while thread is in preemptive mode: [stackPointer, stackBase)
+	uint8_t* stackBase;
+	uint8_t* stackPointer;
+	std::atomic<uint32_t> mode;
+
+	// Registers of the interrupted code, when thread stopped at a guard page poll in a handler running on the alternate signal stack (also scanned by GC)
+	uint8_t* signalContextStart;
+	uint8_t* signalContextEnd;
+
+	// Released by the thread when it exits, and by its Thread object when finalized
+	std::atomic<uint32_t> referenceCount;
+
+	// Stack size of threads started from managed code (0 means default stack size)
+	size_t stackSize;
+
+	// Protected by threads mutex (attached threads were not started from managed code, i.e. main thread)
+	bool attached;
+	bool started;
+	bool finished;
+	bool isBackground;
+};
+
+// Current thread state, attached on first call (thread is then tracked by GC until it exits)
+ManagedThread* GetCurrentManagedThread();
+
+// Thread.CurrentThread (created on first call)
+ThreadBaseObject* GetCurrentThreadObject();
+
+// Runs function in preemptive mode, so that GC doesn't need to wait for current thread.
+// Function must not access the managed heap (apart from objects that are otherwise rooted, through pointers computed before).
+// Note: this is a safe point, current thread might block here until a collection is over.
+void RunPreemptive(void (*function)(void* context), void* context);
+
+template <typename Function>
+void RunPreemptive(Function function)
+{
+	RunPreemptive([](void* context) { (*(Function*)context)(); }, &function);
+}
+
+// Safe point: waits until collection is over if one has been requested
+void GCPoll();
+
+// Safe point polls emitted by the compiler at loop back-edges and method prologs, in one of two flavors:
+// - test safepointPollFlag, and call safepointPoll when it is set
+// - read a byte from safepointPollPage, which becomes unreadable while threads are being suspended (the fault is handled as a safe point)
+extern "C" volatile uint32_t safepointPollFlag;
+extern "C" volatile uint8_t* safepointPollPage;
+extern "C" void safepointPoll();
+
+// Called by modules compiled with guard page polls: the poll page is only made unreadable during suspensions once one is loaded
+extern "C" void enableSafepointGuardPage();
+
+// Used by GC: waits until every other thread reached preemptive mode, then prevents them from leaving it until resumed.
+// Managed code must not run on the suspending thread until threads are resumed.
+void SuspendManagedThreads();
+void ResumeManagedThreads();
+
+// Time-to-safepoint (between suspension request and every other thread reaching a safe point), in nanoseconds
+struct SafepointStats
+{
+	uint64_t suspensionCount;
+	uint64_t lastTimeToSafepoint;
+	uint64_t maxTimeToSafepoint;
+	uint64_t totalTimeToSafepoint;
+};
+
+void GetSafepointStats(SafepointStats* stats);
+
+// Can be used by host or native code (i.e. a sampling profiler)
+extern "C" void getSafepointStats(SafepointStats* stats);
+
+// Used by GC to scan thread stacks and roots (threads should be suspended)
+typedef void (*ManagedThreadCallback)(ManagedThread* thread);
+void EnumerateManagedThreads(ManagedThreadCallback callback);
+
+// Starts a native thread running function (0 means default stack size).
+// It gets attached when it first needs to, and detached when it exits.
+bool StartNativeThread(void (*function)(void* context), void* context, size_t stackSize);
+
+// Setup native state of a Thread object, before it gets started
+ManagedThread* CreateManagedThread(ThreadBaseObject* threadObject, size_t stackSize);
+
+// Starts a native thread running thread object delegate. Returns false if thread was already started.
+bool StartManagedThread(ManagedThread* thread);
+
+// Returns false if timeout (in milliseconds, negative is infinite) expired before thread finished
+bool JoinManagedThread(ManagedThread* thread, int32_t timeout);
+
+void SleepCurrentThread(int32_t timeout);
+
+// Combination of THREAD_STATE_* flags
+int32_t GetManagedThreadState(ManagedThread* thread);
+
+// Process waits for foreground threads started from managed code before exiting
+void SetManagedThreadBackground(ManagedThread* thread, bool isBackground);
+
+// Called when Thread object is finalized
+void ReleaseManagedThread(ManagedThread* thread);
+
+#endif
@@ -40,7 +40,7 @@ extern "C" void System_Runtime_InteropServices_Marshal__CopyToNative_System_Obje
 	// Get element size
 	int32_t elementSize = source->eeType->elementSize;
 
-	memcpy((void*) dest, (const void*) (source->value + sourceIndex), elementSize * length);
+	memcpy((void*) dest, (const void*) (source->value + sourceIndex * elementSize), elementSize * length);
 }
 
 extern "C" void System_Runtime_InteropServices_Marshal__CopyToManaged_System_IntPtr_System_Object_System_Int32_System_Int32_(uint8_t* source, Array<uint8_t>* dest, int32_t destIndex, int32_t length)
@@ -56,13 +56,5 @@ extern "C" void System_Runtime_InteropServices_Marshal__CopyToManaged_System_Int
 	// Get element size
 	int32_t elementSize = dest->eeType->elementSize;
 
-	memcpy((void*) (dest->value + destIndex), (const void*) source, elementSize * length);
-}
-
-extern "C" void System_Runtime_InteropServices_SafeHandle__InternalDispose__(Object* safeHandle)
-{
-}
-
-extern "C" void System_Runtime_InteropServices_SafeHandle__InternalFinalize__(Object* safeHandle)
-{
+	memcpy((void*) (dest->value + destIndex * elementSize), (const void*) source, elementSize * length);
 }
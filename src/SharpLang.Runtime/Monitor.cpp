@@ -0,0 +1,369 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#endif
+
+#include "RuntimeType.h"
+#include "ObjectHeader.h"
+#include "Monitor.h"
+#include "ManagedThread.h"
+
+// Number of times a contended lock is checked before blocking
+#define MONITOR_SPIN_COUNT 100
+
+struct MonitorTimeout
+{
+	bool infinite;
+	std::chrono::steady_clock::time_point deadline;
+};
+
+// Small non-zero id, so that it fits in thin locks
+static uint32_t GetMonitorThreadId()
+{
+	return GetCurrentManagedThread()->threadId;
+}
+
+static MonitorTimeout MakeTimeout(int32_t milliseconds)
+{
+	MonitorTimeout timeout;
+	timeout.infinite = milliseconds < 0;
+	timeout.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout.infinite ? 0 : milliseconds);
+	return timeout;
+}
+
+static inline void SpinPause()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#endif
+}
+
+static inline void YieldThread()
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+// Blocks while *address is equal to expected (might return spuriously).
+// Returns false if timeout expired.
+// Note: thread waits in preemptive mode, so that GC doesn't need to wait for it
+static bool FutexWait(std::atomic<uint32_t>* address, uint32_t expected, const MonitorTimeout& timeout)
+{
+	std::chrono::nanoseconds remaining(0);
+	if (!timeout.infinite)
+	{
+		remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout.deadline - std::chrono::steady_clock::now());
+		if (remaining.count() <= 0)
+			return false;
+	}
+
+	bool timedOut = false;
+	RunPreemptive([&]
+	{
+#ifdef __linux__
+		struct timespec relativeTimeout;
+		relativeTimeout.tv_sec = (time_t)(remaining.count() / 1000000000);
+		relativeTimeout.tv_nsec = (long)(remaining.count() % 1000000000);
+
+		timedOut = syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAIT_PRIVATE, expected, timeout.infinite ? NULL : &relativeTimeout, NULL, 0) != 0
+			&& errno == ETIMEDOUT;
+#else
+		// TODO: Use WaitOnAddress on Windows
+		YieldThread();
+#endif
+	});
+
+	return !timedOut;
+}
+
+static void FutexWake(std::atomic<uint32_t>* address, int32_t count)
+{
+#ifdef __linux__
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+#endif
+}
+
+static bool AcquireFatLock(SyncBlock* syncBlock, uint32_t threadId, int32_t timeout)
+{
+	if (syncBlock->ownerThreadId.load(std::memory_order_relaxed) == threadId)
+	{
+		syncBlock->recursion++;
+		return true;
+	}
+
+	uint32_t state = 0;
+	if (!syncBlock->lockState.compare_exchange_strong(state, 1, std::memory_order_acquire, std::memory_order_relaxed))
+	{
+		if (timeout == 0)
+			return false;
+
+		// Owner might release it soon
+		for (uint32_t spinCount = 0; spinCount < MONITOR_SPIN_COUNT && state != 0; ++spinCount)
+		{
+			SpinPause();
+			state = syncBlock->lockState.load(std::memory_order_relaxed);
+		}
+
+		// Mark lock as contended, so that owner wakes us up when releasing it
+		auto deadline = MakeTimeout(timeout);
+		state = syncBlock->lockState.exchange(2, std::memory_order_acquire);
+		while (state != 0)
+		{
+			if (!FutexWait(&syncBlock->lockState, 2, deadline))
+				return false;
+			state = syncBlock->lockState.exchange(2, std::memory_order_acquire);
+		}
+	}
+
+	syncBlock->ownerThreadId.store(threadId, std::memory_order_relaxed);
+	syncBlock->recursion = 0;
+	return true;
+}
+
+static void ReleaseFatLock(SyncBlock* syncBlock)
+{
+	if (syncBlock->recursion > 0)
+	{
+		syncBlock->recursion--;
+		return;
+	}
+
+	syncBlock->ownerThreadId.store(0, std::memory_order_relaxed);
+	if (syncBlock->lockState.exchange(0, std::memory_order_release) == 2)
+		FutexWake(&syncBlock->lockState, 1);
+}
+
+static bool MonitorEnterSlow(Object* obj, uint32_t threadId, uintptr_t header, int32_t timeout)
+{
+	auto& headerWord = GetHeaderWord(obj);
+	auto thinLock = (uintptr_t)threadId << HEADER_OWNER_SHIFT;
+	uint32_t spinCount = 0;
+
+	while (true)
+	{
+		if (header == 0)
+		{
+			if (headerWord.compare_exchange_weak(header, thinLock, std::memory_order_acquire, std::memory_order_acquire))
+				return true;
+			continue;
+		}
+
+		switch (header & HEADER_TAG_MASK)
+		{
+		case 0:
+			// Thin lock
+			if ((uint32_t)(header >> HEADER_OWNER_SHIFT) == threadId)
+			{
+				// Recursion (only other threads inflating the lock can change header in the meantime)
+				if ((header & HEADER_RECURSION_MASK) != HEADER_RECURSION_MASK)
+				{
+					if (headerWord.compare_exchange_weak(header, header + HEADER_RECURSION_ONE, std::memory_order_relaxed, std::memory_order_acquire))
+						return true;
+					continue;
+				}
+
+				// Recursion count doesn't fit anymore
+				InflateHeader(obj, header);
+			}
+			else if (timeout == 0)
+			{
+				return false;
+			}
+			else if (spinCount < MONITOR_SPIN_COUNT)
+			{
+				spinCount++;
+				SpinPause();
+			}
+			else
+			{
+				// Contended: inflate, so that we can block until owner releases it
+				InflateHeader(obj, header);
+			}
+			header = headerWord.load(std::memory_order_acquire);
+			break;
+		case HEADER_TAG_HASHCODE:
+			// Hash code and lock can't both fit in header
+			InflateHeader(obj, header);
+			header = headerWord.load(std::memory_order_acquire);
+			break;
+		default:
+			return AcquireFatLock(GetHeaderSyncBlock(header), threadId, timeout);
+		}
+	}
+}
+
+bool MonitorEnter(Object* obj, int32_t timeout)
+{
+	auto threadId = GetMonitorThreadId();
+
+	// Fast path: object not locked or hashed yet
+	uintptr_t header = 0;
+	if (GetHeaderWord(obj).compare_exchange_strong(header, (uintptr_t)threadId << HEADER_OWNER_SHIFT, std::memory_order_acquire, std::memory_order_acquire))
+		return true;
+
+	return MonitorEnterSlow(obj, threadId, header, timeout);
+}
+
+bool MonitorExit(Object* obj)
+{
+	auto threadId = GetMonitorThreadId();
+	auto& headerWord = GetHeaderWord(obj);
+	auto header = headerWord.load(std::memory_order_acquire);
+
+	while (true)
+	{
+		switch (header & HEADER_TAG_MASK)
+		{
+		case 0:
+		{
+			if (header == 0 || (uint32_t)(header >> HEADER_OWNER_SHIFT) != threadId)
+				return false;
+
+			// Fails if another thread inflated lock in the meantime
+			auto newHeader = (header & HEADER_RECURSION_MASK) != 0 ? header - HEADER_RECURSION_ONE : 0;
+			if (headerWord.compare_exchange_weak(header, newHeader, std::memory_order_release, std::memory_order_acquire))
+				return true;
+			break;
+		}
+		case HEADER_TAG_SYNCBLOCK:
+		{
+			auto syncBlock = GetHeaderSyncBlock(header);
+			if (syncBlock->ownerThreadId.load(std::memory_order_relaxed) != threadId)
+				return false;
+
+			ReleaseFatLock(syncBlock);
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+}
+
+bool MonitorIsEntered(Object* obj)
+{
+	auto threadId = GetMonitorThreadId();
+	auto header = GetHeaderWord(obj).load(std::memory_order_acquire);
+
+	switch (header & HEADER_TAG_MASK)
+	{
+	case 0:
+		return header != 0 && (uint32_t)(header >> HEADER_OWNER_SHIFT) == threadId;
+	case HEADER_TAG_SYNCBLOCK:
+		return GetHeaderSyncBlock(header)->ownerThreadId.load(std::memory_order_relaxed) == threadId;
+	default:
+		return false;
+	}
+}
+
+bool MonitorWait(Object* obj, int32_t timeout)
+{
+	auto threadId = GetMonitorThreadId();
+	auto& headerWord = GetHeaderWord(obj);
+
+	// Waiters are tracked in sync block
+	auto header = headerWord.load(std::memory_order_acquire);
+	while ((header & HEADER_TAG_MASK) != HEADER_TAG_SYNCBLOCK)
+	{
+		InflateHeader(obj, header);
+		header = headerWord.load(std::memory_order_acquire);
+	}
+	auto syncBlock = GetHeaderSyncBlock(header);
+
+	MonitorWaiter waiter;
+	waiter.next = NULL;
+	waiter.signaled = 0;
+
+	syncBlock->waitersLock.Enter();
+	if (syncBlock->lastWaiter != NULL)
+		syncBlock->lastWaiter->next = &waiter;
+	else
+		syncBlock->firstWaiter = &waiter;
+	syncBlock->lastWaiter = &waiter;
+	syncBlock->waitersLock.Leave();
+
+	// Lock is fully released while waiting
+	auto recursion = syncBlock->recursion;
+	syncBlock->recursion = 0;
+	ReleaseFatLock(syncBlock);
+
+	auto deadline = MakeTimeout(timeout);
+	while (waiter.signaled.load(std::memory_order_acquire) == 0)
+	{
+		if (!FutexWait(&waiter.signaled, 0, deadline))
+			break;
+	}
+
+	// If not pulsed, remove ourselves from waiters (taking the lock also makes sure Pulse is done with waiter)
+	syncBlock->waitersLock.Enter();
+	auto signaled = waiter.signaled.load(std::memory_order_relaxed) != 0;
+	if (!signaled)
+	{
+		MonitorWaiter* previous = NULL;
+		for (auto current = syncBlock->firstWaiter; current != &waiter; current = current->next)
+			previous = current;
+
+		if (previous != NULL)
+			previous->next = waiter.next;
+		else
+			syncBlock->firstWaiter = waiter.next;
+		if (syncBlock->lastWaiter == &waiter)
+			syncBlock->lastWaiter = previous;
+	}
+	syncBlock->waitersLock.Leave();
+
+	AcquireFatLock(syncBlock, threadId, -1);
+	syncBlock->recursion = recursion;
+
+	return signaled;
+}
+
+static void PulseWaiters(Object* obj, bool all)
+{
+	// Without sync block, there can't be any waiter
+	auto header = GetHeaderWord(obj).load(std::memory_order_acquire);
+	if ((header & HEADER_TAG_MASK) != HEADER_TAG_SYNCBLOCK)
+		return;
+	auto syncBlock = GetHeaderSyncBlock(header);
+
+	syncBlock->waitersLock.Enter();
+	do
+	{
+		auto waiter = syncBlock->firstWaiter;
+		if (waiter == NULL)
+			break;
+
+		syncBlock->firstWaiter = waiter->next;
+		if (syncBlock->firstWaiter == NULL)
+			syncBlock->lastWaiter = NULL;
+
+		waiter->signaled.store(1, std::memory_order_release);
+		FutexWake(&waiter->signaled, 1);
+	} while (all);
+	syncBlock->waitersLock.Leave();
+}
+
+void MonitorPulse(Object* obj)
+{
+	PulseWaiters(obj, false);
+}
+
+void MonitorPulseAll(Object* obj)
+{
+	PulseWaiters(obj, true);
+}
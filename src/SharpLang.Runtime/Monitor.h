@@ -0,0 +1,25 @@
+#ifndef SHARPLANG_MONITOR_H
+#define SHARPLANG_MONITOR_H
+
+#include <stdint.h>
+
+class Object;
+
+// Monitor (lock statement) implementation: thin locks in object header, inflated to a sync block
+// when contended (see ObjectHeader.h). Timeouts are in milliseconds (-1 for infinite).
+
+// Returns false if lock couldn't be taken before timeout
+bool MonitorEnter(Object* obj, int32_t timeout);
+
+// Returns false if current thread doesn't own the lock
+bool MonitorExit(Object* obj);
+
+bool MonitorIsEntered(Object* obj);
+
+// Current thread should own the lock (checked with MonitorIsEntered).
+// Returns false if timeout expired before object was pulsed.
+bool MonitorWait(Object* obj, int32_t timeout);
+void MonitorPulse(Object* obj);
+void MonitorPulseAll(Object* obj);
+
+#endif
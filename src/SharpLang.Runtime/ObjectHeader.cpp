@@ -0,0 +1,134 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <vector>
+
+#include "RuntimeType.h"
+#include "SpinLock.h"
+#include "ObjectHeader.h"
+
+static std::atomic<uint32_t> hashCodeSeedCounter;
+static thread_local uint32_t hashCodeSeed;
+
+// Every sync block ever created (and not freed yet), so that GC can free them
+static SpinLock syncBlocksLock;
+static std::vector<SyncBlock*>* syncBlocks;
+
+// Finalizer of MurmurHash3, used to derive well distributed seeds from a counter
+static uint32_t MixBits(uint32_t value)
+{
+	value ^= value >> 16;
+	value *= 0x85ebca6b;
+	value ^= value >> 13;
+	value *= 0xc2b2ae35;
+	value ^= value >> 16;
+	return value;
+}
+
+static uint32_t GenerateHashCode()
+{
+	// Each thread has its own xorshift generator, so that no synchronization is needed
+	auto seed = hashCodeSeed;
+	while (seed == 0)
+		seed = MixBits(hashCodeSeedCounter.fetch_add(1, std::memory_order_relaxed) + 1);
+
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	hashCodeSeed = seed;
+
+	return seed & HEADER_HASHCODE_MASK;
+}
+
+static inline uintptr_t MakeHashCodeHeader(uint32_t hashCode)
+{
+	return ((uintptr_t)hashCode << HEADER_TAG_BITS) | HEADER_TAG_HASHCODE;
+}
+
+SyncBlock* InflateHeader(Object* obj, uintptr_t header)
+{
+	auto syncBlock = new SyncBlock();
+	syncBlock->object = obj;
+
+	if ((header & HEADER_TAG_MASK) == HEADER_TAG_HASHCODE)
+	{
+		syncBlock->hashCode = header;
+	}
+	else if (header != 0)
+	{
+		// Thin lock (owner keeps it, releasing it will go through the sync block)
+		syncBlock->lockState = 1;
+		syncBlock->ownerThreadId = (uint32_t)(header >> HEADER_OWNER_SHIFT);
+		syncBlock->recursion = (uint32_t)((header & HEADER_RECURSION_MASK) >> HEADER_RECURSION_SHIFT);
+	}
+
+	auto newHeader = (uintptr_t)syncBlock | HEADER_TAG_SYNCBLOCK;
+	if (!GetHeaderWord(obj).compare_exchange_strong(header, newHeader, std::memory_order_acq_rel, std::memory_order_relaxed))
+	{
+		delete syncBlock;
+		return NULL;
+	}
+
+	syncBlocksLock.Enter();
+	if (syncBlocks == NULL)
+		syncBlocks = new std::vector<SyncBlock*>();
+	syncBlocks->push_back(syncBlock);
+	syncBlocksLock.Leave();
+
+	return syncBlock;
+}
+
+void FreeDeadSyncBlocks(SyncBlockIsAliveCallback isAlive)
+{
+	syncBlocksLock.Enter();
+	if (syncBlocks != NULL)
+	{
+		size_t liveCount = 0;
+		for (auto syncBlock : *syncBlocks)
+		{
+			if (isAlive(syncBlock->object))
+				(*syncBlocks)[liveCount++] = syncBlock;
+			else
+				delete syncBlock;
+		}
+		syncBlocks->resize(liveCount);
+	}
+	syncBlocksLock.Leave();
+}
+
+int32_t GetObjectHashCode(Object* obj)
+{
+	auto& headerWord = GetHeaderWord(obj);
+	auto header = headerWord.load(std::memory_order_acquire);
+
+	while (true)
+	{
+		if (header == 0)
+		{
+			// First call: try to store a new hash code (another thread might win the race)
+			auto newHeader = MakeHashCodeHeader(GenerateHashCode());
+			if (headerWord.compare_exchange_strong(header, newHeader, std::memory_order_acq_rel, std::memory_order_acquire))
+				header = newHeader;
+			continue;
+		}
+
+		switch (header & HEADER_TAG_MASK)
+		{
+		case HEADER_TAG_HASHCODE:
+			return (int32_t)(header >> HEADER_TAG_BITS);
+		case HEADER_TAG_SYNCBLOCK:
+		{
+			auto syncBlock = GetHeaderSyncBlock(header);
+			uintptr_t hashCode = 0;
+			if (!syncBlock->hashCode.compare_exchange_strong(hashCode, MakeHashCodeHeader(GenerateHashCode()), std::memory_order_acq_rel, std::memory_order_acquire))
+				return (int32_t)(hashCode >> HEADER_TAG_BITS);
+			return (int32_t)(syncBlock->hashCode.load(std::memory_order_relaxed) >> HEADER_TAG_BITS);
+		}
+		default:
+			// Thin lock: both need to be stored
+			InflateHeader(obj, header);
+			header = headerWord.load(std::memory_order_acquire);
+			break;
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#ifndef SHARPLANG_OBJECT_HEADER_H
+#define SHARPLANG_OBJECT_HEADER_H
+
+#include <stdint.h>
+#include <atomic>
+
+#include "RuntimeType.h"
+#include "SpinLock.h"
+
+// Object header word is zero until object is hashed or locked, so objects never hashed or locked don't need anything else.
+// Low bits are a tag telling what the rest of the word contains:
+// - 0 (with a non-zero value): thin lock, owner thread id and recursion count are stored in the bits above the tag
+// - HEADER_TAG_HASHCODE: hash code, in the bits above the tag
+// - HEADER_TAG_SYNCBLOCK: pointer to a SyncBlock, used when header can't hold everything
+//   (object both hashed and locked, lock contended or waited on, or recursion count too big)
+#define HEADER_TAG_BITS 2
+#define HEADER_TAG_MASK ((uintptr_t)((1 << HEADER_TAG_BITS) - 1))
+#define HEADER_TAG_HASHCODE 1
+#define HEADER_TAG_SYNCBLOCK 2
+
+// Hash codes need to fit in header word on 32-bit platforms
+#define HEADER_HASHCODE_MASK ((uint32_t)0xFFFFFFFF >> HEADER_TAG_BITS)
+
+// Thin lock layout: recursion count (number of times entered by owner, minus one), then owner thread id
+#define HEADER_RECURSION_SHIFT HEADER_TAG_BITS
+#define HEADER_RECURSION_BITS 8
+#define HEADER_RECURSION_ONE ((uintptr_t)1 << HEADER_RECURSION_SHIFT)
+#define HEADER_RECURSION_MASK ((((uintptr_t)1 << HEADER_RECURSION_BITS) - 1) << HEADER_RECURSION_SHIFT)
+#define HEADER_OWNER_SHIFT (HEADER_RECURSION_SHIFT + HEADER_RECURSION_BITS)
+#define MAX_THIN_LOCK_THREAD_ID ((uint32_t)0xFFFFFFFF >> HEADER_OWNER_SHIFT)
+
+struct MonitorWaiter
+{
+	MonitorWaiter* next;
+	std::atomic<uint32_t> signaled; // Futex word
+};
+
+// Created on demand when header can't hold everything.
+// Sync blocks are never deflated, they are freed once their object is dead.
+struct SyncBlock
+{
+	Object* object;
+
+	// Stored like in header (with HEADER_TAG_HASHCODE), 0 until assigned
+	std::atomic<uintptr_t> hashCode;
+
+	// Fat lock: 0 if unlocked, 1 if locked, 2 if locked and there might be threads waiting (futex word)
+	std::atomic<uint32_t> lockState;
+	std::atomic<uint32_t> ownerThreadId;
+	uint32_t recursion; // Only accessed by owner
+
+	// Threads blocked in Monitor.Wait, in order
+	SpinLock waitersLock;
+	MonitorWaiter* firstWaiter;
+	MonitorWaiter* lastWaiter;
+};
+
+static inline std::atomic<uintptr_t>& GetHeaderWord(Object* obj)
+{
+	static_assert(sizeof(std::atomic<uintptr_t>) == sizeof(uintptr_t), "Header word can't be accessed atomically");
+	return *reinterpret_cast<std::atomic<uintptr_t>*>(&obj->header);
+}
+
+static inline SyncBlock* GetHeaderSyncBlock(uintptr_t header)
+{
+	return (SyncBlock*)(header & ~HEADER_TAG_MASK);
+}
+
+// Hash code is assigned on first call, and stays the same for the lifetime of the object
+int32_t GetObjectHashCode(Object* obj);
+
+// Moves content of header (hash code or thin lock) to a new sync block, and makes header point to it.
+// Returns NULL if header doesn't match anymore (caller should read it again).
+SyncBlock* InflateHeader(Object* obj, uintptr_t header);
+
+// Used by GC to free sync blocks of dead objects (after marking)
+typedef bool (*SyncBlockIsAliveCallback)(Object* obj);
+void FreeDeadSyncBlocks(SyncBlockIsAliveCallback isAlive);
+
+#endif
@@ -1,19 +1,22 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
+#include <atomic>
 
 #include "RuntimeType.h"
 #include "ConvertUTF.h"
+#include "Heap.h"
 
 StringObject* StringObject::NewString(uint32_t length)
 {
-	void* allocatedMemory = malloc(sizeof(StringObject) + sizeof(char16_t) * length);
+	void* allocatedMemory = AllocateObject(&System_String_rtti, sizeof(StringObject) + sizeof(char16_t) * length);
 	return new(allocatedMemory)StringObject(length);
 }
 
 StringObject* StringObject::NewString(const char16_t* str, uint32_t length)
 {
-	void* allocatedMemory = malloc(sizeof(StringObject) + sizeof(char16_t) * length);
+	void* allocatedMemory = AllocateObject(&System_String_rtti, sizeof(StringObject) + sizeof(char16_t) * length);
 	return new(allocatedMemory)StringObject(length, str);
 }
 
@@ -27,7 +30,7 @@ StringObject::StringObject(uint32_t length, const char* str) : Object(&System_St
 StringObject* StringObject::NewString(const char* str, uint32_t length)
 {
 	// We are not expecting any non ASCII characters, so we can use sprintf size as is.
-	auto allocatedMemory = malloc(sizeof(StringObject) + sizeof(char16_t) * length);
+	auto allocatedMemory = AllocateObject(&System_String_rtti, sizeof(StringObject) + sizeof(char16_t) * length);
 	return new(allocatedMemory) StringObject(length, str);
 }
 
@@ -49,9 +52,171 @@ extern "C" bool isInstInterface(const EEType* eeType, const EEType* expectedInte
 	return false;
 }
 
-extern "C" void* allocObject(size_t size)
+#define ELEMENT_TYPE_GENERICINST 0x15
+#define ELEMENT_TYPE_SZARRAY 0x1d
+
+static bool CanCastToUncached(EEType* eeType, EEType* targetType);
+
+// Checks if eeType is an instance of the same generic type as targetType, with compatible generic arguments
+// (i.e. IEnumerable<string> => IEnumerable<object>)
+static bool IsVariantCompatible(EEType* eeType, EEType* targetType)
+{
+	if (targetType->genericVariance == 0
+		|| eeType->corElementType != ELEMENT_TYPE_GENERICINST || targetType->corElementType != ELEMENT_TYPE_GENERICINST
+		|| eeType->typeDef.sharpLangModule != targetType->typeDef.sharpLangModule || eeType->typeDef.token != targetType->typeDef.token)
+		return false;
+
+	// For generic instances, element type is the null-terminated list of generic arguments
+	auto genericArguments = (EEType**)eeType->elementType;
+	auto targetGenericArguments = (EEType**)targetType->elementType;
+
+	for (int i = 0; genericArguments[i] != NULL; ++i)
+	{
+		auto genericArgument = genericArguments[i];
+		auto targetGenericArgument = targetGenericArguments[i];
+		if (genericArgument == targetGenericArgument)
+			continue;
+
+		// Variance only applies to reference types
+		if (genericArgument->IsValueType() || targetGenericArgument->IsValueType())
+			return false;
+
+		auto variance = i < 8 ? (targetType->genericVariance >> (i * 2)) & EEType::VARIANCE_MASK : 0;
+		if (variance == EEType::VARIANCE_COVARIANT)
+		{
+			if (!CanCastToUncached(genericArgument, targetGenericArgument))
+				return false;
+		}
+		else if (variance == EEType::VARIANCE_CONTRAVARIANT)
+		{
+			if (!CanCastToUncached(targetGenericArgument, genericArgument))
+				return false;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Array covariance: arrays of reference types are compatible if their element types are (i.e. string[] => object[])
+static bool IsArrayCompatible(EEType* eeType, EEType* targetType)
 {
-    return memset(malloc(size), 0, size);
+	if (eeType->corElementType != ELEMENT_TYPE_SZARRAY || targetType->corElementType != ELEMENT_TYPE_SZARRAY)
+		return false;
+
+	// For arrays, element type is tagged in its low bits (see compiler's ExtraTypeKind)
+	auto elementType = (EEType*)((size_t)eeType->elementType & ~(size_t)3);
+	auto targetElementType = (EEType*)((size_t)targetType->elementType & ~(size_t)3);
+	if (elementType->IsValueType() || targetElementType->IsValueType())
+		return false;
+
+	return CanCastToUncached(elementType, targetElementType);
+}
+
+static bool CanCastToUncached(EEType* eeType, EEType* targetType)
+{
+	if (!targetType->IsInterface())
+		return isSubclassOf(eeType, targetType) || IsVariantCompatible(eeType, targetType) || IsArrayCompatible(eeType, targetType);
+
+	// Interfaces don't have an interface map (only check variance with interface itself)
+	if (eeType->IsInterface())
+		return eeType == targetType || IsVariantCompatible(eeType, targetType);
+
+	if (isInstInterface(eeType, targetType))
+		return true;
+
+	if (targetType->genericVariance != 0)
+	{
+		for (int i = 0; i < eeType->interfacesCount; ++i)
+		{
+			if (IsVariantCompatible(eeType->interfaceMap[i], targetType))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+// Type caches: direct mapped, each entry is protected by a sequence number (odd while being written)
+// so that lookups don't need any lock.
+#define TYPE_CACHE_SIZE 1024
+
+struct TypeCacheEntry
+{
+	std::atomic<uint32_t> sequence;
+	std::atomic<EEType*> eeType;
+	std::atomic<void*> key;
+	std::atomic<void*> value;
+};
+
+// (type, target type) => cast result (both positive and negative results are cached)
+static TypeCacheEntry castCache[TYPE_CACHE_SIZE];
+
+// (type, interface method id) => target, for interface calls not found in IMT
+static TypeCacheEntry interfaceDispatchCache[TYPE_CACHE_SIZE];
+
+static TypeCacheEntry* GetTypeCacheEntry(TypeCacheEntry* cache, EEType* eeType, void* key)
+{
+	auto hash = (uint32_t)((uintptr_t)eeType >> 3) * 0x9E3779B1U ^ (uint32_t)((uintptr_t)key >> 3);
+	return &cache[(hash ^ (hash >> 16)) & (TYPE_CACHE_SIZE - 1)];
+}
+
+static bool TypeCacheLookup(TypeCacheEntry* cache, EEType* eeType, void* key, void** value)
+{
+	auto entry = GetTypeCacheEntry(cache, eeType, key);
+
+	auto sequence = entry->sequence.load(std::memory_order_acquire);
+	if ((sequence & 1) != 0)
+		return false;
+
+	auto cachedType = entry->eeType.load(std::memory_order_relaxed);
+	auto cachedKey = entry->key.load(std::memory_order_relaxed);
+	*value = entry->value.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	return entry->sequence.load(std::memory_order_relaxed) == sequence && cachedType == eeType && cachedKey == key;
+}
+
+static void TypeCacheStore(TypeCacheEntry* cache, EEType* eeType, void* key, void* value)
+{
+	auto entry = GetTypeCacheEntry(cache, eeType, key);
+
+	// Skipped if another thread is already writing this entry
+	auto sequence = entry->sequence.load(std::memory_order_relaxed);
+	if ((sequence & 1) != 0 || !entry->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acq_rel))
+		return;
+
+	// Entry fields must not become visible before odd sequence (readers would see torn entries as valid)
+	std::atomic_thread_fence(std::memory_order_release);
+
+	entry->eeType.store(eeType, std::memory_order_relaxed);
+	entry->key.store(key, std::memory_order_relaxed);
+	entry->value.store(value, std::memory_order_relaxed);
+	entry->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool CanCastTo(EEType* eeType, EEType* targetType)
+{
+	if (eeType == targetType)
+		return true;
+
+	void* cachedResult;
+	if (TypeCacheLookup(castCache, eeType, targetType, &cachedResult))
+		return cachedResult != NULL;
+
+	auto result = CanCastToUncached(eeType, targetType);
+	TypeCacheStore(castCache, eeType, targetType, result ? (void*)1 : NULL);
+
+	return result;
+}
+
+// Used by generated isinst/castclass when inline checks fail on variant or array types
+extern "C" bool canCastTo(EEType* eeType, EEType* targetType)
+{
+	return CanCastTo(eeType, targetType);
 }
 
 typedef struct IMTEntry
@@ -75,11 +240,137 @@ extern "C" void* resolveInterfaceCall(void* methodId, void* content)
 		IMTEntry* imtEntry = (IMTEntry*)((size_t)content & ~1);
 		while (imtEntry->methodId != methodId && imtEntry->methodId != 0) { imtEntry++; }
 
+		// NULL if not found (terminator)
 		result = imtEntry->methodPointer;
+	}
+
+	return result;
+}
+
+// Interface calls not found in IMT: either variance (i.e. IEnumerable<object>.GetEnumerator() on a List<string>),
+// or generic virtual methods (only closed instantiations known when type was compiled are available).
+// Resolved through the dispatch tables following interface map, and cached.
+static void* ResolveInterfaceCallSlow(EEType* eeType, void* methodId, EEType* interfaceType, int32_t methodIndex)
+{
+	void* result;
+	if (TypeCacheLookup(interfaceDispatchCache, eeType, methodId, &result))
+		return result;
+
+	result = NULL;
+	if (methodIndex >= 0)
+	{
+		// Interface map is followed by interface hash table, then by one dispatch table per interface
+		auto dispatchTables = (void***)(eeType->interfaceMap + eeType->interfacesCount + eeType->interfaceHashMask + 1);
+
+		// Exact interface first: a type might implement several instantiations compatible through variance
+		int interfaceIndex = -1;
+		for (int i = 0; i < eeType->interfacesCount; ++i)
+		{
+			if (eeType->interfaceMap[i] == interfaceType)
+			{
+				interfaceIndex = i;
+				break;
+			}
+		}
+
+		for (int i = 0; interfaceIndex == -1 && i < eeType->interfacesCount; ++i)
+		{
+			if (IsVariantCompatible(eeType->interfaceMap[i], interfaceType))
+				interfaceIndex = i;
+		}
+
+		if (interfaceIndex != -1)
+			result = dispatchTables[interfaceIndex][methodIndex];
+	}
+
+	// No implementation was compiled for this method
+	// TODO: Generic virtual methods (methodIndex == -1) instantiated with types only known at the call site need runtime instantiation (or a managed exception)
+	if (result == NULL)
+	{
+		fprintf(stderr, "Could not resolve interface call: type %p (token 0x%08x), interface %p (token 0x%08x), method %p (index %d)\n",
+			eeType, eeType->typeDef.token, interfaceType, interfaceType->typeDef.token, methodId, methodIndex);
+		abort();
+	}
 
-		// TODO: Slow path: dispatch to add new entry (should only happen with either variance or generics methods)
-		//assert(result != 0);
+	TypeCacheStore(interfaceDispatchCache, eeType, methodId, result);
+
+	return result;
+}
+
+static std::atomic<InterfaceCallCache*> interfaceCallCaches;
+
+extern "C" void* resolveInterfaceCallCached(InterfaceCallCache* cache, EEType* eeType, void* methodId, void* content, EEType* interfaceType, int32_t methodIndex)
+{
+	// Once cache is full, it isn't written anymore (not even counters), so that megamorphic call sites don't keep bouncing its cache line between cores
+	auto megamorphic = ((std::atomic<EEType*>*)&cache->eeTypes[INTERFACE_CALL_CACHE_SIZE - 1])->load(std::memory_order_acquire) != NULL;
+
+	// First entry has already been checked by generated code
+	for (int i = 1; i < INTERFACE_CALL_CACHE_SIZE; ++i)
+	{
+		auto cachedType = ((std::atomic<EEType*>*)&cache->eeTypes[i])->load(std::memory_order_acquire);
+		if (cachedType == eeType)
+		{
+			if (!megamorphic)
+				((std::atomic<uint32_t>*)&cache->hits)->fetch_add(1, std::memory_order_relaxed);
+			return cache->targets[i];
+		}
+		if (cachedType == NULL)
+			break;
+	}
+
+	// Single IMT entries don't store their method id: only trust them if type implements this exact interface,
+	// which is always the case for invariant interfaces (generic method instantiations are never in IMT).
+	// Generated code takes the same shortcut inline once cache is full.
+	void* result = NULL;
+	if (((size_t)content & 1) != 0
+		|| (content != NULL && methodIndex >= 0 && (interfaceType->genericVariance == 0 || isInstInterface(eeType, interfaceType))))
+		result = resolveInterfaceCall(methodId, content);
+
+	if (result == NULL)
+		result = ResolveInterfaceCallSlow(eeType, methodId, interfaceType, methodIndex);
+
+	if (megamorphic)
+		return result;
+
+	((std::atomic<uint32_t>*)&cache->misses)->fetch_add(1, std::memory_order_relaxed);
+
+	// Claim first free entry: target is set first, and eeType is published afterward
+	for (int i = 0; i < INTERFACE_CALL_CACHE_SIZE; ++i)
+	{
+		void* expectedTarget = NULL;
+		if (((std::atomic<void*>*)&cache->targets[i])->compare_exchange_strong(expectedTarget, result))
+		{
+			((std::atomic<EEType*>*)&cache->eeTypes[i])->store(eeType, std::memory_order_release);
+
+			// Register call site the first time it is filled
+			if (i == 0)
+			{
+				auto head = interfaceCallCaches.load(std::memory_order_relaxed);
+				do
+				{
+					cache->next = head;
+				} while (!interfaceCallCaches.compare_exchange_weak(head, cache));
+			}
+			break;
+		}
 	}
 
 	return result;
-}
\ No newline at end of file
+}
+
+extern "C" void getInterfaceCallCacheStats(InterfaceCallCacheStats* stats)
+{
+	memset(stats, 0, sizeof(InterfaceCallCacheStats));
+
+	for (auto cache = interfaceCallCaches.load(); cache != NULL; cache = cache->next)
+	{
+		stats->siteCount++;
+		if (cache->targets[1] != NULL)
+			stats->polymorphicSiteCount++;
+		if (cache->targets[INTERFACE_CALL_CACHE_SIZE - 1] != NULL)
+			stats->megamorphicSiteCount++;
+		stats->hits += cache->hits;
+		stats->misses += cache->misses;
+		stats->inlineHits += cache->inlineHits;
+	}
+}
@@ -26,6 +26,7 @@ public:
 
 	uint8_t isConcreteType;
 	uint8_t corElementType;
+	uint16_t genericVariance; // 2 bits per generic parameter (see GenericVariance)
 
 	// Metadata
 	TypeDefinition typeDef;
@@ -33,7 +34,7 @@ public:
 	RuntimeType* runtimeType;
 
 	// Field infos
-	uint16_t garbageCollectableFieldCount; // First entries in FieldDescriptions will be for the GC: instance fields of referencable types
+	uint16_t garbageCollectableFieldCount; // First entries in FieldDescriptions will be for the GC: instance fields of referencable types (arrays: references in one element)
 	uint16_t fieldCount;
 	FieldDesc* fieldDescriptions;
 	
@@ -43,6 +44,8 @@ public:
 	EEType** superTypes;
 	EEType** interfaceMap;
 	uint8_t initialized;
+	uint8_t flags; // See EETypeFlags
+	uint16_t interfaceHashMask; // interfaceMap is followed by a hash table of (interfaceHashMask + 1) entries, indexed by interface id (computed by compiler)
 	uint32_t objectSize;
 	uint32_t elementSize;
 
@@ -53,6 +56,25 @@ public:
 	uint32_t virtualTableSize;
 	void* virtualTable[0];
 
+	enum EETypeFlags
+	{
+		FLAG_HAS_FINALIZER = 0x1, // Overrides Object.Finalize
+		FLAG_IS_VALUE_TYPE = 0x2,
+	};
+
+	enum GenericVariance
+	{
+		VARIANCE_COVARIANT = 0x1,
+		VARIANCE_CONTRAVARIANT = 0x2,
+		VARIANCE_MASK = 0x3,
+	};
+
+	bool HasFinalizer() { return (flags & FLAG_HAS_FINALIZER) != 0; }
+
+	// Interfaces are the only non-concrete types (and have no flags)
+	bool IsInterface() { return !isConcreteType; }
+	bool IsValueType() { return isConcreteType && (flags & FLAG_IS_VALUE_TYPE) != 0; }
+
 	enum
 	{
 		NO_SLOT = 0xffff // a unique slot number used to indicate "empty" for fields that record slot numbers
@@ -63,16 +85,73 @@ public:
 
 extern "C" bool isInstInterface(const EEType* eeType, const EEType* expectedInterface);
 
+// Class hierarchy check (Cohen display): superTypes goes from System.Object to type itself, so a class of depth N is always at index N
+inline bool isSubclassOf(const EEType* eeType, const EEType* expectedClass)
+{
+	if (eeType == expectedClass)
+		return true;
+
+	// Interfaces don't have super types
+	if (!eeType->isConcreteType || !expectedClass->isConcreteType)
+		return false;
+
+	auto depth = expectedClass->superTypeCount - 1;
+	return eeType->superTypeCount > depth && eeType->superTypes[depth] == expectedClass;
+}
+
+// Full cast check (class hierarchy, interfaces and generic variance), results are cached
+bool CanCastTo(EEType* eeType, EEType* targetType);
+extern "C" bool canCastTo(EEType* eeType, EEType* targetType);
+
+// Number of EEType -> target pairs cached at each interface call site
+#define INTERFACE_CALL_CACHE_SIZE 4
+
+// Inline cache emitted by the compiler next to each interface call (layout must match the compiler's InterfaceCallCache).
+// Generated code checks first entry inline, other entries are checked by resolveInterfaceCallCached.
+// Entries are filled once and never replaced (target is written before eeType), so that they can be read without lock.
+struct InterfaceCallCache
+{
+	EEType* eeTypes[INTERFACE_CALL_CACHE_SIZE];
+	void* targets[INTERFACE_CALL_CACHE_SIZE];
+
+	// Call sites are registered when they are first resolved, so that their counters can be collected
+	InterfaceCallCache* next;
+
+	// Updated with relaxed atomics, and not anymore once cache is full. Only calls not hitting the first entry are counted.
+	uint32_t hits;
+	uint32_t misses;
+
+	// First entry hits, only counted by generated code when compiled with interface call cache stats enabled
+	uint32_t inlineHits;
+};
+
+// Interface type and method index (in interface definition, -1 for generic methods) are used to resolve calls not found in IMT
+extern "C" void* resolveInterfaceCallCached(InterfaceCallCache* cache, EEType* eeType, void* methodId, void* content, EEType* interfaceType, int32_t methodIndex);
+
+struct InterfaceCallCacheStats
+{
+	uint32_t siteCount;
+	uint32_t polymorphicSiteCount; // More than one cached type
+	uint32_t megamorphicSiteCount; // Cache full
+	uint64_t hits;                 // Found in other entries than the first one
+	uint64_t misses;               // Resolved through IMT
+	uint64_t inlineHits;           // Found in first entry (0 unless compiled with interface call cache stats)
+};
+
+extern "C" void getInterfaceCallCacheStats(InterfaceCallCacheStats* stats);
+extern "C" void writeBarrier(void* address);
+
 class AppDomain;
 
 class Object
 {
 public:
-	Object(EEType* eeType) : eeType(eeType) {}
+	Object(EEType* eeType) : eeType(eeType), header(0) {}
     
 	AppDomain* GetDomain();
 
 	EEType* eeType;
+	uintptr_t header; // Hash code and lock state (see ObjectHeader.h)
 
 	uint8_t* GetDataPointer() { return (uint8_t*)(this + 1); }
 
@@ -151,6 +230,7 @@ public:
 	void SetRefValue(Object* obj, Object* value)
 	{
 		*(Object**) (obj->GetDataPointer() + GetOffset()) = value;
+		writeBarrier(obj->GetDataPointer() + GetOffset());
 	}
 };
 
@@ -229,8 +309,8 @@ public:
 	inline size_t GetNumComponents() { return length; }
 	inline size_t GetComponentSize() { return eeType->elementSize; }
     
-	inline uint8_t* GetDataPtr() { return *(uint8_t**)(this + 1); }
-	inline void SetDataPtr(uint8_t* data) { *(uint8_t**)(this + 1) = data; }
+	// Elements are stored inline, right after the array header
+	inline uint8_t* GetDataPtr() { return (uint8_t*)(this + 1); }
 
 	size_t length;
 };
@@ -239,7 +319,8 @@ template <class T>
 class Array : public ArrayBase
 {
 public:
-	T* value;
+	// First element (use sizeof(ArrayBase) as header size, not sizeof(Array<T>))
+	T value[1];
 
     const T* GetDirectConstPointerToNonObjectElements() const
     {
@@ -254,10 +335,21 @@ public:
 
 extern EEType System_Threading_Thread_rtti;
 
+struct ManagedThread;
+
+// Mirrors System.Threading.Thread fields
 class ThreadBaseObject : public Object
 {
 public:
 	ThreadBaseObject() : Object(&System_Threading_Thread_rtti) {}
+
+	StringObject* m_Name;
+	Object* m_Delegate;
+	Object* m_ThreadStartArg;
+	ManagedThread* m_InternalThread;
+	int32_t m_Priority;
+	int32_t m_ManagedThreadId;
+	bool m_ExecutionContextBelongsToOuterScope;
 };
 
 class StringBufferObject : public Object
@@ -272,12 +364,10 @@ class StringBufferObject : public Object
     // TODO
 };
 
-// Temporary GCHandle (until we have a GC)
+// Slot in the handle table (see HandleTable.h)
 struct GCHandle
 {
-	RuntimeType* runtimeType;
 	Object* value;
-	int32_t handleType;
 };
 
 #endif
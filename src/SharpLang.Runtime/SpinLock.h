@@ -0,0 +1,41 @@
+#ifndef SHARPLANG_SPINLOCK_H
+#define SHARPLANG_SPINLOCK_H
+
+#include <atomic>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+// Lock for short critical sections, yields while waiting
+class SpinLock
+{
+public:
+	void Enter()
+	{
+		while (flag.test_and_set(std::memory_order_acquire))
+		{
+#ifdef _WIN32
+			SwitchToThread();
+#else
+			sched_yield();
+#endif
+		}
+	}
+
+	bool TryEnter()
+	{
+		return !flag.test_and_set(std::memory_order_acquire);
+	}
+
+	void Leave()
+	{
+		flag.clear(std::memory_order_release);
+	}
+
+private:
+	std::atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+
+#endif
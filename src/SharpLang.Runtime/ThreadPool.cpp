@@ -0,0 +1,797 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <algorithm>
+#include <new>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
+#include <thread>
+#endif
+
+#include "RuntimeType.h"
+#include "SpinLock.h"
+#include "ManagedThread.h"
+#include "ThreadPool.h"
+
+// Worker slots are never freed (thieves might still look at them), exited workers leave them for new ones
+#define MAX_WORKER_COUNT 512
+
+#define MAX_COMPLETION_PORT_THREAD_COUNT 1000
+
+#define WORK_STEALING_QUEUE_INITIAL_CAPACITY 32
+
+// Gate thread checks how workers are doing at this interval, and stops after that many intervals without work
+#define GATE_INTERVAL_MS 500
+#define GATE_IDLE_INTERVALS 20
+
+// Workers above minimum exit after being idle that long
+#define WORKER_IDLE_TIMEOUT_MS 20000
+
+// Defined in mscorlib: runs ThreadPoolWorkQueue.Dispatch, returns false if worker was asked to go back to the pool
+extern "C" bool System_Threading__ThreadPoolWaitCallback__PerformWaitCallback__();
+
+struct WorkStealingBuffer
+{
+	int64_t capacity; // Power of 2
+	WorkStealingBuffer* nextRetired;
+	std::atomic<Object*> items[1];
+};
+
+// Chase-Lev deque: owner pushes and pops at bottom, other workers steal at top
+struct WorkStealingQueue
+{
+	std::atomic<int64_t> top;
+	std::atomic<int64_t> bottom;
+	std::atomic<WorkStealingBuffer*> buffer;
+};
+
+struct Worker
+{
+	WorkStealingQueue queue;
+	bool active; // Protected by poolMutex
+	uint32_t randomSeed;
+};
+
+static std::atomic<Worker*> workers[MAX_WORKER_COUNT];
+static std::atomic<uint32_t> workerSlotCount;
+
+static thread_local Worker* currentWorker;
+
+// Work items queued from threads other than workers
+static SpinLock globalQueueLock;
+static std::deque<Object*>* globalQueue;
+static std::atomic<size_t> globalQueueCount;
+
+// Buffers replaced when deques grow (freed during next collection)
+static SpinLock retiredBuffersLock;
+static WorkStealingBuffer* retiredBuffers;
+
+// Workers looking for work (awake and not running a work item); they check queues again before going idle
+static std::atomic<uint32_t> searchingWorkerCount;
+static std::atomic<uint64_t> completedItemCount;
+
+// Pool state (protected by poolMutex, atomics can be read without it)
+#ifdef _WIN32
+static SRWLOCK poolMutex = SRWLOCK_INIT;
+static CONDITION_VARIABLE workAvailableCondition = CONDITION_VARIABLE_INIT;
+static CONDITION_VARIABLE gateCondition = CONDITION_VARIABLE_INIT;
+#else
+static pthread_mutex_t poolMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t workAvailableCondition = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t gateCondition = PTHREAD_COND_INITIALIZER;
+#endif
+static bool poolInitialized;
+static std::atomic<uint32_t> workerCount;
+static std::atomic<uint32_t> targetWorkerCount;
+static uint32_t idleWorkerCount;
+static uint32_t wakeupCount;
+static uint32_t minWorkerCount;
+static uint32_t maxWorkerCount;
+static uint32_t minCompletionPortCount;
+static uint32_t maxCompletionPortCount;
+static bool gateStarted;
+static bool gateActive;
+
+typedef std::chrono::steady_clock::time_point WaitDeadline;
+
+static void LockPool()
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&poolMutex);
+#else
+	pthread_mutex_lock(&poolMutex);
+#endif
+}
+
+static void UnlockPool()
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&poolMutex);
+#else
+	pthread_mutex_unlock(&poolMutex);
+#endif
+}
+
+// Returns false if deadline expired (no deadline means infinite wait)
+#ifdef _WIN32
+static bool WaitPool(CONDITION_VARIABLE* condition, const WaitDeadline* deadline)
+{
+	DWORD timeout = INFINITE;
+	if (deadline != NULL)
+	{
+		auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now()).count();
+		if (remaining <= 0)
+			return false;
+		timeout = (DWORD)remaining;
+	}
+
+	return SleepConditionVariableSRW(condition, &poolMutex, timeout, 0) || GetLastError() != ERROR_TIMEOUT;
+}
+
+static void WakeOnePool(CONDITION_VARIABLE* condition)
+{
+	WakeConditionVariable(condition);
+}
+#else
+static bool WaitPool(pthread_cond_t* condition, const WaitDeadline* deadline)
+{
+	if (deadline == NULL)
+	{
+		pthread_cond_wait(condition, &poolMutex);
+		return true;
+	}
+
+	auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - std::chrono::steady_clock::now()).count();
+	if (remaining <= 0)
+		return false;
+
+	// Condition uses realtime clock
+	struct timespec absoluteTimeout;
+	clock_gettime(CLOCK_REALTIME, &absoluteTimeout);
+	absoluteTimeout.tv_sec += (time_t)(remaining / 1000000000);
+	absoluteTimeout.tv_nsec += (long)(remaining % 1000000000);
+	if (absoluteTimeout.tv_nsec >= 1000000000)
+	{
+		absoluteTimeout.tv_sec++;
+		absoluteTimeout.tv_nsec -= 1000000000;
+	}
+
+	return pthread_cond_timedwait(condition, &poolMutex, &absoluteTimeout) != ETIMEDOUT;
+}
+
+static void WakeOnePool(pthread_cond_t* condition)
+{
+	pthread_cond_signal(condition);
+}
+#endif
+
+static uint32_t GetPoolProcessorCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return systemInfo.dwNumberOfProcessors;
+#else
+	return std::max(1u, std::thread::hardware_concurrency());
+#endif
+}
+
+// Note: poolMutex should be held
+static void InitializePool()
+{
+	if (poolInitialized)
+		return;
+
+	poolInitialized = true;
+	minWorkerCount = std::min((uint32_t)MAX_WORKER_COUNT, GetPoolProcessorCount());
+	maxWorkerCount = MAX_WORKER_COUNT;
+	minCompletionPortCount = GetPoolProcessorCount();
+	maxCompletionPortCount = MAX_COMPLETION_PORT_THREAD_COUNT;
+	targetWorkerCount.store(minWorkerCount, std::memory_order_relaxed);
+}
+
+static WorkStealingBuffer* AllocateBuffer(int64_t capacity)
+{
+	auto size = sizeof(WorkStealingBuffer) + (capacity - 1) * sizeof(std::atomic<Object*>);
+	auto buffer = (WorkStealingBuffer*)malloc(size);
+	if (buffer == NULL)
+		abort();
+
+	buffer->capacity = capacity;
+	buffer->nextRetired = NULL;
+	for (int64_t i = 0; i < capacity; ++i)
+		new (&buffer->items[i]) std::atomic<Object*>(NULL);
+	return buffer;
+}
+
+static WorkStealingBuffer* GrowBuffer(WorkStealingQueue* queue, WorkStealingBuffer* buffer, int64_t top, int64_t bottom)
+{
+	auto newBuffer = AllocateBuffer(buffer->capacity * 2);
+	for (auto i = top; i < bottom; ++i)
+		newBuffer->items[i & (newBuffer->capacity - 1)].store(buffer->items[i & (buffer->capacity - 1)].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	queue->buffer.store(newBuffer, std::memory_order_release);
+
+	// Thieves might still be reading old buffer
+	retiredBuffersLock.Enter();
+	buffer->nextRetired = retiredBuffers;
+	retiredBuffers = buffer;
+	retiredBuffersLock.Leave();
+
+	return newBuffer;
+}
+
+// Only called by owner
+static void PushLocal(WorkStealingQueue* queue, Object* item)
+{
+	auto bottom = queue->bottom.load(std::memory_order_relaxed);
+	auto top = queue->top.load(std::memory_order_acquire);
+	auto buffer = queue->buffer.load(std::memory_order_relaxed);
+	if (bottom - top >= buffer->capacity)
+		buffer = GrowBuffer(queue, buffer, top, bottom);
+
+	buffer->items[bottom & (buffer->capacity - 1)].store(item, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	queue->bottom.store(bottom + 1, std::memory_order_relaxed);
+}
+
+// Only called by owner
+static Object* PopLocal(WorkStealingQueue* queue)
+{
+	auto bottom = queue->bottom.load(std::memory_order_relaxed) - 1;
+	auto buffer = queue->buffer.load(std::memory_order_relaxed);
+	queue->bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	auto top = queue->top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// Empty
+		queue->bottom.store(bottom + 1, std::memory_order_relaxed);
+		return NULL;
+	}
+
+	auto item = buffer->items[bottom & (buffer->capacity - 1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// Last item: race against thieves
+		if (!queue->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			item = NULL;
+		queue->bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	return item;
+}
+
+// Returns NULL if queue was empty, or if another thread won the race (aborted is set then)
+static Object* Steal(WorkStealingQueue* queue, bool* aborted)
+{
+	auto top = queue->top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	auto bottom = queue->bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+		return NULL;
+
+	auto buffer = queue->buffer.load(std::memory_order_acquire);
+	auto item = buffer->items[top & (buffer->capacity - 1)].load(std::memory_order_relaxed);
+	if (!queue->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		*aborted = true;
+		return NULL;
+	}
+
+	return item;
+}
+
+static bool IsQueueEmpty(WorkStealingQueue* queue)
+{
+	return queue->bottom.load(std::memory_order_seq_cst) <= queue->top.load(std::memory_order_seq_cst);
+}
+
+static void EnqueueGlobal(Object* workItem)
+{
+	globalQueueLock.Enter();
+	if (globalQueue == NULL)
+		globalQueue = new std::deque<Object*>();
+	globalQueue->push_back(workItem);
+	globalQueueCount.fetch_add(1, std::memory_order_seq_cst);
+	globalQueueLock.Leave();
+}
+
+static Object* DequeueGlobal()
+{
+	if (globalQueueCount.load(std::memory_order_relaxed) == 0)
+		return NULL;
+
+	Object* workItem = NULL;
+	globalQueueLock.Enter();
+	if (globalQueue != NULL && !globalQueue->empty())
+	{
+		workItem = globalQueue->front();
+		globalQueue->pop_front();
+		globalQueueCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+	globalQueueLock.Leave();
+
+	return workItem;
+}
+
+static bool HasQueuedWork()
+{
+	if (globalQueueCount.load(std::memory_order_seq_cst) != 0)
+		return true;
+
+	auto slotCount = workerSlotCount.load(std::memory_order_acquire);
+	for (uint32_t i = 0; i < slotCount; ++i)
+	{
+		auto worker = workers[i].load(std::memory_order_acquire);
+		if (worker != NULL && !IsQueueEmpty(&worker->queue))
+			return true;
+	}
+
+	return false;
+}
+
+static Object* StealFromWorkers(Worker* self)
+{
+	auto slotCount = workerSlotCount.load(std::memory_order_acquire);
+	if (slotCount == 0)
+		return NULL;
+
+	// Start from a random victim, so that thieves spread over workers (xorshift)
+	uint32_t start = 0;
+	if (self != NULL)
+	{
+		auto seed = self->randomSeed;
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		self->randomSeed = seed;
+		start = seed % slotCount;
+	}
+
+	// Lost races mean there was work, so try again
+	bool aborted;
+	do
+	{
+		aborted = false;
+		for (uint32_t i = 0; i < slotCount; ++i)
+		{
+			auto victim = workers[(start + i) % slotCount].load(std::memory_order_acquire);
+			if (victim == NULL || victim == self)
+				continue;
+
+			auto item = Steal(&victim->queue, &aborted);
+			if (item != NULL)
+				return item;
+		}
+	} while (aborted);
+
+	return NULL;
+}
+
+static void WorkerThreadStart(void* context);
+static void GateThreadStart(void* context);
+
+// Note: poolMutex should be held
+static void CreateWorker()
+{
+	// Reuse slot of an exited worker if possible
+	Worker* worker = NULL;
+	auto slotCount = workerSlotCount.load(std::memory_order_relaxed);
+	for (uint32_t i = 0; i < slotCount; ++i)
+	{
+		auto slot = workers[i].load(std::memory_order_relaxed);
+		if (!slot->active)
+		{
+			worker = slot;
+			break;
+		}
+	}
+
+	if (worker == NULL)
+	{
+		if (slotCount == MAX_WORKER_COUNT)
+			return;
+
+		worker = new Worker();
+		worker->queue.buffer.store(AllocateBuffer(WORK_STEALING_QUEUE_INITIAL_CAPACITY), std::memory_order_relaxed);
+		worker->randomSeed = slotCount + 1;
+		workers[slotCount].store(worker, std::memory_order_release);
+		workerSlotCount.store(slotCount + 1, std::memory_order_release);
+	}
+
+	// New worker starts looking for work right away
+	worker->active = true;
+	workerCount.fetch_add(1, std::memory_order_relaxed);
+	searchingWorkerCount.fetch_add(1, std::memory_order_seq_cst);
+
+	if (!StartNativeThread(WorkerThreadStart, worker, 0))
+	{
+		worker->active = false;
+		workerCount.fetch_sub(1, std::memory_order_relaxed);
+		searchingWorkerCount.fetch_sub(1, std::memory_order_seq_cst);
+	}
+}
+
+// Note: poolMutex should be held
+static void WakeOrCreateWorker()
+{
+	if (idleWorkerCount > wakeupCount)
+	{
+		wakeupCount++;
+		WakeOnePool(&workAvailableCondition);
+	}
+	else if (workerCount.load(std::memory_order_relaxed) < targetWorkerCount.load(std::memory_order_relaxed))
+	{
+		CreateWorker();
+	}
+
+	// Gate thread watches for starvation while there is work
+	if (!gateStarted)
+	{
+		gateStarted = true;
+		gateActive = true;
+		if (!StartNativeThread(GateThreadStart, NULL, 0))
+			gateStarted = false;
+	}
+	else if (!gateActive)
+	{
+		gateActive = true;
+		WakeOnePool(&gateCondition);
+	}
+}
+
+// Note: poolMutex should be held
+static void RemoveWorker(Worker* worker)
+{
+	worker->active = false;
+	workerCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// Moves work items left in current worker deque to global queue (worker is about to exit)
+static void DrainLocalQueue(Worker* worker)
+{
+	Object* item;
+	while ((item = PopLocal(&worker->queue)) != NULL)
+		EnqueueGlobal(item);
+}
+
+// Returns false if worker should exit. Worker is searching for work when this is called, and when it returns true.
+static bool WaitForWork(Worker* worker)
+{
+	bool keepWorker = true;
+
+	RunPreemptive([&]
+	{
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(WORKER_IDLE_TIMEOUT_MS);
+
+		LockPool();
+		while (true)
+		{
+			// Pairs with ThreadPoolEnqueue: either enqueuer sees we are not searching anymore, or we see its work item
+			searchingWorkerCount.fetch_sub(1, std::memory_order_seq_cst);
+			if (HasQueuedWork())
+			{
+				searchingWorkerCount.fetch_add(1, std::memory_order_seq_cst);
+				break;
+			}
+
+			// Controller wants fewer workers
+			if (workerCount.load(std::memory_order_relaxed) > targetWorkerCount.load(std::memory_order_relaxed))
+			{
+				keepWorker = false;
+				break;
+			}
+
+			idleWorkerCount++;
+			while (wakeupCount == 0 && WaitPool(&workAvailableCondition, &deadline))
+			{
+			}
+			idleWorkerCount--;
+
+			if (wakeupCount > 0)
+			{
+				wakeupCount--;
+				searchingWorkerCount.fetch_add(1, std::memory_order_seq_cst);
+				break;
+			}
+
+			// Idle for too long: workers above minimum exit
+			if (workerCount.load(std::memory_order_relaxed) > minWorkerCount)
+			{
+				keepWorker = false;
+				break;
+			}
+
+			searchingWorkerCount.fetch_add(1, std::memory_order_seq_cst);
+			deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(WORKER_IDLE_TIMEOUT_MS);
+		}
+
+		if (!keepWorker)
+			RemoveWorker(worker);
+		UnlockPool();
+	});
+
+	return keepWorker;
+}
+
+// Returns true if worker was removed (it isn't searching for work anymore then)
+static bool TryRetireWorker(Worker* worker)
+{
+	DrainLocalQueue(worker);
+
+	bool retired = false;
+	RunPreemptive([&]
+	{
+		LockPool();
+		if (workerCount.load(std::memory_order_relaxed) > targetWorkerCount.load(std::memory_order_relaxed))
+		{
+			searchingWorkerCount.fetch_sub(1, std::memory_order_seq_cst);
+			RemoveWorker(worker);
+			retired = true;
+		}
+		UnlockPool();
+	});
+
+	return retired;
+}
+
+static void WorkerThreadStart(void* context)
+{
+	auto worker = (Worker*)context;
+	currentWorker = worker;
+
+	// Pool threads are background threads
+	SetManagedThreadBackground(GetCurrentManagedThread(), true);
+
+	while (true)
+	{
+		if (!System_Threading__ThreadPoolWaitCallback__PerformWaitCallback__())
+		{
+			if (TryRetireWorker(worker))
+				break;
+			continue;
+		}
+
+		if (!WaitForWork(worker))
+			break;
+	}
+
+	currentWorker = NULL;
+}
+
+// Thread count controller: adds a worker when queued work doesn't make progress (workers blocked),
+// and lowers target when workers stay idle (they exit once above target).
+static void GateThreadStart(void* context)
+{
+	auto lastCompletedCount = completedItemCount.load(std::memory_order_relaxed);
+	uint32_t idleIntervals = 0;
+
+	LockPool();
+	while (true)
+	{
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(GATE_INTERVAL_MS);
+		while (WaitPool(&gateCondition, &deadline))
+		{
+		}
+
+		auto completedCount = completedItemCount.load(std::memory_order_relaxed);
+		auto target = targetWorkerCount.load(std::memory_order_relaxed);
+		if (HasQueuedWork())
+		{
+			idleIntervals = 0;
+
+			// Starvation: work is waiting, but nothing completed and nobody is looking for it
+			if (completedCount == lastCompletedCount && searchingWorkerCount.load(std::memory_order_seq_cst) == 0
+				&& idleWorkerCount == 0 && target < maxWorkerCount)
+			{
+				targetWorkerCount.store(target + 1, std::memory_order_relaxed);
+				WakeOrCreateWorker();
+			}
+		}
+		else
+		{
+			// Underused: some workers were idle for a whole interval
+			if (idleWorkerCount > 0 && target > minWorkerCount)
+				targetWorkerCount.store(target - 1, std::memory_order_relaxed);
+
+			// Nothing to watch anymore, wait until more work is requested
+			if (++idleIntervals >= GATE_IDLE_INTERVALS)
+			{
+				gateActive = false;
+				while (!gateActive)
+					WaitPool(&gateCondition, NULL);
+				idleIntervals = 0;
+			}
+		}
+
+		lastCompletedCount = completedCount;
+	}
+}
+
+void ThreadPoolEnqueue(Object* workItem, bool forceGlobal)
+{
+	auto worker = currentWorker;
+	if (worker != NULL && !forceGlobal)
+		PushLocal(&worker->queue, workItem);
+	else
+		EnqueueGlobal(workItem);
+
+	// Pairs with WaitForWork: either a worker going idle sees this item, or we see it isn't searching anymore
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	ThreadPoolRequestWorker();
+}
+
+Object* ThreadPoolDequeue()
+{
+	auto worker = currentWorker;
+
+	Object* workItem = NULL;
+	if (worker != NULL)
+		workItem = PopLocal(&worker->queue);
+	if (workItem == NULL)
+		workItem = DequeueGlobal();
+	if (workItem == NULL)
+		workItem = StealFromWorkers(worker);
+
+	// Last searching worker found something: make sure someone else looks for remaining work
+	if (workItem != NULL && worker != NULL)
+	{
+		if (searchingWorkerCount.fetch_sub(1, std::memory_order_seq_cst) == 1 && HasQueuedWork())
+			ThreadPoolRequestWorker();
+	}
+
+	return workItem;
+}
+
+bool ThreadPoolTryPopLocal(Object* workItem)
+{
+	auto worker = currentWorker;
+	if (worker == NULL)
+		return false;
+
+	auto item = PopLocal(&worker->queue);
+	if (item == workItem)
+		return true;
+
+	// Not the last one, put it back
+	if (item != NULL)
+		PushLocal(&worker->queue, item);
+	return false;
+}
+
+void ThreadPoolRequestWorker()
+{
+	// A worker looking for work will find it (it checks queues again before going idle)
+	if (searchingWorkerCount.load(std::memory_order_seq_cst) != 0)
+		return;
+
+	LockPool();
+	InitializePool();
+	WakeOrCreateWorker();
+	UnlockPool();
+}
+
+bool ThreadPoolNotifyWorkItemComplete()
+{
+	completedItemCount.fetch_add(1, std::memory_order_relaxed);
+	if (currentWorker != NULL)
+		searchingWorkerCount.fetch_add(1, std::memory_order_seq_cst);
+
+	return workerCount.load(std::memory_order_relaxed) <= targetWorkerCount.load(std::memory_order_relaxed);
+}
+
+void ThreadPoolNotifyWorkItemProgress()
+{
+	completedItemCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool IsThreadPoolWorkerThread()
+{
+	return currentWorker != NULL;
+}
+
+bool ThreadPoolSetMinThreads(int32_t workerThreads, int32_t completionPortThreads)
+{
+	bool result = false;
+
+	LockPool();
+	InitializePool();
+	if (workerThreads >= 0 && completionPortThreads >= 0
+		&& (uint32_t)workerThreads <= maxWorkerCount && (uint32_t)completionPortThreads <= maxCompletionPortCount)
+	{
+		minWorkerCount = std::max(1u, (uint32_t)workerThreads);
+		minCompletionPortCount = (uint32_t)completionPortThreads;
+		if (targetWorkerCount.load(std::memory_order_relaxed) < minWorkerCount)
+			targetWorkerCount.store(minWorkerCount, std::memory_order_relaxed);
+		result = true;
+	}
+	UnlockPool();
+
+	return result;
+}
+
+bool ThreadPoolSetMaxThreads(int32_t workerThreads, int32_t completionPortThreads)
+{
+	bool result = false;
+
+	LockPool();
+	InitializePool();
+	if (workerThreads > 0 && completionPortThreads > 0
+		&& (uint32_t)workerThreads >= minWorkerCount && (uint32_t)completionPortThreads >= minCompletionPortCount)
+	{
+		maxWorkerCount = std::min((uint32_t)MAX_WORKER_COUNT, (uint32_t)workerThreads);
+		maxCompletionPortCount = (uint32_t)completionPortThreads;
+		if (targetWorkerCount.load(std::memory_order_relaxed) > maxWorkerCount)
+			targetWorkerCount.store(maxWorkerCount, std::memory_order_relaxed);
+		result = true;
+	}
+	UnlockPool();
+
+	return result;
+}
+
+void ThreadPoolGetMinThreads(int32_t* workerThreads, int32_t* completionPortThreads)
+{
+	LockPool();
+	InitializePool();
+	*workerThreads = (int32_t)minWorkerCount;
+	*completionPortThreads = (int32_t)minCompletionPortCount;
+	UnlockPool();
+}
+
+void ThreadPoolGetMaxThreads(int32_t* workerThreads, int32_t* completionPortThreads)
+{
+	LockPool();
+	InitializePool();
+	*workerThreads = (int32_t)maxWorkerCount;
+	*completionPortThreads = (int32_t)maxCompletionPortCount;
+	UnlockPool();
+}
+
+void ThreadPoolGetAvailableThreads(int32_t* workerThreads, int32_t* completionPortThreads)
+{
+	LockPool();
+	InitializePool();
+	auto busyWorkerCount = workerCount.load(std::memory_order_relaxed) - idleWorkerCount;
+	*workerThreads = (int32_t)(maxWorkerCount > busyWorkerCount ? maxWorkerCount - busyWorkerCount : 0);
+	*completionPortThreads = (int32_t)maxCompletionPortCount;
+	UnlockPool();
+}
+
+void ScanThreadPoolQueues(ThreadPoolMarkCallback mark)
+{
+	globalQueueLock.Enter();
+	if (globalQueue != NULL)
+	{
+		for (auto workItem : *globalQueue)
+			mark(workItem);
+	}
+	globalQueueLock.Leave();
+
+	auto slotCount = workerSlotCount.load(std::memory_order_acquire);
+	for (uint32_t i = 0; i < slotCount; ++i)
+	{
+		auto queue = &workers[i].load(std::memory_order_acquire)->queue;
+		auto buffer = queue->buffer.load(std::memory_order_acquire);
+		auto bottom = queue->bottom.load(std::memory_order_acquire);
+		for (auto index = queue->top.load(std::memory_order_acquire); index < bottom; ++index)
+			mark(buffer->items[index & (buffer->capacity - 1)].load(std::memory_order_relaxed));
+	}
+
+	retiredBuffersLock.Enter();
+	while (retiredBuffers != NULL)
+	{
+		auto next = retiredBuffers->nextRetired;
+		free(retiredBuffers);
+		retiredBuffers = next;
+	}
+	retiredBuffersLock.Leave();
+}
@@ -0,0 +1,41 @@
+#ifndef SHARPLANG_THREAD_POOL_H
+#define SHARPLANG_THREAD_POOL_H
+
+#include <stdint.h>
+
+class Object;
+
+// Work items (IThreadPoolWorkItem) are queued natively: each worker owns a work-stealing deque (Chase-Lev),
+// and other threads push to a global injection queue. Workers run ThreadPoolWorkQueue.Dispatch, which dequeues from there.
+
+// Queues work item in current worker deque, or in global queue if not called from a worker (or if forceGlobal is set)
+void ThreadPoolEnqueue(Object* workItem, bool forceGlobal);
+
+// Looks in current worker deque, then global queue, then other worker deques. Returns NULL if nothing was found.
+Object* ThreadPoolDequeue();
+
+// Removes work item if it is the last one queued by current worker (used to run tasks inline)
+bool ThreadPoolTryPopLocal(Object* workItem);
+
+// Makes sure a worker will look for queued work (wakes or creates one if none is looking already)
+void ThreadPoolRequestWorker();
+
+// Called by workers after each work item. Returns false if this worker should go back to the pool (too many workers).
+bool ThreadPoolNotifyWorkItemComplete();
+void ThreadPoolNotifyWorkItemProgress();
+
+bool IsThreadPoolWorkerThread();
+
+// Worker thread limits (completion port limits are only recorded)
+bool ThreadPoolSetMinThreads(int32_t workerThreads, int32_t completionPortThreads);
+bool ThreadPoolSetMaxThreads(int32_t workerThreads, int32_t completionPortThreads);
+void ThreadPoolGetMinThreads(int32_t* workerThreads, int32_t* completionPortThreads);
+void ThreadPoolGetMaxThreads(int32_t* workerThreads, int32_t* completionPortThreads);
+void ThreadPoolGetAvailableThreads(int32_t* workerThreads, int32_t* completionPortThreads);
+
+// Used by GC: queued work items are roots.
+// Deque buffers replaced when growing are freed here as well (threads are suspended, so no thief can still read them).
+typedef void (*ThreadPoolMarkCallback)(Object* obj);
+void ScanThreadPoolQueues(ThreadPoolMarkCallback mark);
+
+#endif
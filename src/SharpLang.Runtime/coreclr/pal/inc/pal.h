@@ -3080,6 +3080,8 @@ SetErrorMode(
 #define MEM_TOP_DOWN                    0x100000
 #define MEM_WRITE_WATCH                 0x200000
 
+#define WRITE_WATCH_FLAG_RESET          0x01
+
 PALIMPORT
 HANDLE
 PALAPI
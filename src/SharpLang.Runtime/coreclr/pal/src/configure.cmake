@@ -24,6 +24,8 @@ check_include_files(crt_externs.h HAVE_CRT_EXTERNS_H)
 check_include_files(sys/time.h HAVE_SYS_TIME_H)
 check_include_files(pthread_np.h HAVE_PTHREAD_NP_H)
 check_include_files(sys/lwp.h HAVE_SYS_LWP_H)
+check_include_files(linux/futex.h HAVE_LINUX_FUTEX_H)
+check_include_files(sys/eventfd.h HAVE_SYS_EVENTFD_H)
 check_include_files(xlocale.h HAVE_XLOCALE)
 
 check_function_exists(kqueue HAVE_KQUEUE)
@@ -32,6 +32,7 @@ Abstract:
 #include "pal/init.h"
 #include "pal/process.h"
 #include "pal/debug.h"
+#include "pal/virtual.h"
 
 #include <signal.h>
 #include <errno.h>
@@ -319,6 +320,30 @@ static void sigfpe_handler(int code, siginfo_t *siginfo, void *context)
     TRACE("SIGFPE Signal was handled; continuing execution.\n");
 }
 
+/*++
+Function :
+    is_write_fault
+
+    Returns whether a SIGSEGV was caused by a write, using the page fault
+    error code where the platform provides it (TRUE otherwise)
+
+Parameters :
+    native_context_t *ucontext : context of the fault
+--*/
+static BOOL is_write_fault(native_context_t *ucontext)
+{
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+    // Bit 1 of the x86 page fault error code is set for writes
+    return (ucontext->uc_mcontext.gregs[REG_ERR] & 0x2) != 0;
+#elif defined(__APPLE__) && defined(__x86_64__)
+    return (ucontext->uc_mcontext->__es.__err & 0x2) != 0;
+#elif defined(__FreeBSD__) && defined(__x86_64__)
+    return (ucontext->uc_mcontext.mc_err & 0x2) != 0;
+#else
+    return TRUE;
+#endif
+}
+
 /*++
 Function :
     sigsegv_handler
@@ -333,6 +358,15 @@ Parameters :
 static void sigsegv_handler(int code, siginfo_t *siginfo, void *context)
 {
     check_pal_initialize(code);
+
+    // First write to a page of a MEM_WRITE_WATCH region: it has been recorded,
+    // restart the faulting instruction
+    if (VIRTUALHandleWriteWatchFault((UINT_PTR)siginfo->si_addr,
+                                     is_write_fault((native_context_t *)context)))
+    {
+        return;
+    }
+
     EXCEPTION_RECORD record;
     EXCEPTION_POINTERS pointers;
     native_context_t *ucontext;
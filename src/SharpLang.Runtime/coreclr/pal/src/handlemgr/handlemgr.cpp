@@ -25,6 +25,8 @@ Abstract:
 #include "pal/malloc.hpp"
 #include "pal/dbgmsg.h"
 
+#include <sched.h>
+
 using namespace CorUnix;
 
 SET_DEFAULT_DEBUG_CHANNEL(HANDLE);
@@ -47,36 +49,75 @@ CSimpleHandleManager::Initialize(
     InternalInitializeCriticalSection(&m_csLock);
     m_fLockInitialized = TRUE;
 
-    m_dwTableGrowthRate = c_BasicGrowthRate;
-
-    /* initialize the handle table - the free list is stored in the 'object'
-       field, with the head in the global 'm_hiFreeListStart'. */
-    m_dwTableSize = m_dwTableGrowthRate;
-    
-    m_rghteHandleTable = reinterpret_cast<HANDLE_TABLE_ENTRY*>(InternalMalloc(InternalGetCurrentThread(), (m_dwTableSize * sizeof(HANDLE_TABLE_ENTRY))));
-    if(NULL == m_rghteHandleTable)
+    /* initialize the handle table with its first segment - the free list is
+       stored in the 'object' field, with the head in 'm_hiFreeListStart'. */
+    palError = GrowHandleTable(InternalGetCurrentThread());
+    if (NO_ERROR != palError)
     {
-        ERROR("Unable to create initial handle table array");
-        palError = ERROR_OUTOFMEMORY;
+        ERROR("Unable to create initial handle table segment");
         goto InitializeExit;
     }
 
-    for (DWORD i = 0; i < m_dwTableSize; i++)
+    TRACE("Handle Manager initialization complete.\n");
+
+InitializeExit:
+    
+    return palError;
+}
+
+/*++
+Function :
+    GrowHandleTable
+
+    Adds a segment to the handle table, and its entries to the (empty) free
+    list. Entries of existing segments don't move, so concurrent lookups
+    are not affected. The handle manager lock must be held.
+--*/
+PAL_ERROR
+CSimpleHandleManager::GrowHandleTable(
+    CPalThread *pThread
+    )
+{
+    DWORD dwSegment = m_dwSegmentCount;
+    HANDLE_INDEX hiFirst = dwSegment * c_SegmentSize;
+    HANDLE_TABLE_ENTRY* rghteSegment;
+
+    _ASSERTE(c_hiInvalid == m_hiFreeListStart);
+
+    /* make sure handle values don't overflow */
+    if (dwSegment >= c_MaxSegmentCount)
     {
-        m_rghteHandleTable[i].u.hiNextIndex = i + 1;
-        m_rghteHandleTable[i].fEntryAllocated = FALSE;
+        WARN("Unable to allocate handle : maximum (%d) reached!\n",
+             dwSegment * c_SegmentSize);
+        return ERROR_OUTOFMEMORY;
     }
 
-    m_rghteHandleTable[m_dwTableSize - 1].u.hiNextIndex = (HANDLE_INDEX)-1;
+    rghteSegment = reinterpret_cast<HANDLE_TABLE_ENTRY*>(InternalMalloc(
+        pThread,
+        c_SegmentSize * sizeof(HANDLE_TABLE_ENTRY)));
     
-    m_hiFreeListStart = 0;
-    m_hiFreeListEnd = m_dwTableSize - 1;
+    if (NULL == rghteSegment)
+    {
+        WARN("not enough memory to grow handle table!\n");
+        return ERROR_OUTOFMEMORY;
+    }
 
-    TRACE("Handle Manager initialization complete.\n");
+    /* new handles are initially invalid */
+    for (DWORD dw = 0; dw < c_SegmentSize; dw += 1)
+    {
+        rghteSegment[dw].u.hiNextIndex = hiFirst + dw + 1;
+        rghteSegment[dw].lState = 0;
+    }
+    rghteSegment[c_SegmentSize - 1].u.hiNextIndex = c_hiInvalid;
 
-InitializeExit:
-    
-    return palError;
+    m_hiFreeListStart = hiFirst;
+    m_hiFreeListEnd = hiFirst + c_SegmentSize - 1;
+
+    /* publish the segment before handles it contains can be looked up */
+    m_rgpSegments[dwSegment] = rghteSegment;
+    m_dwSegmentCount = dwSegment + 1;
+
+    return NO_ERROR;
 }
 
 PAL_ERROR
@@ -89,7 +130,8 @@ CSimpleHandleManager::AllocateHandle(
     )
 {
     PAL_ERROR palError = NO_ERROR;
-    DWORD dwIndex;
+    HANDLE_INDEX hi;
+    HANDLE_TABLE_ENTRY* phte;
 
     Lock(pThread);
 
@@ -97,57 +139,22 @@ CSimpleHandleManager::AllocateHandle(
        add new handles to the pool */
     if (m_hiFreeListStart == c_hiInvalid)
     {
-        HANDLE_TABLE_ENTRY* rghteTempTable;
-
         TRACE("Handle pool empty (%d handles allocated), growing handle table "
-              "by %d entries.\n", m_dwTableSize, m_dwTableGrowthRate );
-
-        /* make sure handle values don't overflow */
-        if (m_dwTableSize + m_dwTableGrowthRate >= c_MaxIndex)
-        {
-            WARN("Unable to allocate handle : maximum (%d) reached!\n",
-                 m_dwTableSize);
-            palError = ERROR_OUTOFMEMORY;
-            goto AllocateHandleExit;
-        }
+              "by %d entries.\n", m_dwSegmentCount * c_SegmentSize, c_SegmentSize);
 
-        /* grow handle table */
-        rghteTempTable = reinterpret_cast<HANDLE_TABLE_ENTRY*>(InternalRealloc(
-            pThread,
-            m_rghteHandleTable,
-            (m_dwTableSize + m_dwTableGrowthRate) * sizeof(HANDLE_TABLE_ENTRY)));
-        
-        if (NULL == rghteTempTable)
+        palError = GrowHandleTable(pThread);
+        if (NO_ERROR != palError)
         {
-            WARN("not enough memory to grow handle table!\n");
-            palError = ERROR_OUTOFMEMORY;
             goto AllocateHandleExit;
         }
-        m_rghteHandleTable = rghteTempTable;
-
-        /* update handle table and handle pool */
-        for (DWORD dw = m_dwTableSize; dw < m_dwTableSize + m_dwTableGrowthRate; dw += 1)
-        {
-            /* new handles are initially invalid */
-            /* the last "old" handle was m_dwTableSize-1, so the new
-               handles range from m_dwTableSize to
-               m_dwTableSize+m_dwTableGrowthRate-1 */
-            m_rghteHandleTable[dw].u.hiNextIndex = dw + 1;
-            m_rghteHandleTable[dw].fEntryAllocated = FALSE;
-        }
-
-        m_hiFreeListStart = m_dwTableSize;
-        m_dwTableSize += m_dwTableGrowthRate;
-        m_rghteHandleTable[m_dwTableSize - 1].u.hiNextIndex = (HANDLE_INDEX)-1;
-        m_hiFreeListEnd = m_dwTableSize - 1;
-        
     }
 
     /* take the next free handle */
-    dwIndex = m_hiFreeListStart;
+    hi = m_hiFreeListStart;
+    phte = GetEntry(hi);
 
     /* remove the handle from the pool */
-    m_hiFreeListStart = m_rghteHandleTable[dwIndex].u.hiNextIndex;
+    m_hiFreeListStart = phte->u.hiNextIndex;
     
     /* clear the tail record if this is the last handle slot available */
     if(m_hiFreeListStart == c_hiInvalid) 
@@ -156,13 +163,17 @@ CSimpleHandleManager::AllocateHandle(
     }
 
     /* save the data associated with the new handle */
-    *ph = HandleIndexToHandle(dwIndex);
+    *ph = HandleIndexToHandle(hi);
     
     pObject->AddReference();
-    m_rghteHandleTable[dwIndex].u.pObject = pObject;
-    m_rghteHandleTable[dwIndex].dwAccessRights = dwAccessRights;
-    m_rghteHandleTable[dwIndex].fInheritable = fInheritable;
-    m_rghteHandleTable[dwIndex].fEntryAllocated = TRUE;
+    phte->u.pObject = pObject;
+    phte->dwAccessRights = dwAccessRights;
+    phte->fInheritable = fInheritable;
+
+    /* publish the entry to lookups (nobody references a free entry, so
+       its state is 0 here) */
+    _ASSERTE(0 == phte->lState);
+    phte->lState = c_EntryAllocated;
 
 AllocateHandleExit:
 
@@ -179,29 +190,45 @@ CSimpleHandleManager::GetObjectFromHandle(
     IPalObject **ppObject
     )
 {
-    PAL_ERROR palError = NO_ERROR;
-    HANDLE_INDEX hi;
+    HANDLE_TABLE_ENTRY* phte;
+    LONG lState, lNewState;
 
-    Lock(pThread);
-    
     if (!ValidateHandle(h))
     {
         ERROR("Tried to dereference an invalid handle %p\n", h);
-        palError = ERROR_INVALID_HANDLE;
-        goto GetObjectFromHandleExit;
+        return ERROR_INVALID_HANDLE;
     }
     
-    hi = HandleToHandleIndex(h);
+    phte = GetEntry(HandleToHandleIndex(h));
+
+    /* register as reader of the entry, as long as it is allocated: 
+       FreeHandle won't release the object until we're done */
+    lState = phte->lState;
+    while (true)
+    {
+        if (0 == (lState & c_EntryAllocated))
+        {
+            ERROR("Tried to dereference a freed handle %p\n", h);
+            return ERROR_INVALID_HANDLE;
+        }
 
-    *pdwRightsGranted = m_rghteHandleTable[hi].dwAccessRights;
-    *ppObject = m_rghteHandleTable[hi].u.pObject;
+        lNewState = InterlockedCompareExchange(&phte->lState,
+                                               lState + c_EntryReaderIncrement,
+                                               lState);
+        if (lNewState == lState)
+        {
+            break;
+        }
+        lState = lNewState;
+    }
+
+    *pdwRightsGranted = phte->dwAccessRights;
+    *ppObject = phte->u.pObject;
     (*ppObject)->AddReference();
-    
-GetObjectFromHandleExit:
 
-    Unlock(pThread);
+    InterlockedExchangeAdd(&phte->lState, -c_EntryReaderIncrement);
 
-    return palError;
+    return NO_ERROR;
 }
 
 PAL_ERROR
@@ -210,52 +237,75 @@ CSimpleHandleManager::FreeHandle(
     HANDLE h
     )
 {
-    PAL_ERROR palError = NO_ERROR;
-    IPalObject *pobj = NULL;
+    HANDLE_TABLE_ENTRY* phte;
+    IPalObject *pobj;
     HANDLE_INDEX hi = HandleToHandleIndex(h);
-
-    Lock(pThread);
+    LONG lState, lNewState;
 
     if (!ValidateHandle(h))
     {
         ERROR("Trying to free invalid handle %p.\n", h);
-        palError = ERROR_INVALID_HANDLE;
-        goto FreeHandleExit;
+        return ERROR_INVALID_HANDLE;
     }
 
     if (HandleIsSpecial(h))
     {
         ASSERT("Trying to free Special Handle %p.\n", h);
-        palError = ERROR_INVALID_HANDLE;
-        goto FreeHandleExit;
+        return ERROR_INVALID_HANDLE;
     }
 
-    pobj = m_rghteHandleTable[hi].u.pObject;
-    m_rghteHandleTable[hi].fEntryAllocated = FALSE;
+    phte = GetEntry(hi);
+
+    /* unpublish the entry, so that no new lookup can reference its object
+       (only one thread can free a given handle) */
+    lState = phte->lState;
+    while (true)
+    {
+        if (0 == (lState & c_EntryAllocated))
+        {
+            ERROR("Trying to free handle %p twice.\n", h);
+            return ERROR_INVALID_HANDLE;
+        }
+
+        lNewState = InterlockedCompareExchange(&phte->lState,
+                                               lState & ~c_EntryAllocated,
+                                               lState);
+        if (lNewState == lState)
+        {
+            break;
+        }
+        lState = lNewState;
+    }
+
+    /* wait for lookups still referencing the object (they only hold
+       the entry for a few instructions) */
+    while (0 != phte->lState)
+    {
+        sched_yield();
+    }
+
+    pobj = phte->u.pObject;
 
     /* add handle to the free pool */
+    Lock(pThread);
+
     if(m_hiFreeListEnd != c_hiInvalid)
     {
-        m_rghteHandleTable[m_hiFreeListEnd].u.hiNextIndex = hi;
+        GetEntry(m_hiFreeListEnd)->u.hiNextIndex = hi;
     }
     else
     {
         m_hiFreeListStart = hi;
     }
     
-    m_rghteHandleTable[hi].u.hiNextIndex = c_hiInvalid;
+    phte->u.hiNextIndex = c_hiInvalid;
     m_hiFreeListEnd = hi;
 
-FreeHandleExit:    
-
     Unlock(pThread);
 
-    if (NULL != pobj)
-    {
-        pobj->ReleaseReference(pThread);
-    }
+    pobj->ReleaseReference(pThread);
 
-    return palError;
+    return NO_ERROR;
 }
 
 /*++
@@ -272,9 +322,9 @@ Return Value :
 --*/
 bool CSimpleHandleManager::ValidateHandle(HANDLE handle)
 {
-    DWORD dwIndex;
+    HANDLE_INDEX hi;
     
-    if (NULL == m_rghteHandleTable)
+    if (0 == m_dwSegmentCount)
     {
         ASSERT("Handle Manager is not initialized!\n");
         return FALSE;
@@ -300,15 +350,19 @@ bool CSimpleHandleManager::ValidateHandle(HANDLE handle)
         return FALSE;
     }
 
-    dwIndex = HandleToHandleIndex(handle);
+    hi = HandleToHandleIndex(handle);
 
-    if (dwIndex >= m_dwTableSize)
+    if (hi >= (HANDLE_INDEX)m_dwSegmentCount * c_SegmentSize)
     {
         WARN( "The handle value(%p) is out of the bounds for the handle table.\n", handle );
         return FALSE;
     }
 
-    if (!m_rghteHandleTable[dwIndex].fEntryAllocated)
+    //
+    // Note: without the lock, the entry can still be freed (or allocated)
+    // concurrently; callers check its state again atomically
+    //
+    if (0 == (GetEntry(hi)->lState & c_EntryAllocated))
     {
         WARN("The handle value (%p) has not been allocated\n", handle);
         return FALSE;
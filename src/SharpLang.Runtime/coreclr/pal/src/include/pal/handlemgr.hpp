@@ -39,8 +39,13 @@ namespace CorUnix
     class CSimpleHandleManager
     {
     private:
-        enum { c_BasicGrowthRate = 1024 };
-        enum { c_MaxIndex = 0x3FFFFFFE };
+        //
+        // The handle table is made of fixed size segments that never move
+        // once allocated, so that handles can be looked up without taking
+        // the lock (only allocating and freeing handles take it)
+        //
+        enum { c_SegmentSize = 1024 };
+        enum { c_MaxSegmentCount = 16384 };
 
         typedef UINT_PTR HANDLE_INDEX;
         static const HANDLE_INDEX c_hiInvalid = (HANDLE_INDEX) -1;
@@ -57,6 +62,16 @@ namespace CorUnix
             return (HANDLE_INDEX) (((UINT_PTR) h) >> 2) - 1;
         };
 
+        //
+        // Entry state: c_EntryAllocated is set while the entry holds an
+        // object; the remaining bits count the lookups currently taking a
+        // reference on that object. FreeHandle clears c_EntryAllocated, then
+        // waits for that count to drop to zero before releasing the object
+        // and recycling the entry.
+        //
+        enum { c_EntryAllocated = 1 };
+        enum { c_EntryReaderIncrement = 2 };
+
         typedef struct _HANDLE_TABLE_ENTRY
         {
             union
@@ -68,19 +83,30 @@ namespace CorUnix
             DWORD dwAccessRights;
             bool fInheritable;
             
-            bool fEntryAllocated;
+            Volatile<LONG> lState;
         } HANDLE_TABLE_ENTRY;
 
         HANDLE_INDEX m_hiFreeListStart;
         HANDLE_INDEX m_hiFreeListEnd;
         
-        DWORD m_dwTableSize;
-        DWORD m_dwTableGrowthRate;
-        HANDLE_TABLE_ENTRY* m_rghteHandleTable;
+        //
+        // Segments are published (with release semantics) before the
+        // segment count is incremented
+        //
+        Volatile<DWORD> m_dwSegmentCount;
+        HANDLE_TABLE_ENTRY* m_rgpSegments[c_MaxSegmentCount];
 
         CRITICAL_SECTION m_csLock;
         bool m_fLockInitialized;
 
+        HANDLE_TABLE_ENTRY*
+        GetEntry(HANDLE_INDEX hi)
+        {
+            return &m_rgpSegments[hi / c_SegmentSize][hi % c_SegmentSize];
+        };
+
+        PAL_ERROR GrowHandleTable(CPalThread *pThread);
+
         bool ValidateHandle(HANDLE h);
 
     public:
@@ -89,9 +115,7 @@ namespace CorUnix
             :
             m_hiFreeListStart(c_hiInvalid),
             m_hiFreeListEnd(c_hiInvalid),
-            m_dwTableSize(0),
-            m_dwTableGrowthRate(c_BasicGrowthRate),
-            m_rghteHandleTable(NULL),
+            m_dwSegmentCount(0),
             m_fLockInitialized(FALSE)
         {
         };
@@ -104,9 +128,9 @@ namespace CorUnix
                 DeleteCriticalSection(&m_csLock);
             }
 
-            if (NULL != m_rghteHandleTable)
+            for (DWORD dw = 0; dw < m_dwSegmentCount; dw += 1)
             {
-                InternalFree(InternalGetCurrentThread(), m_rghteHandleTable);
+                InternalFree(InternalGetCurrentThread(), m_rgpSegments[dw]);
             }
         }
 
@@ -126,6 +150,7 @@ namespace CorUnix
 
         //
         // On success this will add a reference to the returned object.
+        // This doesn't take the handle manager lock.
         //
 
         PAL_ERROR
@@ -142,6 +167,10 @@ namespace CorUnix
             HANDLE h
             );
 
+        //
+        // Protects the free list (held while allocating and freeing handles)
+        //
+
         void
         Lock(
             CPalThread *pThread
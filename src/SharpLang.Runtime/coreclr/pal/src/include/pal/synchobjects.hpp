@@ -36,6 +36,15 @@ Abstract:
 #define SharedIDToTypePointer(TYPE,shID) SHMPTR_TO_TYPED_PTR(TYPE, shID)
 #define RawSharedObjectAlloc(szSize, shPoolId) SHMalloc(szSize)
 #define RawSharedObjectFree(shID) SHMfree(shID)
+
+// On Linux, local threads block on a futex (the native wait predicate)
+// instead of a pthread condition: signaling a waiting thread doesn't
+// need to take its mutex anymore, and it takes a single syscall
+#if HAVE_LINUX_FUTEX_H && !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING
+#define SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING 1
+#else
+#define SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING 0
+#endif
     
 namespace CorUnix
 {   
@@ -87,6 +96,9 @@ namespace CorUnix
     typedef struct _ThreadNativeWaitData 
     {
 #if !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING
+        // With SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING iPred is the futex
+        // word, and mutex/cond are only used for the worker thread's
+        // shutdown handshake
         pthread_mutex_t     mutex;
         pthread_cond_t      cond;  
         int                 iPred;
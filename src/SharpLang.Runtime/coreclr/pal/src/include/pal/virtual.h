@@ -46,6 +46,9 @@ typedef struct _CMI {
     BYTE * pDirtyPages;         /* Pages that need to be cleared if re-committed */
 #endif // MMAP_DOESNOT_ALLOW_REMAP
 
+    BYTE * pWriteWatchState;    /* Pages written since the last reset, only for */
+                                /* regions allocated with MEM_WRITE_WATCH. */
+
 }CMI, * PCMI;
 
 enum VIRTUAL_CONSTANTS
@@ -102,6 +105,18 @@ Function :
 --*/
 BOOL VIRTUALOwnedRegion( IN UINT_PTR address );
 
+/*++
+Function :
+    VIRTUALHandleWriteWatchFault
+
+    Called when an access violation occurs. If a write faulted in a write
+    watched page, records the write and restores write access to the page.
+    Doesn't lock, so that it can be called from the SIGSEGV handler.
+
+    Returns TRUE if the faulting instruction can be restarted.
+--*/
+BOOL VIRTUALHandleWriteWatchFault( IN UINT_PTR address, IN BOOL isWrite );
+
 
 #ifdef __cplusplus
 }
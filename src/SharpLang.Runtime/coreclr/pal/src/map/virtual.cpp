@@ -59,6 +59,23 @@ typedef struct FREE_BLOCK {
 // The first node in our list of allocated blocks.
 static PCMI pVirtualMemory;
 
+// Regions allocated with MEM_WRITE_WATCH, for VIRTUALHandleWriteWatchFault.
+// The SIGSEGV handler can't take virtual_critsec (the faulting thread might
+// own it already), so it looks them up without locking: slots are only
+// modified while owning virtual_critsec, and pInformation is published last
+// (and cleared first) with a barrier.
+#define MAX_WRITE_WATCH_REGIONS 64
+
+typedef struct _WRITE_WATCH_REGION {
+    UINT_PTR startBoundary;
+    SIZE_T memSize;
+    PCMI volatile pInformation;     /* NULL if the slot is free. */
+} WRITE_WATCH_REGION;
+
+static WRITE_WATCH_REGION writeWatchRegions[MAX_WRITE_WATCH_REGIONS];
+
+static void VIRTUALUnpublishWriteWatchRegion( CONST PCMI pInformation );
+
 #if MMAP_IGNORES_HINT
 // The first node in our list of freed blocks.
 static FREE_BLOCK *pFreeMemory;
@@ -145,6 +162,11 @@ void VIRTUALCleanup()
 #if MMAP_DOESNOT_ALLOW_REMAP
         InternalFree( pthrCurrent, pEntry->pDirtyPages );
 #endif
+        if (pEntry->pWriteWatchState)
+        {
+            VIRTUALUnpublishWriteWatchRegion( pEntry );
+            InternalFree( pthrCurrent, pEntry->pWriteWatchState );
+        }
         pTempEntry = pEntry;
         pEntry = pEntry->pNext;
         InternalFree( pthrCurrent, pTempEntry );
@@ -502,6 +524,233 @@ static BOOL VIRTUALSetDirtyPages( UINT nStatus, SIZE_T nStartingBit,
 }
 #endif // MMAP_DOESNOT_ALLOW_REMAP
 
+/****
+ *
+ * VIRTUALIsPageWritten
+ *
+ *  SIZE_T nBitToRetrieve - Which page to check.
+ *
+ *  Returns TRUE if the page was written since the last write watch reset,
+ *  FALSE otherwise.
+ *
+ */
+static BOOL VIRTUALIsPageWritten( SIZE_T nBitToRetrieve, CONST PCMI pInformation )
+{
+    SIZE_T nByteOffset = 0;
+    UINT nBitOffset = 0;
+    UINT byteMask = 0;
+
+    if ( !pInformation || !pInformation->pWriteWatchState )
+    {
+        ERROR( "pInformation was NULL or not write watched!\n" );
+        return FALSE;
+    }
+
+    nByteOffset = nBitToRetrieve / CHAR_BIT;
+    nBitOffset = nBitToRetrieve % CHAR_BIT;
+
+    byteMask = 1 << nBitOffset;
+
+    if ( pInformation->pWriteWatchState[ nByteOffset ] & byteMask )
+    {
+        return TRUE;
+    }
+    else
+    {
+        return FALSE;
+    }
+}
+
+/****
+ *
+ * VIRTUALSetWriteWatchState
+ *
+ *  IN UINT nStatus - 0: page not written, any other value: page written
+ *  IN SIZE_T nStartingBit - The bit to set.
+ *
+ *  IN SIZE_T nNumberOfBits - The range of bits to set.
+ *  IN PCMI pStateArray - A pointer the array to be manipulated.
+ *
+ *  Returns TRUE on success, FALSE otherwise.
+ *  Turns bit(s) on/off bit to indicate written page(s)
+ *
+ */
+static BOOL VIRTUALSetWriteWatchState( UINT nStatus, SIZE_T nStartingBit,
+                           SIZE_T nNumberOfBits, CONST PCMI pInformation )
+{
+    TRACE( "VIRTUALSetWriteWatchState( nStatus = %d, nStartingBit = %d, "
+           "nNumberOfBits = %d, pStateArray = 0x%p )\n",
+           nStatus, nStartingBit, nNumberOfBits, pInformation );
+
+    SIZE_T index;
+
+    if ( !pInformation || !pInformation->pWriteWatchState )
+    {
+        ERROR( "pInformation was invalid or not write watched!\n" );
+        return FALSE;
+    }
+
+    // Bits are changed atomically, as VIRTUALHandleWriteWatchFault sets them
+    // without owning the critical section
+    for ( index = nStartingBit; index < nStartingBit + nNumberOfBits; index++ )
+    {
+        BYTE * pByte = &pInformation->pWriteWatchState[ index / CHAR_BIT ];
+        BYTE byteMask = (BYTE)( 1 << ( index % CHAR_BIT ) );
+
+        if ( nStatus != 0 )
+        {
+            __sync_fetch_and_or( pByte, byteMask );
+        }
+        else
+        {
+            __sync_fetch_and_and( pByte, (BYTE)~byteMask );
+        }
+    }
+
+    return TRUE;
+}
+
+/****
+ *
+ * VIRTUALGetWriteWatchProtection
+ *
+ *  IN SIZE_T nPage - The page within the region.
+ *
+ *  Returns the unix protection a write watched page is given until it is
+ *  written, or 0 if the page doesn't need to trap writes (not committed,
+ *  not writable or already written).
+ *
+ */
+static INT VIRTUALGetWriteWatchProtection( SIZE_T nPage, CONST PCMI pInformation )
+{
+    if ( !VIRTUALIsPageCommitted( nPage, pInformation ) ||
+         VIRTUALIsPageWritten( nPage, pInformation ) )
+    {
+        return 0;
+    }
+
+    switch ( pInformation->pProtectionState[ nPage ] )
+    {
+    case VIRTUAL_READWRITE :
+        return PROT_READ;
+    case VIRTUAL_EXECUTE_READWRITE :
+        return PROT_READ | PROT_EXEC;
+    default :
+        return 0;
+    }
+}
+
+/****
+ *
+ * VIRTUALWriteWatchProtect
+ *
+ *  IN SIZE_T nStartingPage - The first page to protect.
+ *  IN SIZE_T nNumberOfPages - The number of pages to protect.
+ *
+ *  Removes write access from the pages of a write watched region that have
+ *  not been written since the last reset, so that the next write to each of
+ *  them faults once and gets recorded by VIRTUALHandleWriteWatchFault.
+ *  Does nothing for regions without MEM_WRITE_WATCH.
+ *
+ *  Returns TRUE on success, FALSE otherwise.
+ *  NOTE: The caller must own the critical section.
+ */
+static BOOL VIRTUALWriteWatchProtect( SIZE_T nStartingPage,
+                           SIZE_T nNumberOfPages, CONST PCMI pInformation )
+{
+    SIZE_T index;
+    SIZE_T runStart = nStartingPage;
+    SIZE_T endPage = nStartingPage + nNumberOfPages;
+    INT runProtect = 0;
+    INT nProtect;
+
+    if ( !pInformation->pWriteWatchState )
+    {
+        return TRUE;
+    }
+
+    // Find runs of pages needing the same protection, and mprotect each
+    // run at once (index == endPage flushes the last run)
+    for ( index = nStartingPage; index <= endPage; index++ )
+    {
+        nProtect = index < endPage ?
+            VIRTUALGetWriteWatchProtection( index, pInformation ) : 0;
+
+        if ( nProtect != runProtect )
+        {
+            if ( runProtect != 0 &&
+                 mprotect( (void *)( pInformation->startBoundary + runStart * VIRTUAL_PAGE_SIZE ),
+                           ( index - runStart ) * VIRTUAL_PAGE_SIZE, runProtect ) != 0 )
+            {
+                ERROR( "mprotect() failed! Error(%d)=%s\n",
+                       errno, strerror(errno) );
+                return FALSE;
+            }
+            runStart = index;
+            runProtect = nProtect;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/****
+ *
+ * VIRTUALPublishWriteWatchRegion
+ *
+ *  IN PCMI pInformation - The write watched region.
+ *
+ *  Makes the region visible to VIRTUALHandleWriteWatchFault.
+ *
+ *  Returns TRUE on success, FALSE if all slots are used.
+ *  NOTE: The caller must own the critical section.
+ */
+static BOOL VIRTUALPublishWriteWatchRegion( CONST PCMI pInformation )
+{
+    int index;
+
+    for ( index = 0; index < MAX_WRITE_WATCH_REGIONS; index++ )
+    {
+        WRITE_WATCH_REGION * pRegion = &writeWatchRegions[ index ];
+        if ( pRegion->pInformation == NULL )
+        {
+            pRegion->startBoundary = pInformation->startBoundary;
+            pRegion->memSize = pInformation->memSize;
+            MemoryBarrier();
+            pRegion->pInformation = pInformation;
+            return TRUE;
+        }
+    }
+
+    ERROR( "Too many MEM_WRITE_WATCH regions.\n" );
+    return FALSE;
+}
+
+/****
+ *
+ * VIRTUALUnpublishWriteWatchRegion
+ *
+ *  IN PCMI pInformation - The write watched region.
+ *
+ *  Removes the region from the ones VIRTUALHandleWriteWatchFault looks at.
+ *  NOTE: The caller must own the critical section.
+ */
+static void VIRTUALUnpublishWriteWatchRegion( CONST PCMI pInformation )
+{
+    int index;
+
+    for ( index = 0; index < MAX_WRITE_WATCH_REGIONS; index++ )
+    {
+        WRITE_WATCH_REGION * pRegion = &writeWatchRegions[ index ];
+        if ( pRegion->pInformation == pInformation )
+        {
+            pRegion->pInformation = NULL;
+            MemoryBarrier();
+            return;
+        }
+    }
+}
 
 /****
  *
@@ -556,6 +805,118 @@ BOOL VIRTUALOwnedRegion( IN UINT_PTR address )
     return pEntry != NULL;
 }
 
+/*++
+Function :
+    VIRTUALHandleWriteWatchFault
+
+    Called when an access violation occurs. If a write faulted in a write
+    watched page, records the write and restores write access to the page.
+
+    Runs in the SIGSEGV handler, so it doesn't take virtual_critsec: the
+    region is found in writeWatchRegions, and the page state is read without
+    locking. Like on Windows, the region must not be released, and the page
+    protection not changed, while it is being written to.
+
+    Returns TRUE if the faulting instruction can be restarted.
+--*/
+BOOL VIRTUALHandleWriteWatchFault( IN UINT_PTR address, IN BOOL isWrite )
+{
+    PCMI pEntry = NULL;
+    SIZE_T Index = 0;
+    BYTE Protection = 0;
+    int index;
+
+    if ( !isWrite )
+    {
+        return FALSE;
+    }
+
+    for ( index = 0; index < MAX_WRITE_WATCH_REGIONS; index++ )
+    {
+        WRITE_WATCH_REGION * pRegion = &writeWatchRegions[ index ];
+        PCMI pInformation = pRegion->pInformation;
+        if ( pInformation == NULL )
+        {
+            continue;
+        }
+
+        MemoryBarrier();
+        if ( address >= pRegion->startBoundary &&
+             address - pRegion->startBoundary < pRegion->memSize &&
+             pRegion->pInformation == pInformation )
+        {
+            pEntry = pInformation;
+            break;
+        }
+    }
+
+    if ( !pEntry )
+    {
+        return FALSE;
+    }
+
+    // Another thread might have handled a fault on the same page in the
+    // meantime, in which case the write can simply be restarted
+    Index = ( address - pEntry->startBoundary ) / VIRTUAL_PAGE_SIZE;
+    Protection = pEntry->pProtectionState[ Index ];
+    if ( !VIRTUALIsPageCommitted( Index, pEntry ) ||
+         ( Protection != VIRTUAL_READWRITE &&
+           Protection != VIRTUAL_EXECUTE_READWRITE ) )
+    {
+        return FALSE;
+    }
+
+    __sync_fetch_and_or( &pEntry->pWriteWatchState[ Index / CHAR_BIT ],
+                         (BYTE)( 1 << ( Index % CHAR_BIT ) ) );
+
+    return mprotect( (void *)( pEntry->startBoundary + Index * VIRTUAL_PAGE_SIZE ),
+                     VIRTUAL_PAGE_SIZE,
+                     Protection == VIRTUAL_READWRITE ?
+                         PROT_READ | PROT_WRITE :
+                         PROT_READ | PROT_WRITE | PROT_EXEC ) == 0;
+}
+
+/*++
+Function :
+    VIRTUALFindWriteWatchRegion
+
+    Finds the write watched region containing the given range, and computes
+    the index and number of the pages in the range.
+
+    Returns the PCMI if found, NULL otherwise.
+    NOTE: The caller must own the critical section.
+--*/
+static PCMI VIRTUALFindWriteWatchRegion( IN LPVOID lpBaseAddress,
+                                         IN SIZE_T dwRegionSize,
+                                         OUT SIZE_T *pStartingPage,
+                                         OUT SIZE_T *pNumberOfPages )
+{
+    PCMI pEntry = NULL;
+    UINT_PTR StartBoundary;
+    UINT_PTR EndBoundary;
+
+    StartBoundary = (UINT_PTR)lpBaseAddress & ~VIRTUAL_PAGE_MASK;
+    EndBoundary = ( (UINT_PTR)lpBaseAddress + dwRegionSize + VIRTUAL_PAGE_MASK ) &
+                  ~VIRTUAL_PAGE_MASK;
+
+    pEntry = VIRTUALFindRegionInformation( StartBoundary );
+    if ( !pEntry || !pEntry->pWriteWatchState )
+    {
+        ERROR( "lpBaseAddress is not in a MEM_WRITE_WATCH region.\n" );
+        return NULL;
+    }
+
+    if ( dwRegionSize == 0 || EndBoundary > pEntry->startBoundary + pEntry->memSize )
+    {
+        ERROR( "The range doesn't fit in the MEM_WRITE_WATCH region.\n" );
+        return NULL;
+    }
+
+    *pStartingPage = ( StartBoundary - pEntry->startBoundary ) / VIRTUAL_PAGE_SIZE;
+    *pNumberOfPages = ( EndBoundary - StartBoundary ) / VIRTUAL_PAGE_SIZE;
+    return pEntry;
+}
+
 /*++
 Function :
 
@@ -616,6 +977,13 @@ static BOOL VIRTUALReleaseMemory( CPalThread *pthrCurrent, PCMI pMemoryToBeRelea
     pMemoryToBeReleased->pDirtyPages = NULL;
 #endif // MMAP_DOESNOT_ALLOW_REMAP
 
+    if ( pMemoryToBeReleased->pWriteWatchState )
+    {
+        VIRTUALUnpublishWriteWatchRegion( pMemoryToBeReleased );
+        InternalFree( pthrCurrent, pMemoryToBeReleased->pWriteWatchState );
+        pMemoryToBeReleased->pWriteWatchState = NULL;
+    }
+
     InternalFree( pthrCurrent, pMemoryToBeReleased );
     pMemoryToBeReleased = NULL;
 
@@ -768,6 +1136,7 @@ static BOOL VIRTUALStoreAllocationInfo(
     PCMI pNewEntry       = NULL;
     PCMI pMemInfo        = NULL;
     BOOL bRetVal         = TRUE;
+    BOOL bInitialized    = FALSE;
     SIZE_T nBufferSize   = 0;
 
     if ( ( memSize & VIRTUAL_PAGE_MASK ) != 0 )
@@ -800,23 +1169,37 @@ static BOOL VIRTUALStoreAllocationInfo(
 #if MMAP_DOESNOT_ALLOW_REMAP
     pNewEntry->pDirtyPages  = (BYTE*)InternalMalloc( pthrCurrent, nBufferSize );
 #endif // 
+    pNewEntry->pWriteWatchState = NULL;
+    if ( flAllocationType & MEM_WRITE_WATCH )
+    {
+        pNewEntry->pWriteWatchState = (BYTE*)InternalMalloc( pthrCurrent, nBufferSize );
+    }
 
     if ( pNewEntry->pAllocState && pNewEntry->pProtectionState 
 #if MMAP_DOESNOT_ALLOW_REMAP
         && pNewEntry->pDirtyPages
 #endif // MMAP_DOESNOT_ALLOW_REMAP
+        && ( pNewEntry->pWriteWatchState || !( flAllocationType & MEM_WRITE_WATCH ) )
       )
     {
         /* Set the intial allocation state, and initial allocation protection. */
 #if MMAP_DOESNOT_ALLOW_REMAP
         memset (pNewEntry->pDirtyPages, 0, nBufferSize);
 #endif // MMAP_DOESNOT_ALLOW_REMAP
+        if ( pNewEntry->pWriteWatchState )
+        {
+            memset( pNewEntry->pWriteWatchState, 0, nBufferSize );
+        }
         VIRTUALSetAllocState( MEM_RESERVE, 0, nBufferSize * CHAR_BIT, pNewEntry );
         memset( pNewEntry->pProtectionState,
             VIRTUALConvertWinFlags( flProtection ),
             memSize / VIRTUAL_PAGE_SIZE );
+
+        bInitialized = !pNewEntry->pWriteWatchState ||
+                       VIRTUALPublishWriteWatchRegion( pNewEntry );
     }
-    else
+
+    if ( !bInitialized )
     {
         ERROR( "Unable to allocate memory for the structure.\n");
         bRetVal =  FALSE;
@@ -826,6 +1209,9 @@ static BOOL VIRTUALStoreAllocationInfo(
         pNewEntry->pDirtyPages = NULL;
 #endif // 
 
+        if (pNewEntry->pWriteWatchState) InternalFree( pthrCurrent, pNewEntry->pWriteWatchState );
+        pNewEntry->pWriteWatchState = NULL;
+
         if (pNewEntry->pProtectionState) InternalFree( pthrCurrent, pNewEntry->pProtectionState );
         pNewEntry->pProtectionState = NULL;
         
@@ -1206,6 +1592,13 @@ static LPVOID VIRTUALCommitMemory(
         allocationType = curAllocationType;
         protectionState = curProtectionState;
     }
+
+    // Write watched pages stay read-only until their first write
+    if ( !VIRTUALWriteWatchProtect( initialRunStart, totalPages, pInformation ) )
+    {
+        goto error;
+    }
+
     pRetVal = (void *) (pInformation->startBoundary +
                         initialRunStart * VIRTUAL_PAGE_SIZE);
     goto done;
@@ -1554,8 +1947,13 @@ Function:
   VirtualAlloc
 
 Note:
-  MEM_TOP_DOWN, MEM_PHYSICAL, MEM_WRITE_WATCH are not supported.
+  MEM_TOP_DOWN, MEM_PHYSICAL are not supported.
   Unsupported flags are ignored.
+
+  MEM_WRITE_WATCH is implemented by keeping unwritten pages read-only and
+  recording the first write to each page in the SIGSEGV handler. Because of
+  that, system calls writing to unwritten pages of a write watched region
+  (i.e. read() in a buffer) fail with EFAULT instead of faulting.
   
   Page size on i386 is set to 4k.
 
@@ -1578,17 +1976,17 @@ VirtualAlloc(
 
     pthrCurrent = InternalGetCurrentThread();
 
-    if ( ( flAllocationType & MEM_WRITE_WATCH )  != 0 )
+    /* Test for un-supported flags. */
+    if ( ( flAllocationType & ~( MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH ) ) != 0 )
     {
+        ASSERT( "flAllocationType can be one, or any combination of MEM_COMMIT, \
+               MEM_RESERVE, MEM_TOP_DOWN or MEM_WRITE_WATCH.\n" );
         pthrCurrent->SetLastError( ERROR_INVALID_PARAMETER );
         goto done;
     }
-
-    /* Test for un-supported flags. */
-    if ( ( flAllocationType & ~( MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN ) ) != 0 )
+    if ( ( flAllocationType & MEM_WRITE_WATCH ) && !( flAllocationType & MEM_RESERVE ) )
     {
-        ASSERT( "flAllocationType can be one, or any combination of MEM_COMMIT, \
-               MEM_RESERVE, or MEM_TOP_DOWN.\n" );
+        ERROR( "MEM_WRITE_WATCH can only be specified when reserving memory.\n" );
         pthrCurrent->SetLastError( ERROR_INVALID_PARAMETER );
         goto done;
     }
@@ -1949,6 +2347,9 @@ VirtualProtect(
             memset( pEntry->pProtectionState + OffSet, 
                     VIRTUALConvertWinFlags( flNewProtect ),
                     NumberOfPagesToChange );
+
+            // Unwritten pages of a write watched region need to stay read-only
+            VIRTUALWriteWatchProtect( OffSet, NumberOfPagesToChange, pEntry );
         }
         else
         {
@@ -2256,6 +2657,12 @@ ExitVirtualQuery:
 Function:
   GetWriteWatch
 
+Note:
+  Pages are reported once they are written to (see VirtualAlloc),
+  with the page size as granularity. With WRITE_WATCH_FLAG_RESET, writes
+  racing with the call might not be reported (callers usually suspend
+  writing threads first).
+
 See MSDN doc.
 --*/
 UINT 
@@ -2269,11 +2676,72 @@ GetWriteWatch(
   OUT PULONG lpdwGranularity
 )
 {
-    // TODO: implement this method
-    *lpAddresses = NULL;
-    *lpdwCount = 0;
-    // Until it is implemented, return non-zero value as an indicator of failure
-    return 1;
+    UINT uRetVal = 1;
+    PCMI pEntry = NULL;
+    SIZE_T StartingPage = 0;
+    SIZE_T NumberOfPages = 0;
+    SIZE_T Index = 0;
+    ULONG_PTR Count = 0;
+    CPalThread * pthrCurrent;
+
+    ENTRY("GetWriteWatch(dwFlags=%#x, lpBaseAddress=%p, dwRegionSize=%u, "
+          "lpAddresses=%p, lpdwCount=%p, lpdwGranularity=%p)\n",
+          dwFlags, lpBaseAddress, dwRegionSize, lpAddresses, lpdwCount,
+          lpdwGranularity);
+
+    pthrCurrent = InternalGetCurrentThread();
+    InternalEnterCriticalSection(pthrCurrent, &virtual_critsec);
+
+    if ( ( dwFlags & ~WRITE_WATCH_FLAG_RESET ) != 0 || !lpAddresses || !lpdwCount )
+    {
+        ERROR( "Invalid parameter.\n" );
+        pthrCurrent->SetLastError( ERROR_INVALID_PARAMETER );
+        goto ExitGetWriteWatch;
+    }
+
+    pEntry = VIRTUALFindWriteWatchRegion( lpBaseAddress, dwRegionSize,
+                                          &StartingPage, &NumberOfPages );
+    if ( !pEntry )
+    {
+        pthrCurrent->SetLastError( ERROR_INVALID_PARAMETER );
+        goto ExitGetWriteWatch;
+    }
+
+    for ( Index = StartingPage;
+          Index < StartingPage + NumberOfPages && Count < *lpdwCount; Index++ )
+    {
+        if ( VIRTUALIsPageWritten( Index, pEntry ) )
+        {
+            lpAddresses[ Count++ ] =
+                (PVOID)( pEntry->startBoundary + Index * VIRTUAL_PAGE_SIZE );
+
+            if ( dwFlags & WRITE_WATCH_FLAG_RESET )
+            {
+                VIRTUALSetWriteWatchState( 0, Index, 1, pEntry );
+            }
+        }
+    }
+
+    // Only the pages that were reported are reset (the buffer might be full)
+    if ( ( dwFlags & WRITE_WATCH_FLAG_RESET ) &&
+         !VIRTUALWriteWatchProtect( StartingPage, Index - StartingPage, pEntry ) )
+    {
+        pthrCurrent->SetLastError( ERROR_INTERNAL_ERROR );
+        goto ExitGetWriteWatch;
+    }
+
+    *lpdwCount = Count;
+    if ( lpdwGranularity )
+    {
+        *lpdwGranularity = VIRTUAL_PAGE_SIZE;
+    }
+    uRetVal = 0;
+
+ExitGetWriteWatch:
+    InternalLeaveCriticalSection(pthrCurrent, &virtual_critsec);
+
+    LOGEXIT( "GetWriteWatch returning %u.\n", uRetVal );
+    return uRetVal;
 }
 
 /*++
@@ -2289,7 +2757,37 @@ ResetWriteWatch(
   IN SIZE_T dwRegionSize
 )
 {
-    // TODO: implement this method
-    // Until it is implemented, return non-zero value as an indicator of failure
-    return 1;
+    UINT uRetVal = 1;
+    PCMI pEntry = NULL;
+    SIZE_T StartingPage = 0;
+    SIZE_T NumberOfPages = 0;
+    CPalThread * pthrCurrent;
+
+    ENTRY("ResetWriteWatch(lpBaseAddress=%p, dwRegionSize=%u)\n",
+          lpBaseAddress, dwRegionSize);
+
+    pthrCurrent = InternalGetCurrentThread();
+    InternalEnterCriticalSection(pthrCurrent, &virtual_critsec);
+
+    pEntry = VIRTUALFindWriteWatchRegion( lpBaseAddress, dwRegionSize,
+                                          &StartingPage, &NumberOfPages );
+    if ( !pEntry )
+    {
+        pthrCurrent->SetLastError( ERROR_INVALID_PARAMETER );
+        goto ExitResetWriteWatch;
+    }
+
+    VIRTUALSetWriteWatchState( 0, StartingPage, NumberOfPages, pEntry );
+    if ( !VIRTUALWriteWatchProtect( StartingPage, NumberOfPages, pEntry ) )
+    {
+        pthrCurrent->SetLastError( ERROR_INTERNAL_ERROR );
+        goto ExitResetWriteWatch;
+    }
+    uRetVal = 0;
+
+ExitResetWriteWatch:
+    InternalLeaveCriticalSection(pthrCurrent, &virtual_critsec);
+
+    LOGEXIT( "ResetWriteWatch returning %u.\n", uRetVal );
+    return uRetVal;
 }
@@ -946,7 +946,9 @@ CSharedMemoryObjectManager::ReferenceMultipleObjectsByHandleArray(
         rgpobjs
         );
 
-    m_HandleManager.Lock(pthr);
+    //
+    // Handle lookups don't take the handle manager lock
+    //
 
     for (dw = 0; dw < dwHandleCount; dw += 1)
     {        
@@ -983,15 +985,6 @@ CSharedMemoryObjectManager::ReferenceMultipleObjectsByHandleArray(
         }
     }
 
-    //
-    // The handle manager lock must be released before releasing
-    // any object references, as ReleaseReference will acquire
-    // the object manager list lock (which needs to be acquired before
-    // the handle manager lock)
-    //
-
-    m_HandleManager.Unlock(pthr);
-
     if (NO_ERROR != palError)
     {
         //
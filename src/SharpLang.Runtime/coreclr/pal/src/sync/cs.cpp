@@ -32,6 +32,12 @@
 
 #include <sched.h>
 #include <pthread.h>
+#include <errno.h>
+#include <unistd.h>
+#if HAVE_LINUX_FUTEX_H
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif // HAVE_LINUX_FUTEX_H
 
 using namespace CorUnix;
 
@@ -48,6 +54,17 @@ using namespace CorUnix;
 //
 // #define MUTEX_BASED_CSS
 
+//
+// On Linux, contended CSs sleep directly on a futex (the predicate of the 
+// native data) rather than on a pthread mutex/condition pair: waiting and 
+// waking up cost a single syscall each, and no native initialization is 
+// needed at first contention. Before sleeping, waiters spin for a while, 
+// adapting the spin length to how long the CS has recently been held.
+//
+#if HAVE_LINUX_FUTEX_H && !defined(MUTEX_BASED_CSS)
+#define PALCS_USE_FUTEX
+#endif
+
 //
 // Important notes on critical sections layout/semantics on Unix
 //
@@ -126,6 +143,11 @@ SET_DEFAULT_DEBUG_CHANNEL(CRITSEC);
 #define PALCS_GETAWBIT(val)     ((int)(0!=(PALCS_LOCK_AWAKENED_WAITER&val)))
 #define PALCS_GETWCOUNT(val)    (val/PALCS_LOCK_WAITER_INC)
 
+#ifdef PALCS_USE_FUTEX
+// Upper bound of the adaptive spin, in YieldProcessor iterations
+#define PALCS_ADAPTIVE_SPIN_MAX        1000
+#endif // PALCS_USE_FUTEX
+
 enum PalCsInitState 
 { 
     PalCsNotInitialized,    // Critical section not initialized (InitializedCriticalSection
@@ -157,9 +179,15 @@ typedef struct _CRITICAL_SECTION_DEBUG_INFO
 
 typedef struct _PAL_CRITICAL_SECTION_NATIVE_DATA 
 {
+#ifndef PALCS_USE_FUTEX
     pthread_mutex_t mutex;
     pthread_cond_t condition;
+#endif // !PALCS_USE_FUTEX
     int iPredicate;
+#ifdef PALCS_USE_FUTEX
+    // Running average of the spin iterations it took to see the CS released
+    LONG lAdaptiveSpinCount;
+#endif // PALCS_USE_FUTEX
 } PAL_CRITICAL_SECTION_NATIVE_DATA, *PPAL_CRITICAL_SECTION_NATIVE_DATA;
 
 typedef struct _PAL_CRITICAL_SECTION {
@@ -438,6 +466,7 @@ VOID InternalDeleteCriticalSection(
     }
 #endif // _DEBUG
     
+#ifndef PALCS_USE_FUTEX
     if (PalCsFullyInitialized == pPalCriticalSection->cisInitState)
     {
         int iRet;
@@ -452,6 +481,7 @@ VOID InternalDeleteCriticalSection(
         _ASSERT_MSG(0 == iRet, "Failed destroying mutex in CS @ %p "
                     "[err=%d]\n", pPalCriticalSection, iRet);
     }
+#endif // !PALCS_USE_FUTEX
 
     // Reset critical section state
     pPalCriticalSection->cisInitState = PalCsNotInitialized;        
@@ -498,6 +528,9 @@ namespace CorUnix
     static PAL_ERROR PALCS_DoActualWait(PAL_CRITICAL_SECTION * pPalCriticalSection);
     static PAL_ERROR PALCS_WakeUpWaiter(PAL_CRITICAL_SECTION * pPalCriticalSection);
     static bool PALCS_FullyInitialize(PAL_CRITICAL_SECTION * pPalCriticalSection);
+#ifdef PALCS_USE_FUTEX
+    static bool PALCS_SpinUntilReleased(PAL_CRITICAL_SECTION * pPalCriticalSection);
+#endif // PALCS_USE_FUTEX
 
 #ifdef _DEBUG
     enum CSSubSysInitState
@@ -601,6 +634,10 @@ namespace CorUnix
         pPalCriticalSection->OwningThread      = NULL;
         pPalCriticalSection->LockSemaphore     = NULL;
         pPalCriticalSection->fInternal         = fInternal;
+#ifdef PALCS_USE_FUTEX
+        pPalCriticalSection->csndNativeData.iPredicate         = 0;
+        pPalCriticalSection->csndNativeData.lAdaptiveSpinCount = 0;
+#endif // PALCS_USE_FUTEX
 
 #ifdef _DEBUG
         CPalThread * pThread = 
@@ -796,6 +833,15 @@ namespace CorUnix
                 }
             } while (0 <= --lSpinCount);
 
+#ifdef PALCS_USE_FUTEX
+            // The owner is likely to release the CS soon: spin for a 
+            // while before registering as waiter and going to sleep
+            if (PALCS_SpinUntilReleased(pPalCriticalSection))
+            {
+                continue;
+            }
+#endif // PALCS_USE_FUTEX
+
             cwrs = PALCS_WaitOnCS(pPalCriticalSection, lWaitInc);
             
             if (PalCsReturnWaiterAwakened == cwrs) 
@@ -1146,6 +1192,10 @@ namespace CorUnix
                 goto PCDI_exit;
             }
 
+#ifdef PALCS_USE_FUTEX
+            // Waiters sleep on the predicate itself, nothing to initialize
+            (void)iRet;
+#else // PALCS_USE_FUTEX
             //
             // Actual native initialization
             //
@@ -1174,6 +1224,7 @@ namespace CorUnix
             // Predicate
             pPalCriticalSection->csndNativeData.iPredicate = 0;
 #endif
+#endif // PALCS_USE_FUTEX
 
             pPalCriticalSection->cisInitState = PalCsFullyInitialized;
         }
@@ -1282,6 +1333,120 @@ namespace CorUnix
         return PalCsReturnWaiterAwakened;
     }
 
+#ifdef PALCS_USE_FUTEX
+    /*++
+    Function:
+      CorUnix::PALCS_SpinUntilReleased
+
+    Spins (without yielding the processor) while the CS is locked. The spin
+    length adapts to the number of iterations recently needed to see the CS
+    released. It returns true if the CS was released while spinning, false
+    if the spin expired (or if there is a single processor)
+    --*/
+    bool PALCS_SpinUntilReleased(PAL_CRITICAL_SECTION * pPalCriticalSection)
+    {
+        static LONG s_lProcessorCount = 0;
+        LONG lAverage, lMaxSpin, lSpin;
+
+        if (0 == s_lProcessorCount)
+        {
+            LONG lCount = (LONG)sysconf(_SC_NPROCESSORS_ONLN);
+            s_lProcessorCount = (0 < lCount) ? lCount : 1;
+        }
+        if (1 == s_lProcessorCount)
+        {
+            // The owner can't release the CS while we spin
+            return false;
+        }
+
+        lAverage = pPalCriticalSection->csndNativeData.lAdaptiveSpinCount;
+        lMaxSpin = 2 * lAverage + 10;
+        if (PALCS_ADAPTIVE_SPIN_MAX < lMaxSpin)
+        {
+            lMaxSpin = PALCS_ADAPTIVE_SPIN_MAX;
+        }
+
+        for (lSpin = 0; lSpin < lMaxSpin; lSpin++)
+        {
+            if (0 == (pPalCriticalSection->LockCount & PALCS_LOCK_BIT))
+            {
+                break;
+            }
+            YieldProcessor();
+        }
+
+        // Racy update is fine, this is only a hint
+        pPalCriticalSection->csndNativeData.lAdaptiveSpinCount =
+            lAverage + (lSpin - lAverage) / 8;
+
+        return lSpin < lMaxSpin;
+    }
+
+    /*++
+    Function:
+      CorUnix::PALCS_DoActualWait
+
+    Performs the actual native wait on the CS: sleeps on the predicate
+    futex until a waker sets it, then resets it
+    --*/
+    PAL_ERROR PALCS_DoActualWait(PAL_CRITICAL_SECTION * pPalCriticalSection)
+    {
+        LONG volatile * plPredicate =
+            (LONG volatile *)&pPalCriticalSection->csndNativeData.iPredicate;
+        PAL_ERROR palErr = NO_ERROR;
+
+        CS_TRACE("Going to sleep [CS=%p]\n", pPalCriticalSection);
+
+        while (1 != InterlockedCompareExchange(plPredicate, 0, 1))
+        {
+            // EAGAIN means the predicate was set in the meanwhile
+            if (0 != syscall(SYS_futex, plPredicate, FUTEX_WAIT_PRIVATE,
+                             0, NULL, NULL, 0) &&
+                EAGAIN != errno && EINTR != errno)
+            {
+                ASSERT("Failed waiting on futex in CS %p [errno=%d]\n",
+                       pPalCriticalSection, errno);
+                palErr = ERROR_INTERNAL_ERROR;
+                break;
+            }
+        }
+
+        CS_TRACE("Just woken up [CS=%p]\n", pPalCriticalSection);
+
+        return palErr;
+    }
+
+    /*++
+    Function:
+      CorUnix::PALCS_WakeUpWaiter
+
+    Wakes up the first thread waiting on the CS
+    --*/
+    PAL_ERROR PALCS_WakeUpWaiter(PAL_CRITICAL_SECTION * pPalCriticalSection)
+    {
+        LONG volatile * plPredicate =
+            (LONG volatile *)&pPalCriticalSection->csndNativeData.iPredicate;
+        PAL_ERROR palErr = NO_ERROR;
+
+        _ASSERT_MSG(PalCsFullyInitialized == pPalCriticalSection->cisInitState,
+                    "Trying to wake up a waiter on CS not fully initialized\n");
+
+        InterlockedExchange(plPredicate, 1);
+
+        CS_TRACE("Signaling futex [pred=%d]!\n",
+                 pPalCriticalSection->csndNativeData.iPredicate);
+
+        if (0 > syscall(SYS_futex, plPredicate, FUTEX_WAKE_PRIVATE,
+                        1, NULL, NULL, 0))
+        {
+            ASSERT("Failed waking up futex in CS %p [errno=%d]\n",
+                   pPalCriticalSection, errno);
+            palErr = ERROR_INTERNAL_ERROR;
+        }
+
+        return palErr;
+    }
+#else // PALCS_USE_FUTEX
     /*++
     Function:
       CorUnix::PALCS_DoActualWait
@@ -1393,6 +1558,8 @@ namespace CorUnix
         return palErr;
     }
     
+#endif // PALCS_USE_FUTEX
+    
 #ifdef _DEBUG
     /*++
     Function:
@@ -1528,7 +1695,9 @@ namespace CorUnix
 #endif // _DEBUG
 
 
-#if defined(MUTEX_BASED_CSS) || defined(_DEBUG)
+// Note: in debug builds the mutex based functions are compiled (under MTX_
+// names) even when unused, unless CSs don't have a native mutex (futex)
+#if defined(MUTEX_BASED_CSS) || (defined(_DEBUG) && !defined(PALCS_USE_FUTEX))
     /*++
     Function:
       CorUnix::InternalEnterCriticalSection
@@ -1722,6 +1891,6 @@ namespace CorUnix
     ITECS_exit:
         return fRet;
     }
-#endif // MUTEX_BASED_CSS || _DEBUG
+#endif // MUTEX_BASED_CSS || (_DEBUG && !PALCS_USE_FUTEX)
 }
 
@@ -35,6 +35,13 @@ Abstract:
 #else
 #include "pal/fakepoll.h"
 #endif // HAVE_POLL
+#if SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif // SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING
+#if SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+#include <sys/eventfd.h>
+#endif // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
 
 namespace CorUnix
 {
@@ -436,7 +443,113 @@ namespace CorUnix
         return palErr;        
     }
 
-#if !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING
+#if SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING
+
+    PAL_ERROR CPalSynchronizationManager::ThreadNativeWait(
+        ThreadNativeWaitData * ptnwdNativeWaitData,
+        DWORD dwTimeout,
+        ThreadWakeupReason * ptwrWakeupReason,
+        DWORD * pdwSignaledObject)
+    {
+        PAL_ERROR palErr = NO_ERROR;
+        LONG volatile * plPred = (LONG volatile *)&ptnwdNativeWaitData->iPred;
+        struct timespec tsEnd, tsNow, tsRelTmo;
+        struct timespec * ptsRelTmo = NULL;
+        bool fTimedOut = false;
+        int iRet;
+
+        TRACE("ThreadNativeWait(ptnwdNativeWaitData=%p, dwTimeout=%u, ...)\n",
+              ptnwdNativeWaitData, dwTimeout);
+
+        if (dwTimeout != INFINITE)
+        {
+            // futex takes a relative timeout: keep track of the end of the
+            // wait on the monotonic clock, to recompute it after spurious
+            // wakeups
+            iRet = clock_gettime(CLOCK_MONOTONIC, &tsEnd);
+            if (0 != iRet)
+            {
+                ERROR("clock_gettime failed [errno=%d (%s)]\n",
+                      errno, strerror(errno));
+                palErr = ERROR_INTERNAL_ERROR;
+                *ptwrWakeupReason = WaitFailed;
+                goto TNW_exit;
+            }
+
+            tsEnd.tv_sec  += dwTimeout / tccSecondsToMillieSeconds;
+            tsEnd.tv_nsec += (dwTimeout % tccSecondsToMillieSeconds) * 
+                tccMillieSecondsToNanoSeconds;
+            if (tsEnd.tv_nsec >= tccSecondsToNanoSeconds)
+            {
+                tsEnd.tv_sec  += 1;
+                tsEnd.tv_nsec -= tccSecondsToNanoSeconds;
+            }
+            ptsRelTmo = &tsRelTmo;
+        }
+
+        // Consume the predicate, sleeping on the futex as long as it is not
+        // set. Note: if the timeout expires while a signaling thread is 
+        // setting the predicate, the predicate will still be consumed here 
+        // whenever it gets set before the final check, and the wait will 
+        // be reported as succeeded (the waker has already changed the wait
+        // state of this thread at that point). Otherwise it is left for 
+        // the 'second native wait' (see comments in BlockThread).
+        while (TRUE != InterlockedCompareExchange(plPred, FALSE, TRUE))
+        {
+            if (NULL != ptsRelTmo)
+            {
+                clock_gettime(CLOCK_MONOTONIC, &tsNow);
+
+                tsRelTmo.tv_sec  = tsEnd.tv_sec - tsNow.tv_sec;
+                tsRelTmo.tv_nsec = tsEnd.tv_nsec - tsNow.tv_nsec;
+                if (0 > tsRelTmo.tv_nsec)
+                {
+                    tsRelTmo.tv_sec  -= 1;
+                    tsRelTmo.tv_nsec += tccSecondsToNanoSeconds;
+                }
+                if (0 > tsRelTmo.tv_sec)
+                {
+                    fTimedOut = true;
+                    break;
+                }
+            }
+
+            // EAGAIN means that the predicate has been set in the meanwhile;
+            // on ETIMEDOUT the loop checks the predicate one last time
+            iRet = syscall(SYS_futex, plPred, FUTEX_WAIT_PRIVATE, FALSE, 
+                           ptsRelTmo, NULL, 0);
+            if (0 != iRet && EAGAIN != errno && EINTR != errno && 
+                ETIMEDOUT != errno)
+            {
+                ERROR("futex wait returned %d [errno=%d (%s)]\n", 
+                      iRet, errno, strerror(errno));
+                palErr = ERROR_INTERNAL_ERROR;
+                *ptwrWakeupReason = WaitFailed;
+                goto TNW_exit;
+            }
+        }
+
+        if (fTimedOut)
+        {
+            _ASSERT_MSG(INFINITE != dwTimeout,
+                        "Got a timeout despite timeout was INFINITE\n");
+            *ptwrWakeupReason = WaitTimeout;
+        }
+        else
+        {
+            *ptwrWakeupReason  = ptnwdNativeWaitData->twrWakeupReason;
+            *pdwSignaledObject = ptnwdNativeWaitData->dwObjectIndex;
+        }
+
+    TNW_exit:
+
+        TRACE("ThreadNativeWait: returning %u [WakeupReason=%u]\n", 
+              palErr, *ptwrWakeupReason);
+        
+        return palErr;
+    }
+
+#elif !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING
 
     PAL_ERROR CPalSynchronizationManager::ThreadNativeWait(
         ThreadNativeWaitData * ptnwdNativeWaitData,
@@ -2126,6 +2239,21 @@ namespace CorUnix
         ThreadNativeWaitData * ptnwdWorkerThreadNativeData = 
             &pthrWorker->synchronizationInfo.m_tnwdNativeData;
 
+#if SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+        // ShutdownProcessPipe only forgot the write end of the eventfd: 
+        // now that the worker thread is done reading it, it can be closed
+        if (-1 != pSynchManager->m_iProcessPipeRead)
+        {
+            TRACE("Closing the process eventfd\n");
+            if (close(pSynchManager->m_iProcessPipeRead) == -1)
+            {
+                ERROR("Unable to close the process eventfd [errno=%d (%s)]\n",
+                      errno, strerror(errno));
+            }
+            pSynchManager->m_iProcessPipeRead = -1;
+        }
+#endif // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+
 #if !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING
         // Using the worker thread's predicate/condition/mutex
         // (that normally are never used) to signal the shutting 
@@ -2188,14 +2316,24 @@ namespace CorUnix
         DWORD * pdwData)
     {
         PAL_ERROR palErr = NO_ERROR;
+#if !SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
         int iRet;
         BYTE byVal;
+#endif // !SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
         SynchWorkerCmd swcWorkerCmd = SynchWorkerCmdNop;
 
         _ASSERTE(NULL != pswcWorkerCmd);
         _ASSERTE(NULL != pshridMarshaledData);
         _ASSERTE(NULL != pdwData);
 
+#if SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+        // Only local cmds, which carry no data, can be received
+        palErr = ReadCmdFromProcessEventFd(iPollTimeout, &swcWorkerCmd);
+        if (NO_ERROR != palErr)
+        {
+            goto RCFPP_exit;
+        }
+#else // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
         iRet = ReadBytesFromProcessPipe(iPollTimeout, &byVal, sizeof(BYTE));
 
         if (0 > iRet)
@@ -2278,6 +2416,8 @@ namespace CorUnix
             *pdwData = dwData;
         }
 
+#endif // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+
     RCFPP_exit:
         if (NO_ERROR == palErr)
         {
@@ -2286,6 +2426,82 @@ namespace CorUnix
         return palErr;
     }
 
+#if SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+    /*++
+    Method:
+      CPalSynchronizationManager::ReadCmdFromProcessEventFd
+
+    Reads a worker thread cmd from the process eventfd. Cmds are added to 
+    the eventfd counter: a value of at least EventFdShutdownIncrement means
+    SynchWorkerCmdShutdown, any other value one or more SynchWorkerCmdNop.
+    If nothing has been written, it blocks until a cmd is received or the 
+    timeout expires (SynchWorkerCmdNop). Once the eventfd has been shut
+    down, it returns SynchWorkerCmdNop right away, like the EOF on the 
+    process pipe.
+    --*/
+    PAL_ERROR CPalSynchronizationManager::ReadCmdFromProcessEventFd(
+        int iPollTimeout,
+        SynchWorkerCmd * pswcWorkerCmd)
+    {
+        PAL_ERROR palErr = NO_ERROR;
+        struct pollfd Poll;
+        UINT64 ui64Val;
+        ssize_t sszRead;
+        int iRet;
+
+        *pswcWorkerCmd = SynchWorkerCmdNop;
+
+        if (-1 == m_iProcessPipeWrite)
+        {
+            TRACE("The process eventfd has been shut down\n");
+            goto RCFEF_exit;
+        }
+
+        Poll.fd = m_iProcessPipeRead;
+        Poll.events = POLLIN;
+        Poll.revents = 0;
+
+        do
+        {
+            iRet = poll(&Poll, 1, iPollTimeout);
+        } while (-1 == iRet && EINTR == errno);
+
+        if (-1 == iRet)
+        {
+            ERROR("Failed polling the process eventfd [errno=%d (%s)]\n",
+                  errno, strerror(errno));
+            palErr = ERROR_INTERNAL_ERROR;
+            goto RCFEF_exit;
+        }
+        if (0 == iRet)
+        {
+            // Timeout
+            goto RCFEF_exit;
+        }
+
+        // Reading resets the counter
+        sszRead = read(m_iProcessPipeRead, &ui64Val, sizeof(ui64Val));
+        if (sizeof(ui64Val) != sszRead)
+        {
+            if (-1 != sszRead || EAGAIN != errno)
+            {
+                ERROR("Unable to read from the process eventfd [ret=%d "
+                      "errno=%d (%s)]\n", (int)sszRead, errno, strerror(errno));
+                palErr = ERROR_INTERNAL_ERROR;
+            }
+            goto RCFEF_exit;
+        }
+
+        if (EventFdShutdownIncrement <= ui64Val)
+        {
+            *pswcWorkerCmd = SynchWorkerCmdShutdown;
+        }
+
+    RCFEF_exit:
+        return palErr;
+    }
+#endif // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+
     /*++
     Method:
       CPalSynchronizationManager::ReadBytesFromProcessPipe
@@ -2668,6 +2884,22 @@ namespace CorUnix
         PAL_ERROR palErr = NO_ERROR;
         int iRet;
         
+#if SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING
+        LONG volatile * plPred = (LONG volatile *)&ptnwdNativeWaitData->iPred;
+
+        // Set the predicate (this also publishes wakeup reason and signaled
+        // object index) and wake up the target thread if it is sleeping
+        InterlockedExchange(plPred, TRUE);
+
+        iRet = syscall(SYS_futex, plPred, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+        if (0 > iRet)
+        {
+            ERROR("Failed to wake up futex [errno=%d (%s)]\n", 
+                  errno, strerror(errno));
+            palErr = ERROR_INTERNAL_ERROR;
+            goto WUT_exit;
+        }
+#else // SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING
         // Lock the mutex
         iRet = pthread_mutex_lock(&ptnwdNativeWaitData->mutex);
         if (0 != iRet)
@@ -2699,6 +2931,7 @@ namespace CorUnix
             palErr = ERROR_INTERNAL_ERROR;
             goto WUT_exit;
         }
+#endif // SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING
 
     WUT_exit:
         return palErr;
@@ -3043,6 +3276,32 @@ namespace CorUnix
         TRACE("Waking up Synch Worker Thread for %u [byCmd=%u]\n", 
                     swcWorkerCmd, (unsigned int)byCmd);
 
+#if SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+        {
+            // Commands are encoded in the eventfd counter (see 
+            // ReadCmdFromProcessEventFd); adding to it never blocks
+            UINT64 ui64Increment = (SynchWorkerCmdShutdown == swcWorkerCmd) ?
+                EventFdShutdownIncrement : 1;
+
+            iRetryCount = 0;
+            do
+            {
+                sszWritten = write(m_iProcessPipeWrite, &ui64Increment, 
+                                   sizeof(ui64Increment));
+            } while (-1 == sszWritten && 
+                     EINTR == errno && 
+                     ++iRetryCount < MaxConsecutiveEagains);
+
+            if (sszWritten != sizeof(ui64Increment))
+            {
+                ERROR("Unable to write the the process eventfd to wakeup the "
+                       "worker thread [errno=%d (%s)]\n", errno, strerror(errno));
+                palErr = ERROR_INTERNAL_ERROR;
+                goto WUWT_exit;
+            }
+        }
+#else // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+
         // As long as we use pipes and we keep the message size 
         // within PIPE_BUF, there's no need to lock here, since the
         // write is guaranteed not to be interleaved with/into other
@@ -3065,6 +3324,7 @@ namespace CorUnix
             palErr = ERROR_INTERNAL_ERROR;
             goto WUWT_exit;
         }
+#endif // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
 
     WUWT_exit:
         return palErr;
@@ -3880,6 +4140,16 @@ namespace CorUnix
             fRet = false;
             goto CPP_exit;
         }
+#elif SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+        // The same descriptor is used for both reading and writing
+        int iEventFd = eventfd(0, EFD_NONBLOCK);
+        if (iEventFd == -1)
+        {
+            ERROR("Unable to create the process eventfd [errno=%d (%s)]\n",
+                  errno, strerror(errno));
+            fRet = false;
+            goto CPP_exit;
+        }
 #else // !CORECLR
         int rgiPipe[] = { -1, -1 };
         if (pipe(rgiPipe) == -1)
@@ -3907,6 +4177,9 @@ namespace CorUnix
 #ifndef CORECLR
             m_iProcessPipeRead = iPipeRd;
             m_iProcessPipeWrite = iPipeWr;      
+#elif SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+            m_iProcessPipeRead = iEventFd;
+            m_iProcessPipeWrite = iEventFd;
 #else // !CORECLR
             m_iProcessPipeRead = rgiPipe[0];
             m_iProcessPipeWrite = rgiPipe[1];
@@ -3931,6 +4204,11 @@ namespace CorUnix
             {
                 close(iPipeWr);
             }
+#elif SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+            if (-1 != iEventFd)
+            {
+                close(iEventFd);
+            }
 #else // !CORECLR
             if (-1 != rgiPipe[0])
             {
@@ -3988,6 +4266,13 @@ namespace CorUnix
 
         if (-1 != m_iProcessPipeWrite)
         {
+#if SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+            // The eventfd is also the read end and no other process can 
+            // write to it, so it is not closed here: forgetting the write 
+            // end makes the worker thread's next read return an EOF, and 
+            // the worker thread closes the eventfd once it is done
+            TRACE("Shutting down the process eventfd\n");
+#else // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
             // Closing the write end of the process pipe. When the last process
             // that still has a open write-fd on this pipe will close it, the
             // worker thread will receive an EOF; the worker thread will wait
@@ -4003,6 +4288,7 @@ namespace CorUnix
                 ERROR("Unable to close the write end of process pipe\n");
                 palErr = ERROR_INTERNAL_ERROR;                
             }
+#endif // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
             m_iProcessPipeWrite = -1;
         }
         
@@ -4394,34 +4680,37 @@ namespace CorUnix
 
     void CThreadSynchronizationInfo::AcquireNativeWaitLock()
     {
-#if !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_SUSPENSION_SAFE_CONDITION_SIGNALING
+#if !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING && \
+    !SYNCHMGR_SUSPENSION_SAFE_CONDITION_SIGNALING
         int iRet;
         iRet = pthread_mutex_lock(&m_tnwdNativeData.mutex);
         _ASSERT_MSG(0 == iRet, "pthread_mutex_lock failed with error=%d\n", 
                     iRet);
-#endif // !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_SUSPENSION_SAFE_CONDITION_SIGNALING
+#endif // !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING && ...
     }
 
     void CThreadSynchronizationInfo::ReleaseNativeWaitLock()
     {
-#if !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_SUSPENSION_SAFE_CONDITION_SIGNALING
+#if !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING && \
+    !SYNCHMGR_SUSPENSION_SAFE_CONDITION_SIGNALING
         int iRet;
         iRet = pthread_mutex_unlock(&m_tnwdNativeData.mutex);
         _ASSERT_MSG(0 == iRet, "pthread_mutex_unlock failed with error=%d\n", 
                     iRet);
-#endif // !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_SUSPENSION_SAFE_CONDITION_SIGNALING
+#endif // !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING && ...
     }
 
     bool CThreadSynchronizationInfo::TryAcquireNativeWaitLock()
     {       
         bool fRet = true;
-#if !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_SUSPENSION_SAFE_CONDITION_SIGNALING
+#if !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING && \
+    !SYNCHMGR_SUSPENSION_SAFE_CONDITION_SIGNALING
         int iRet;
         iRet = pthread_mutex_trylock(&m_tnwdNativeData.mutex);
         _ASSERT_MSG(0 == iRet || EBUSY == iRet,
                     "pthread_mutex_trylock failed with error=%d\n", iRet);
         fRet = (0 == iRet);
-#endif // !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_SUSPENSION_SAFE_CONDITION_SIGNALING
+#endif // !SYNCHMGR_PIPE_BASED_THREAD_BLOCKING && !SYNCHMGR_FUTEX_BASED_THREAD_BLOCKING && ...
         return fRet;
     }        
 
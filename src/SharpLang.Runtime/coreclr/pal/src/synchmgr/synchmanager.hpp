@@ -39,6 +39,15 @@ Abstract:
 
 SET_DEFAULT_DEBUG_CHANNEL(SYNC);
 
+// Without shared objects (CORECLR) only the local process writes to the 
+// process pipe, and only cmds without data: on Linux the worker thread is 
+// then woken up through an eventfd instead
+#if defined(CORECLR) && HAVE_SYS_EVENTFD_H
+#define SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP 1
+#else
+#define SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP 0
+#endif
+
 #ifdef _DEBUG
 // #define SYNCH_OBJECT_VALIDATION
 // #define SYNCH_STATISTICS
@@ -550,6 +559,9 @@ namespace CorUnix
         static const int WorkerCmdCompletionTimeout        = 250;  // ms
         static const DWORD SecondNativeWaitTimeout         = INFINITE;
         static const DWORD WorkerThreadTerminationTimeout  = 2000; // ms
+#if SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+        static const UINT64 EventFdShutdownIncrement       = 1ull << 32;
+#endif // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
 
         // static members
         static CPalSynchronizationManager * s_pObjSynchMgr;        
@@ -958,6 +970,12 @@ namespace CorUnix
             SharedID * pshridMarshaledData,
             DWORD * pdwData);
 
+#if SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+        PAL_ERROR ReadCmdFromProcessEventFd(
+            int iPollTimeout,
+            SynchWorkerCmd * pswcWorkerCmd);
+#endif // SYNCHMGR_EVENTFD_BASED_WORKER_WAKEUP
+
         PAL_ERROR WakeUpLocalWorkerThread(
             CPalThread * pthrCurrent,
             SynchWorkerCmd swcWorkerCmd);
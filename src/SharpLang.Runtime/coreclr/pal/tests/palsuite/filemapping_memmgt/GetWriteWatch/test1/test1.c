@@ -0,0 +1,164 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//
+
+/*=============================================================
+**
+** Source:  test1.c
+**
+** Purpose: Positive test the GetWriteWatch API.
+**          Write to pages of a MEM_WRITE_WATCH region, and check
+**          that exactly those pages are reported, including with
+**          WRITE_WATCH_FLAG_RESET and a buffer too small for all
+**          of them. Reads must not be reported.
+**
+**============================================================*/
+#include <palsuite.h>
+
+#define REGION_PAGES 16
+#define COMMITTED_PAGES 8
+
+static char *pRegion;
+static SYSTEM_INFO systemInfo;
+
+static ULONG_PTR GetWritten(DWORD flags, PVOID *addresses, ULONG_PTR capacity)
+{
+    ULONG_PTR count = capacity;
+    ULONG granularity = 0;
+
+    if (GetWriteWatch(flags, pRegion, REGION_PAGES * systemInfo.dwPageSize,
+                      addresses, &count, &granularity) != 0)
+    {
+        Fail("GetWriteWatch failed! GetLastError returned %u\n",
+             GetLastError());
+    }
+
+    if (granularity != systemInfo.dwPageSize)
+    {
+        Fail("GetWriteWatch returned granularity %u instead of %u\n",
+             granularity, systemInfo.dwPageSize);
+    }
+
+    return count;
+}
+
+static void CheckWritten(DWORD flags, ULONG_PTR capacity,
+                         ULONG_PTR expectedCount, const int *expectedPages)
+{
+    PVOID addresses[REGION_PAGES];
+    ULONG_PTR count;
+    ULONG_PTR i;
+
+    count = GetWritten(flags, addresses, capacity);
+    if (count != expectedCount)
+    {
+        Fail("GetWriteWatch reported %u pages instead of %u\n",
+             (UINT)count, (UINT)expectedCount);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (addresses[i] != pRegion + expectedPages[i] * systemInfo.dwPageSize)
+        {
+            Fail("GetWriteWatch reported %p instead of page %d (%p)\n",
+                 addresses[i], expectedPages[i],
+                 pRegion + expectedPages[i] * systemInfo.dwPageSize);
+        }
+    }
+}
+
+int __cdecl main(int argc, char *argv[])
+{
+    PVOID addresses[REGION_PAGES];
+    ULONG_PTR count;
+    char *pOther;
+    volatile char value;
+    int i;
+
+    const int pages1And5[] = { 1, 5 };
+    const int page5[] = { 5 };
+    const int pages0To3[] = { 0, 1, 2, 3 };
+
+    if (0 != PAL_Initialize(argc, argv))
+    {
+        return FAIL;
+    }
+
+    GetSystemInfo(&systemInfo);
+
+    pRegion = (char *)VirtualAlloc(NULL, REGION_PAGES * systemInfo.dwPageSize,
+                                   MEM_RESERVE | MEM_WRITE_WATCH, PAGE_NOACCESS);
+    if (pRegion == NULL)
+    {
+        Fail("VirtualAlloc with MEM_WRITE_WATCH failed! GetLastError returned %u\n",
+             GetLastError());
+    }
+
+    if (VirtualAlloc(pRegion, COMMITTED_PAGES * systemInfo.dwPageSize,
+                     MEM_COMMIT, PAGE_READWRITE) == NULL)
+    {
+        Fail("VirtualAlloc failed to commit pages! GetLastError returned %u\n",
+             GetLastError());
+    }
+
+    /* Nothing written yet, reading doesn't count as a write */
+    value = pRegion[2 * systemInfo.dwPageSize];
+    CheckWritten(0, REGION_PAGES, 0, NULL);
+
+    pRegion[1 * systemInfo.dwPageSize] = 1;
+    pRegion[5 * systemInfo.dwPageSize + 10] = 5;
+    pRegion[5 * systemInfo.dwPageSize + 20] = 6;
+
+    /* Without reset, pages stay reported */
+    CheckWritten(0, REGION_PAGES, 2, pages1And5);
+    CheckWritten(0, REGION_PAGES, 2, pages1And5);
+
+    /* With reset, pages are reported once */
+    CheckWritten(WRITE_WATCH_FLAG_RESET, REGION_PAGES, 2, pages1And5);
+    CheckWritten(0, REGION_PAGES, 0, NULL);
+
+    /* Writes to a reset page are tracked again, and data is preserved */
+    pRegion[5 * systemInfo.dwPageSize + 30] = 7;
+    CheckWritten(0, REGION_PAGES, 1, page5);
+    if (pRegion[1 * systemInfo.dwPageSize] != 1 ||
+        pRegion[5 * systemInfo.dwPageSize + 10] != 5 ||
+        pRegion[5 * systemInfo.dwPageSize + 20] != 6 ||
+        pRegion[5 * systemInfo.dwPageSize + 30] != 7)
+    {
+        Fail("Data written to write watched pages was lost\n");
+    }
+    CheckWritten(WRITE_WATCH_FLAG_RESET, REGION_PAGES, 1, page5);
+
+    /* With a buffer too small, only the reported pages are reset */
+    for (i = 0; i < 4; i++)
+    {
+        pRegion[i * systemInfo.dwPageSize] = (char)i;
+    }
+    CheckWritten(WRITE_WATCH_FLAG_RESET, 2, 2, pages0To3);
+    CheckWritten(0, REGION_PAGES, 2, pages0To3 + 2);
+
+    /* Ranges outside of a write watched region are rejected */
+    pOther = (char *)VirtualAlloc(NULL, systemInfo.dwPageSize,
+                                  MEM_COMMIT, PAGE_READWRITE);
+    if (pOther == NULL)
+    {
+        Fail("VirtualAlloc failed! GetLastError returned %u\n", GetLastError());
+    }
+
+    count = REGION_PAGES;
+    if (GetWriteWatch(0, pOther, systemInfo.dwPageSize,
+                      addresses, &count, NULL) == 0)
+    {
+        Fail("GetWriteWatch succeeded on a region without MEM_WRITE_WATCH\n");
+    }
+
+    if (!VirtualFree(pOther, 0, MEM_RELEASE) ||
+        !VirtualFree(pRegion, 0, MEM_RELEASE))
+    {
+        Fail("VirtualFree failed! GetLastError returned %u\n", GetLastError());
+    }
+
+    PAL_Terminate();
+    return PASS;
+}
@@ -0,0 +1,111 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//
+
+/*=============================================================
+**
+** Source:  test1.c
+**
+** Purpose: Positive test the ResetWriteWatch API.
+**          Reset part of a MEM_WRITE_WATCH region, and check that
+**          only pages outside of the reset range stay reported,
+**          and that reset pages are tracked again when written.
+**
+**============================================================*/
+#include <palsuite.h>
+
+#define REGION_PAGES 8
+
+int __cdecl main(int argc, char *argv[])
+{
+    SYSTEM_INFO systemInfo;
+    PVOID addresses[REGION_PAGES];
+    ULONG_PTR count;
+    char *pRegion;
+    int i;
+
+    if (0 != PAL_Initialize(argc, argv))
+    {
+        return FAIL;
+    }
+
+    GetSystemInfo(&systemInfo);
+
+    pRegion = (char *)VirtualAlloc(NULL, REGION_PAGES * systemInfo.dwPageSize,
+                                   MEM_RESERVE | MEM_COMMIT | MEM_WRITE_WATCH,
+                                   PAGE_READWRITE);
+    if (pRegion == NULL)
+    {
+        Fail("VirtualAlloc with MEM_WRITE_WATCH failed! GetLastError returned %u\n",
+             GetLastError());
+    }
+
+    for (i = 0; i < REGION_PAGES; i++)
+    {
+        pRegion[i * systemInfo.dwPageSize] = (char)i;
+    }
+
+    /* Reset the first half only */
+    if (ResetWriteWatch(pRegion, REGION_PAGES / 2 * systemInfo.dwPageSize) != 0)
+    {
+        Fail("ResetWriteWatch failed! GetLastError returned %u\n", GetLastError());
+    }
+
+    count = REGION_PAGES;
+    if (GetWriteWatch(0, pRegion, REGION_PAGES * systemInfo.dwPageSize,
+                      addresses, &count, NULL) != 0)
+    {
+        Fail("GetWriteWatch failed! GetLastError returned %u\n", GetLastError());
+    }
+
+    if (count != REGION_PAGES / 2)
+    {
+        Fail("GetWriteWatch reported %u pages instead of %u\n",
+             (UINT)count, REGION_PAGES / 2);
+    }
+
+    for (i = 0; i < (int)count; i++)
+    {
+        if (addresses[i] != pRegion + (REGION_PAGES / 2 + i) * systemInfo.dwPageSize)
+        {
+            Fail("GetWriteWatch reported unexpected address %p\n", addresses[i]);
+        }
+    }
+
+    /* Writes to a reset page are tracked again */
+    pRegion[systemInfo.dwPageSize + 1] = 42;
+    if (ResetWriteWatch(pRegion + REGION_PAGES / 2 * systemInfo.dwPageSize,
+                        REGION_PAGES / 2 * systemInfo.dwPageSize) != 0)
+    {
+        Fail("ResetWriteWatch failed! GetLastError returned %u\n", GetLastError());
+    }
+
+    count = REGION_PAGES;
+    if (GetWriteWatch(0, pRegion, REGION_PAGES * systemInfo.dwPageSize,
+                      addresses, &count, NULL) != 0)
+    {
+        Fail("GetWriteWatch failed! GetLastError returned %u\n", GetLastError());
+    }
+
+    if (count != 1 || addresses[0] != pRegion + systemInfo.dwPageSize)
+    {
+        Fail("GetWriteWatch didn't report the page written after reset\n");
+    }
+
+    for (i = 0; i < REGION_PAGES; i++)
+    {
+        if (pRegion[i * systemInfo.dwPageSize] != (char)i)
+        {
+            Fail("Data written to write watched pages was lost\n");
+        }
+    }
+
+    if (!VirtualFree(pRegion, 0, MEM_RELEASE))
+    {
+        Fail("VirtualFree failed! GetLastError returned %u\n", GetLastError());
+    }
+
+    PAL_Terminate();
+    return PASS;
+}
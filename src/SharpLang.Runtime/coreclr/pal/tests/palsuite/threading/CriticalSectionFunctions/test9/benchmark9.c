@@ -0,0 +1,206 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//
+
+/*=====================================================================
+**
+** Source:      CriticalSectionFunctions/test9/benchmark9.c
+**
+** Purpose:     Microbenchmark measuring critical section throughput
+**              (enter/leave pairs per millisecond) with 1 to N threads
+**              hammering the same CS, while checking mutual exclusion.
+**              Not part of the test list: run it by hand.
+**
+**              Usage: benchmark9 [-t max_thread_count] [-n loop_count]
+**
+**
+**===================================================================*/
+#include <palsuite.h>
+
+#define MAX_THREAD_COUNT       64
+#define DEFAULT_LOOP_COUNT     100000
+
+int g_iLoopCount = DEFAULT_LOOP_COUNT;
+volatile LONG g_lCriticalCount = 0;
+volatile LONG g_lTotalCount = 0;
+HANDLE g_hEvStart = NULL;
+
+CRITICAL_SECTION g_cs;
+
+DWORD PALAPI Thread(LPVOID lpParam)
+{
+    int i;
+    DWORD dwRet;
+
+    dwRet = WaitForSingleObject(g_hEvStart, INFINITE);
+    if (WAIT_OBJECT_0 != dwRet)
+    {
+        Fail("WaitForSingleObject returned unexpected %u [GetLastError()=%u]\n",
+             dwRet, GetLastError());
+    }
+
+    for (i=0;i<g_iLoopCount;i++)
+    {
+        EnterCriticalSection(&g_cs);
+
+        if (1 != ++g_lCriticalCount)
+        {
+            Fail("Detected %d threads in area protected by critical section "
+                 "[expected: 1 thread]\n", (int)g_lCriticalCount);
+        }
+        g_lTotalCount += 1;
+        g_lCriticalCount -= 1;
+
+        LeaveCriticalSection(&g_cs);
+    }
+
+    return 0;
+}
+
+/*
+ * Runs the benchmark with the given number of threads, and returns
+ * the elapsed time in milliseconds
+ */
+double RunBenchmark(int iThreadCount)
+{
+    DWORD dwThreadId;
+    DWORD dwRet;
+    HANDLE hThreads[MAX_THREAD_COUNT] = { 0 };
+    LARGE_INTEGER liFrequency, liStart, liEnd;
+    int i;
+
+    g_lTotalCount = 0;
+
+    g_hEvStart = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (g_hEvStart == NULL)
+    {
+        Fail("CreateEvent call failed.  GetLastError "
+             "returned %u.\n", GetLastError());
+    }
+
+    for (i=0;i<iThreadCount;i++)
+    {
+        hThreads[i] = CreateThread(NULL,
+                                   0,
+                                   &Thread,
+                                   (LPVOID) NULL,
+                                   0,
+                                   &dwThreadId);
+        if (NULL == hThreads[i])
+        {
+            Fail("CreateThread failed [GetLastError()=%u]\n", GetLastError());
+        }
+    }
+
+    // Let all threads reach the start event
+    Sleep(100);
+
+    if (!QueryPerformanceFrequency(&liFrequency) ||
+        !QueryPerformanceCounter(&liStart))
+    {
+        Fail("QueryPerformanceCounter failed [GetLastError()=%u]\n",
+             GetLastError());
+    }
+
+    if (!SetEvent(g_hEvStart))
+    {
+        Fail("SetEvent failed [GetLastError()=%u]\n", GetLastError());
+    }
+
+    dwRet = WaitForMultipleObjects(iThreadCount, hThreads, TRUE, INFINITE);
+    if (WAIT_OBJECT_0 != dwRet)
+    {
+        Fail("Wait for all threads failed\n");
+    }
+
+    QueryPerformanceCounter(&liEnd);
+
+    for (i=0;i<iThreadCount;i++)
+    {
+        CloseHandle(hThreads[i]);
+    }
+    CloseHandle(g_hEvStart);
+
+    if (g_lTotalCount != (LONG)iThreadCount * g_iLoopCount)
+    {
+        Fail("Lost updates in area protected by critical section: "
+             "%d instead of %d\n", (int)g_lTotalCount, iThreadCount * g_iLoopCount);
+    }
+
+    return (double)(liEnd.QuadPart - liStart.QuadPart) * 1000.0 /
+        (double)liFrequency.QuadPart;
+}
+
+int __cdecl main(int argc, char **argv)
+{
+    SYSTEM_INFO sysInfo;
+    int iMaxThreadCount;
+    int iThreadCount;
+    int i, iVal;
+    double dElapsed;
+
+    if ((PAL_Initialize(argc,argv)) != 0)
+    {
+        return(FAIL);
+    }
+
+    // By default, go up to twice the number of processors (oversubscribed)
+    GetSystemInfo(&sysInfo);
+    iMaxThreadCount = 2 * sysInfo.dwNumberOfProcessors;
+    if (MAX_THREAD_COUNT < iMaxThreadCount)
+    {
+        iMaxThreadCount = MAX_THREAD_COUNT;
+    }
+
+    for (i=1; i<argc; i++)
+    {
+        if ('-' == *argv[i])
+        {
+            switch(*(argv[i]+1))
+            {
+            case 'n':
+                if (i < argc-1)
+                {
+                    i += 1;
+                    iVal = atoi(argv[i]);
+                    if (0 < iVal)
+                    {
+                        g_iLoopCount = iVal;
+                    }
+                }
+                break;
+            case 't':
+                if (i < argc-1)
+                {
+                    i += 1;
+                    iVal = atoi(argv[i]);
+                    if (0 < iVal && MAX_THREAD_COUNT >= iVal)
+                    {
+                        iMaxThreadCount = iVal;
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    InitializeCriticalSection(&g_cs);
+
+    Trace("Iterations per thread: %d\n", g_iLoopCount);
+    Trace("Threads\tTime (ms)\tEnter/Leave per ms\n");
+
+    for (iThreadCount=1; iThreadCount<=iMaxThreadCount; iThreadCount++)
+    {
+        dElapsed = RunBenchmark(iThreadCount);
+        Trace("%d\t%.1f\t%.0f\n", iThreadCount, dElapsed,
+              (double)iThreadCount * g_iLoopCount / (dElapsed > 0 ? dElapsed : 1));
+    }
+
+    DeleteCriticalSection(&g_cs);
+
+    PAL_Terminate();
+    return (PASS);
+}
@@ -0,0 +1,144 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//
+
+/*=====================================================================
+**
+** Source:      CriticalSectionFunctions/test9/test9.c
+**
+** Purpose:     Check mutual exclusion on a contended critical section,
+**              with threads entering it recursively, so that waiters
+**              go through both the spinning and the sleeping paths.
+**
+**
+**===================================================================*/
+#include <palsuite.h>
+
+#define THREAD_COUNT    8
+#define LOOP_COUNT      20000
+
+volatile LONG g_lCriticalCount = 0;
+volatile LONG g_lTotalCount = 0;
+HANDLE g_hEvStart = NULL;
+
+CRITICAL_SECTION g_cs;
+
+DWORD PALAPI Thread(LPVOID lpParam)
+{
+    int i;
+    DWORD dwRet;
+
+    dwRet = WaitForSingleObject(g_hEvStart, INFINITE);
+    if (WAIT_OBJECT_0 != dwRet)
+    {
+        Fail("WaitForSingleObject returned unexpected %u [GetLastError()=%u]\n",
+             dwRet, GetLastError());
+    }
+
+    for (i=0;i<LOOP_COUNT;i++)
+    {
+        EnterCriticalSection(&g_cs);
+
+        if (1 != ++g_lCriticalCount)
+        {
+            Fail("Detected %d threads in area protected by critical section "
+                 "[expected: 1 thread]\n", (int)g_lCriticalCount);
+        }
+
+        // Every few iterations, enter recursively: other threads must
+        // stay out until the outermost leave
+        if (0 == i % 16)
+        {
+            EnterCriticalSection(&g_cs);
+            g_lTotalCount += 1;
+            LeaveCriticalSection(&g_cs);
+
+            if (1 != g_lCriticalCount)
+            {
+                Fail("Critical section was released by a recursive leave\n");
+            }
+            g_lTotalCount -= 1;
+        }
+
+        g_lTotalCount += 1;
+        g_lCriticalCount -= 1;
+
+        LeaveCriticalSection(&g_cs);
+
+        // Occasionally hold the CS for a while, so that waiters give up
+        // spinning and go to sleep
+        if (0 == i % 1000)
+        {
+            EnterCriticalSection(&g_cs);
+            Sleep(1);
+            LeaveCriticalSection(&g_cs);
+        }
+    }
+
+    return 0;
+}
+
+int __cdecl main(int argc, char **argv)
+{
+    DWORD dwThreadId;
+    DWORD dwRet;
+    HANDLE hThreads[THREAD_COUNT] = { 0 };
+    int i;
+
+    if ((PAL_Initialize(argc,argv)) != 0)
+    {
+        return(FAIL);
+    }
+
+    InitializeCriticalSection(&g_cs);
+
+    g_hEvStart = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (g_hEvStart == NULL)
+    {
+        Fail("CreateEvent call failed.  GetLastError "
+             "returned %u.\n", GetLastError());
+    }
+
+    for (i=0;i<THREAD_COUNT;i++)
+    {
+        hThreads[i] = CreateThread(NULL,
+                                   0,
+                                   &Thread,
+                                   (LPVOID) NULL,
+                                   0,
+                                   &dwThreadId);
+        if (NULL == hThreads[i])
+        {
+            Fail("CreateThread failed [GetLastError()=%u]\n", GetLastError());
+        }
+    }
+
+    if (!SetEvent(g_hEvStart))
+    {
+        Fail("SetEvent failed [GetLastError()=%u]\n", GetLastError());
+    }
+
+    dwRet = WaitForMultipleObjects(THREAD_COUNT, hThreads, TRUE, INFINITE);
+    if (WAIT_OBJECT_0 != dwRet)
+    {
+        Fail("Wait for all threads failed\n");
+    }
+
+    for (i=0;i<THREAD_COUNT;i++)
+    {
+        CloseHandle(hThreads[i]);
+    }
+    CloseHandle(g_hEvStart);
+
+    if (g_lTotalCount != (LONG)THREAD_COUNT * LOOP_COUNT)
+    {
+        Fail("Lost updates in area protected by critical section: "
+             "%d instead of %d\n", (int)g_lTotalCount, THREAD_COUNT * LOOP_COUNT);
+    }
+
+    DeleteCriticalSection(&g_cs);
+
+    PAL_Terminate();
+    return (PASS);
+}
@@ -0,0 +1,217 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//
+
+/*=====================================================================
+**
+** Source:    test13.c (DuplicateHandle)
+**
+** Purpose:   Stress the handle manager: allocate enough handles to span
+**            several handle table segments, then have threads duplicate,
+**            use and close handles while other threads keep looking up
+**            a shared handle. Also checks that closed handles are
+**            rejected.
+**
+**
+**===================================================================*/
+#include <palsuite.h>
+
+#define HANDLE_COUNT        3000
+#define WORKER_COUNT        4
+#define LOOKUP_COUNT        4
+#define LOOP_COUNT          5000
+
+HANDLE g_hShared = NULL;
+HANDLE g_hEvStart = NULL;
+volatile LONG g_lWorkersRunning = WORKER_COUNT;
+
+DWORD PALAPI WorkerThread(LPVOID lpParam)
+{
+    HANDLE hDup;
+    HANDLE hEvent;
+    DWORD dwRet;
+    int i;
+
+    if (WAIT_OBJECT_0 != WaitForSingleObject(g_hEvStart, INFINITE))
+    {
+        Fail("WaitForSingleObject on the start event failed\n");
+    }
+
+    for (i = 0; i < LOOP_COUNT; i++)
+    {
+        if (!DuplicateHandle(GetCurrentProcess(), g_hShared,
+                             GetCurrentProcess(), &hDup,
+                             0, FALSE, DUPLICATE_SAME_ACCESS))
+        {
+            Fail("DuplicateHandle failed [GetLastError()=%u]\n", GetLastError());
+        }
+
+        dwRet = WaitForSingleObject(hDup, 0);
+        if (WAIT_OBJECT_0 != dwRet)
+        {
+            Fail("WaitForSingleObject on a duplicated handle returned %u "
+                 "[GetLastError()=%u]\n", dwRet, GetLastError());
+        }
+
+        hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+        if (NULL == hEvent)
+        {
+            Fail("CreateEvent failed [GetLastError()=%u]\n", GetLastError());
+        }
+
+        dwRet = WaitForSingleObject(hEvent, 0);
+        if (WAIT_TIMEOUT != dwRet)
+        {
+            Fail("WaitForSingleObject on a new event returned %u "
+                 "instead of WAIT_TIMEOUT\n", dwRet);
+        }
+
+        if (!SetEvent(hEvent) || WAIT_OBJECT_0 != WaitForSingleObject(hEvent, 0))
+        {
+            Fail("Event created by a worker thread wasn't signaled\n");
+        }
+
+        if (!CloseHandle(hEvent) || !CloseHandle(hDup))
+        {
+            Fail("CloseHandle failed [GetLastError()=%u]\n", GetLastError());
+        }
+    }
+
+    InterlockedDecrement(&g_lWorkersRunning);
+    return 0;
+}
+
+DWORD PALAPI LookupThread(LPVOID lpParam)
+{
+    DWORD dwRet;
+
+    if (WAIT_OBJECT_0 != WaitForSingleObject(g_hEvStart, INFINITE))
+    {
+        Fail("WaitForSingleObject on the start event failed\n");
+    }
+
+    while (0 != g_lWorkersRunning)
+    {
+        dwRet = WaitForSingleObject(g_hShared, 0);
+        if (WAIT_OBJECT_0 != dwRet)
+        {
+            Fail("WaitForSingleObject on the shared handle returned %u "
+                 "[GetLastError()=%u]\n", dwRet, GetLastError());
+        }
+    }
+
+    return 0;
+}
+
+int __cdecl main(int argc, char **argv)
+{
+    HANDLE hHandles[HANDLE_COUNT];
+    HANDLE hThreads[WORKER_COUNT + LOOKUP_COUNT];
+    HANDLE hClosed;
+    DWORD dwThreadId;
+    DWORD dwRet;
+    int i;
+
+    if ((PAL_Initialize(argc,argv)) != 0)
+    {
+        return (FAIL);
+    }
+
+    /* Enough handles to need several table segments */
+    for (i = 0; i < HANDLE_COUNT; i++)
+    {
+        hHandles[i] = CreateEvent(NULL, TRUE, (i % 2) != 0, NULL);
+        if (NULL == hHandles[i])
+        {
+            Fail("CreateEvent #%d failed [GetLastError()=%u]\n",
+                 i, GetLastError());
+        }
+    }
+
+    for (i = 0; i < HANDLE_COUNT; i++)
+    {
+        dwRet = WaitForSingleObject(hHandles[i], 0);
+        if (dwRet != ((i % 2) != 0 ? WAIT_OBJECT_0 : WAIT_TIMEOUT))
+        {
+            Fail("Handle #%d doesn't refer to the right event\n", i);
+        }
+    }
+
+    /* A closed handle must be rejected */
+    hClosed = hHandles[HANDLE_COUNT - 1];
+    if (!CloseHandle(hClosed))
+    {
+        Fail("CloseHandle failed [GetLastError()=%u]\n", GetLastError());
+    }
+
+    SetLastError(ERROR_SUCCESS);
+    if (WAIT_FAILED != WaitForSingleObject(hClosed, 0) ||
+        ERROR_INVALID_HANDLE != GetLastError())
+    {
+        Fail("WaitForSingleObject didn't fail with ERROR_INVALID_HANDLE "
+             "on a closed handle\n");
+    }
+
+    if (CloseHandle(hClosed))
+    {
+        Fail("CloseHandle succeeded on an already closed handle\n");
+    }
+
+    /* Concurrent allocation, lookup and release */
+    g_hShared = CreateEvent(NULL, TRUE, TRUE, NULL);
+    g_hEvStart = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (NULL == g_hShared || NULL == g_hEvStart)
+    {
+        Fail("CreateEvent failed [GetLastError()=%u]\n", GetLastError());
+    }
+
+    for (i = 0; i < WORKER_COUNT + LOOKUP_COUNT; i++)
+    {
+        hThreads[i] = CreateThread(NULL, 0,
+                                   i < WORKER_COUNT ? &WorkerThread : &LookupThread,
+                                   NULL, 0, &dwThreadId);
+        if (NULL == hThreads[i])
+        {
+            Fail("CreateThread failed [GetLastError()=%u]\n", GetLastError());
+        }
+    }
+
+    if (!SetEvent(g_hEvStart))
+    {
+        Fail("SetEvent failed [GetLastError()=%u]\n", GetLastError());
+    }
+
+    dwRet = WaitForMultipleObjects(WORKER_COUNT + LOOKUP_COUNT, hThreads,
+                                   TRUE, INFINITE);
+    if (WAIT_OBJECT_0 != dwRet)
+    {
+        Fail("Wait for all threads failed\n");
+    }
+
+    for (i = 0; i < WORKER_COUNT + LOOKUP_COUNT; i++)
+    {
+        CloseHandle(hThreads[i]);
+    }
+
+    /* Handles allocated before the threads ran are still intact */
+    for (i = 0; i < HANDLE_COUNT - 1; i++)
+    {
+        dwRet = WaitForSingleObject(hHandles[i], 0);
+        if (dwRet != ((i % 2) != 0 ? WAIT_OBJECT_0 : WAIT_TIMEOUT))
+        {
+            Fail("Handle #%d doesn't refer to the right event anymore\n", i);
+        }
+
+        if (!CloseHandle(hHandles[i]))
+        {
+            Fail("CloseHandle failed [GetLastError()=%u]\n", GetLastError());
+        }
+    }
+
+    CloseHandle(g_hShared);
+    CloseHandle(g_hEvStart);
+
+    PAL_Terminate();
+    return (PASS);
+}
@@ -0,0 +1,201 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+//
+
+/*============================================================
+**
+** Source: test5.c
+**
+** Purpose: Exercise the wake-up paths of the synchronization manager:
+**          many signal/wait round trips between two threads, timed
+**          waits that expire and timed waits woken before their
+**          timeout, and a manual-reset event waking many waiters.
+**
+**
+**=========================================================*/
+
+#include <palsuite.h>
+
+#define ROUND_TRIP_COUNT    20000
+#define WAITER_COUNT        16
+
+HANDLE g_hPing = NULL;
+HANDLE g_hPong = NULL;
+HANDLE g_hGate = NULL;
+volatile LONG g_lValue = 0;
+volatile LONG g_lWoken = 0;
+
+DWORD PALAPI PongThread(LPVOID lpParam)
+{
+    int i;
+
+    for (i = 0; i < ROUND_TRIP_COUNT; i++)
+    {
+        if (WAIT_OBJECT_0 != WaitForSingleObject(g_hPing, INFINITE))
+        {
+            Fail("WaitForSingleObject failed [GetLastError()=%u]\n",
+                 GetLastError());
+        }
+
+        if (g_lValue != 2 * i + 1)
+        {
+            Fail("Pong thread woke up out of order: value is %d "
+                 "instead of %d\n", (int)g_lValue, 2 * i + 1);
+        }
+        g_lValue += 1;
+
+        if (!SetEvent(g_hPong))
+        {
+            Fail("SetEvent failed [GetLastError()=%u]\n", GetLastError());
+        }
+    }
+
+    return 0;
+}
+
+DWORD PALAPI TimedWaiterThread(LPVOID lpParam)
+{
+    DWORD dwRet;
+
+    /* Woken up by the main thread long before the timeout */
+    dwRet = WaitForSingleObject(g_hGate, 20000);
+    if (WAIT_OBJECT_0 != dwRet)
+    {
+        Fail("Timed wait returned %u instead of WAIT_OBJECT_0\n", dwRet);
+    }
+
+    InterlockedIncrement(&g_lWoken);
+    return 0;
+}
+
+static HANDLE StartThread(LPTHREAD_START_ROUTINE lpStartAddress)
+{
+    DWORD dwThreadId;
+    HANDLE hThread;
+
+    hThread = CreateThread(NULL, 0, lpStartAddress, NULL, 0, &dwThreadId);
+    if (NULL == hThread)
+    {
+        Fail("CreateThread failed [GetLastError()=%u]\n", GetLastError());
+    }
+
+    return hThread;
+}
+
+int __cdecl main(int argc, char **argv)
+{
+    HANDLE hThreads[WAITER_COUNT];
+    HANDLE hEvent;
+    DWORD dwStart;
+    DWORD dwElapsed;
+    DWORD dwRet;
+    int i;
+
+    if ((PAL_Initialize(argc,argv)) != 0)
+    {
+        return (FAIL);
+    }
+
+    /* Round trips between two threads with auto-reset events */
+    g_hPing = CreateEvent(NULL, FALSE, FALSE, NULL);
+    g_hPong = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (NULL == g_hPing || NULL == g_hPong)
+    {
+        Fail("CreateEvent failed [GetLastError()=%u]\n", GetLastError());
+    }
+
+    hThreads[0] = StartThread(&PongThread);
+
+    for (i = 0; i < ROUND_TRIP_COUNT; i++)
+    {
+        g_lValue += 1;
+        if (!SetEvent(g_hPing))
+        {
+            Fail("SetEvent failed [GetLastError()=%u]\n", GetLastError());
+        }
+
+        if (WAIT_OBJECT_0 != WaitForSingleObject(g_hPong, INFINITE))
+        {
+            Fail("WaitForSingleObject failed [GetLastError()=%u]\n",
+                 GetLastError());
+        }
+
+        if (g_lValue != 2 * i + 2)
+        {
+            Fail("Main thread woke up out of order: value is %d "
+                 "instead of %d\n", (int)g_lValue, 2 * i + 2);
+        }
+    }
+
+    if (WAIT_OBJECT_0 != WaitForSingleObject(hThreads[0], INFINITE))
+    {
+        Fail("Waiting for the pong thread failed\n");
+    }
+    CloseHandle(hThreads[0]);
+
+    /* A timed wait that nobody satisfies times out, and not too early */
+    hEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (NULL == hEvent)
+    {
+        Fail("CreateEvent failed [GetLastError()=%u]\n", GetLastError());
+    }
+
+    dwStart = GetTickCount();
+    dwRet = WaitForSingleObject(hEvent, 200);
+    dwElapsed = GetTickCount() - dwStart;
+    if (WAIT_TIMEOUT != dwRet)
+    {
+        Fail("Timed wait returned %u instead of WAIT_TIMEOUT\n", dwRet);
+    }
+
+    if (dwElapsed < 150 || dwElapsed > 5000)
+    {
+        Fail("Timed wait of 200ms took %u ms\n", dwElapsed);
+    }
+    CloseHandle(hEvent);
+
+    /* A manual-reset event wakes all timed waiters before their timeout */
+    g_hGate = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (NULL == g_hGate)
+    {
+        Fail("CreateEvent failed [GetLastError()=%u]\n", GetLastError());
+    }
+
+    for (i = 0; i < WAITER_COUNT; i++)
+    {
+        hThreads[i] = StartThread(&TimedWaiterThread);
+    }
+
+    Sleep(100);
+    if (0 != g_lWoken)
+    {
+        Fail("%d waiters woke up before the event was set\n", (int)g_lWoken);
+    }
+
+    dwStart = GetTickCount();
+    if (!SetEvent(g_hGate))
+    {
+        Fail("SetEvent failed [GetLastError()=%u]\n", GetLastError());
+    }
+
+    dwRet = WaitForMultipleObjects(WAITER_COUNT, hThreads, TRUE, 10000);
+    dwElapsed = GetTickCount() - dwStart;
+    if (WAIT_OBJECT_0 != dwRet || WAITER_COUNT != g_lWoken)
+    {
+        Fail("Only %d out of %d waiters woke up in %u ms\n",
+             (int)g_lWoken, WAITER_COUNT, dwElapsed);
+    }
+
+    for (i = 0; i < WAITER_COUNT; i++)
+    {
+        CloseHandle(hThreads[i]);
+    }
+
+    CloseHandle(g_hGate);
+    CloseHandle(g_hPing);
+    CloseHandle(g_hPong);
+
+    PAL_Terminate();
+    return (PASS);
+}
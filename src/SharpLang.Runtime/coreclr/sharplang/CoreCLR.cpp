@@ -2,6 +2,9 @@
 #include "floatclass.h"
 #include "../classlibnative/cryptography/cryptography.h"
 #include "../classlibnative/bcltype/number.h"
+#include "../../Heap.h"
+#include "../../HandleTable.h"
+#include "../../Finalizer.h"
 
 // Later we should directly use ecalllist.h info to automatically replace VTable pointers for internal calls
 
@@ -22,7 +25,9 @@ extern "C" Object* System_Number__FormatInt32_System_Int32_System_String_System_
 
 extern "C" Object* System_Threading_Interlocked__CompareExchange_System_Object__System_Object_System_Object_(Object** location1, Object* value, Object* comparand)
 {
-        return (Object*)InterlockedCompareExchangeT(location1, value, comparand);
+        auto result = (Object*)InterlockedCompareExchangeT(location1, value, comparand);
+        writeBarrier(location1);
+        return result;
 }
 
 extern "C" Object* System_Threading_Interlocked__CompareExchange_System_IntPtr__System_IntPtr_System_IntPtr_(void** location1, void* value, void* comparand)
@@ -30,16 +35,127 @@ extern "C" Object* System_Threading_Interlocked__CompareExchange_System_IntPtr__
         return (Object*)InterlockedCompareExchangeT(location1, value, comparand);
 }
 
+extern "C" GCHandle* System_Runtime_InteropServices_GCHandle__InternalAlloc_System_Object_System_Runtime_InteropServices_GCHandleType_(Object* value, int32_t type)
+{
+        return CreateHandle(value, type);
+}
+
+extern "C" void System_Runtime_InteropServices_GCHandle__InternalFree_System_IntPtr_(GCHandle* gcHandle)
+{
+        DestroyHandle(gcHandle);
+}
+
 extern "C" Object* System_Runtime_InteropServices_GCHandle__InternalGet_System_IntPtr_(GCHandle* gcHandle)
 {
         return gcHandle->value;
 }
 
+extern "C" void System_Runtime_InteropServices_GCHandle__InternalSet_System_IntPtr_System_Object_System_Boolean_(GCHandle* gcHandle, Object* value, bool isPinned)
+{
+        // Handles are not in the heap, no write barrier needed
+        gcHandle->value = value;
+}
+
 extern "C" Object* System_Runtime_InteropServices_GCHandle__InternalCompareExchange_System_IntPtr_System_Object_System_Object_System_Boolean_(GCHandle* gcHandle, Object* value, Object* oldValue, bool isPinned)
 {
         return (Object*)InterlockedCompareExchangeT(&gcHandle->value, value, oldValue);
 }
 
+extern "C" void* System_Runtime_InteropServices_GCHandle__InternalAddrOfPinnedObject_System_IntPtr_(GCHandle* gcHandle)
+{
+        auto value = gcHandle->value;
+        if (value == NULL)
+                return NULL;
+
+        // Strings and arrays: address of first character/element
+        switch (value->eeType->corElementType)
+        {
+        case ELEMENT_TYPE_STRING:
+                return &((StringObject*)value)->firstChar;
+        case ELEMENT_TYPE_SZARRAY:
+        case ELEMENT_TYPE_ARRAY:
+                return ((ArrayBase*)value)->GetDataPtr();
+        default:
+                return value->GetDataPointer();
+        }
+}
+
+extern "C" void System_Runtime_InteropServices_GCHandle__InternalCheckDomain_System_IntPtr_(GCHandle* gcHandle)
+{
+}
+
+extern "C" int32_t System_Runtime_InteropServices_GCHandle__InternalGetHandleType_System_IntPtr_(GCHandle* gcHandle)
+{
+        return GetHandleType(gcHandle);
+}
+
+// GCInterface is not compiled yet (see SHARPLANG_GCINTERFACE), forward directly to GCHeap
+extern "C" __declspec(dllexport) void __stdcall _Collect(int32_t generation, int32_t mode)
+{
+	GCHeap::GetGCHeap()->GarbageCollect(generation, FALSE, mode);
+}
+
+extern "C" __declspec(dllexport) void __stdcall _WaitForPendingFinalizers()
+{
+	::WaitForPendingFinalizers();
+}
+
+// Memory pressure goes directly to heap budgets (GCInterface::AddMemoryPressure threshold logic is not needed)
+extern "C" __declspec(dllexport) void __stdcall _AddMemoryPressure(uint64_t bytesAllocated)
+{
+	::AddMemoryPressure((size_t)bytesAllocated);
+}
+
+extern "C" __declspec(dllexport) void __stdcall _RemoveMemoryPressure(uint64_t bytesAllocated)
+{
+	::RemoveMemoryPressure((size_t)bytesAllocated);
+}
+
+extern "C" __declspec(dllexport) int64_t __stdcall GetTotalMemory()
+{
+	return (int64_t)GCHeap::GetGCHeap()->GetTotalBytesInUse();
+}
+
+extern "C" int32_t System_GC___CollectionCount_System_Int32_System_Int32_(int32_t generation, int32_t getSpecialGCCount)
+{
+	return GCHeap::GetGCHeap()->CollectionCount(generation, getSpecialGCCount);
+}
+
+extern "C" int32_t System_GC__GetMaxGeneration__()
+{
+	return (int32_t)GCHeap::GetGCHeap()->GetMaxGeneration();
+}
+
+extern "C" int32_t System_GC__GetGeneration_System_Object_(Object* obj)
+{
+	return (int32_t)GCHeap::GetGCHeap()->WhichGeneration(obj);
+}
+
+extern "C" void System_Runtime_InteropServices_SafeHandle__InternalDispose__(SafeHandle* safeHandle)
+{
+	SafeHandle::DisposeNative(safeHandle);
+}
+
+extern "C" void System_Runtime_InteropServices_SafeHandle__InternalFinalize__(SafeHandle* safeHandle)
+{
+	SafeHandle::Finalize(safeHandle);
+}
+
+extern "C" void System_Runtime_InteropServices_SafeHandle__SetHandleAsInvalid__(SafeHandle* safeHandle)
+{
+	SafeHandle::SetHandleAsInvalid(safeHandle);
+}
+
+extern "C" void System_Runtime_InteropServices_SafeHandle__DangerousAddRef_System_Boolean__(SafeHandle* safeHandle, CLR_BOOL* success)
+{
+	SafeHandle::DangerousAddRef(safeHandle, success);
+}
+
+extern "C" void System_Runtime_InteropServices_SafeHandle__DangerousRelease__(SafeHandle* safeHandle)
+{
+	SafeHandle::DangerousRelease(safeHandle);
+}
+
 #if defined(FEATURE_CRYPTO)
 extern "C" void System_Security_Cryptography_Utils___AcquireCSP_System_Security_Cryptography_CspParameters_System_Security_Cryptography_SafeProvHandle__(Object* param, SafeHandle** hProv)
 {
@@ -0,0 +1,122 @@
+// SharpLang implementation of CoreCLR GCHeap, forwarding to the runtime heap
+#include "common.h"
+#include "../../Heap.h"
+#include "../../Finalizer.h"
+
+// WaitForFullGCApproach/WaitForFullGCComplete results (should match System.GCNotificationStatus)
+enum wait_full_gc_status
+{
+	wait_full_gc_success = 0,
+	wait_full_gc_failed = 1,
+	wait_full_gc_cancelled = 2,
+	wait_full_gc_timeout = 3,
+	wait_full_gc_na = 4
+};
+
+// GC latency modes (should match System.Runtime.GCLatencyMode)
+enum gc_pause_mode
+{
+	pause_batch = 0,
+	pause_interactive = 1,
+	pause_low_latency = 2,
+	pause_sustained_low_latency = 3
+};
+
+class SharpLangGCHeap : public GCHeap
+{
+public:
+	SharpLangGCHeap() : latencyMode(pause_interactive), lohCompactionMode(0) {}
+
+	virtual void SetFinalizationRun(Object* obj)
+	{
+		::SuppressFinalization(obj);
+	}
+
+	virtual HRESULT GarbageCollect(int generation, BOOL low_memory_p, int mode)
+	{
+		// Collections are always blocking
+		::GarbageCollect(generation);
+		return S_OK;
+	}
+
+	virtual int CollectionCount(int generation, int get_bgc_fgc_count)
+	{
+		if (generation < 0 || generation > (int)GetMaxGeneration())
+			return 0;
+
+		return (int)GetCollectionCount(generation);
+	}
+
+	virtual bool RegisterForFinalization(int gen, Object* obj)
+	{
+		::RegisterForFinalization(obj);
+		return true;
+	}
+
+	virtual BOOL IsPromoted(Object* object)
+	{
+		// Only meaningful during a collection, and objects never move
+		return TRUE;
+	}
+
+	virtual unsigned WhichGeneration(Object* object)
+	{
+		return (unsigned)GetGeneration(object);
+	}
+
+	virtual int GetGcLatencyMode()
+	{
+		return latencyMode;
+	}
+
+	virtual int SetGcLatencyMode(int newLatencyMode)
+	{
+		latencyMode = newLatencyMode;
+		return 0;
+	}
+
+	virtual int GetLOHCompactionMode()
+	{
+		return lohCompactionMode;
+	}
+
+	virtual void SetLOHCompactionMode(int newLOHCompactionyMode)
+	{
+		// Heap never compacts, just remember the setting
+		lohCompactionMode = newLOHCompactionyMode;
+	}
+
+	virtual BOOL RegisterForFullGCNotification(DWORD gen2Percentage, DWORD lohPercentage)
+	{
+		return FALSE;
+	}
+
+	virtual BOOL CancelFullGCNotification()
+	{
+		return FALSE;
+	}
+
+	virtual int WaitForFullGCApproach(int millisecondsTimeout)
+	{
+		return wait_full_gc_na;
+	}
+
+	virtual int WaitForFullGCComplete(int millisecondsTimeout)
+	{
+		return wait_full_gc_na;
+	}
+
+	virtual size_t GetTotalBytesInUse()
+	{
+		// Large object space is tracked separately from the small object heap
+		return ::GetTotalBytesInUse() + ::GetLargeObjectBytesInUse();
+	}
+
+private:
+	int latencyMode;
+	int lohCompactionMode;
+};
+
+static SharpLangGCHeap gcHeap;
+
+GPTR_IMPL_INIT(GCHeap, g_pGCHeap, &gcHeap);
@@ -1,5 +1,6 @@
 // SharpLang implementation for various methods required by CoreCLR runtime
 #include "common.h"
+#include "../../Heap.h"
 
 void DoJITFailFast()
 {
@@ -16,11 +17,7 @@ OBJECTREF   AllocatePrimitiveArray(CorElementType type, DWORD length, BOOL bAllo
 	switch (type)
 	{
 	case ELEMENT_TYPE_U1:
-		auto result = (Array<uint8_t>*)malloc(sizeof(Array<uint8_t>));
-		result->eeType = &System_Byte___rtti;
-		result->length = length;
-		result->value = (uint8_t*) malloc(result->eeType->elementSize * length);
-		return result;
+		return AllocateArray(&System_Byte___rtti, length);
 	}
 
 	assert(false);
@@ -28,6 +28,8 @@
     extern type* var
 #define GPTR_IMPL(type, var) \
     type* var
+#define GPTR_IMPL_INIT(type, var, init) \
+    type* var = init
 #define GARY_DECL(type, var, size) \
     extern type var[size]
 #define GVAL_DECL(type, var) \
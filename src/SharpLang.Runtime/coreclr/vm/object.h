@@ -63,7 +63,7 @@ typedef SIZE_T GSCookie;
 
 #include "sstring.h"
 
-#define SetObjectReference(_d,_r,_a)  (*(_d) = _r)
+#define SetObjectReference(_d,_r,_a)  (*(_d) = _r, writeBarrier((void*)(_d)))
 
 class PtrArray;
 class SafeHandle;
@@ -162,7 +162,16 @@ public:
 
 	void AddRef();
 	void Release(bool fDispose = false);
+	void Dispose();
 	void SetHandle(LPVOID handle);
+
+	static void RunReleaseMethod(SafeHandle* psh);
+
+	static void DisposeNative(SafeHandle* refThisUNSAFE);
+	static void Finalize(SafeHandle* refThisUNSAFE);
+	static void SetHandleAsInvalid(SafeHandle* refThisUNSAFE);
+	static void DangerousAddRef(SafeHandle* refThisUNSAFE, CLR_BOOL* pfSuccess);
+	static void DangerousRelease(SafeHandle* refThisUNSAFE);
 };
 
 // SAFEHANDLEREF defined above because CompressedStackObject needs it
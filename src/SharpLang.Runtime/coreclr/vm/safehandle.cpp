@@ -21,21 +21,209 @@
 #include "excep.h"
 #include "frames.h"
 #include "eecontract.h"
+#include "gc.h"
 //#include "mdaassistants.h"
 //#include "typestring.h"
 
-// TODO: Implement this
+// Managed helper calling ReleaseHandle (virtual calls can't be done from here)
+extern "C" CLR_BOOL System_Runtime_InteropServices_SafeHandle__InternalReleaseHandle__(SafeHandle* psh);
+
 void SafeHandle::SetHandle(LPVOID handle)
 {
     m_handle = handle;
 }
 
+void SafeHandle::AddRef()
+{
+    CONTRACTL {
+        THROWS;
+        GC_TRIGGERS;
+        MODE_COOPERATIVE;
+        INSTANCE_CHECK;
+    } CONTRACTL_END;
+
+    // Cannot use "this" after Release, which toggles the GC mode.
+    SAFEHANDLEREF sh(this);
+
+    // To prevent handle recycling security attacks we must enforce the
+    // following invariant: we cannot successfully AddRef a SafeHandle that
+    // has been marked closed (or even disposed).
+    INT32 oldState, newState;
+    do {
+
+        oldState = sh->m_state;
+
+        if (oldState & SH_State_Closed)
+            COMPlusThrow(kObjectDisposedException);
+
+        newState = oldState + SH_RefCountOne;
+
+    } while (InterlockedCompareExchange((LONG*)&sh->m_state, newState, oldState) != oldState);
+}
+
+void SafeHandle::Release(bool fDispose)
+{
+    CONTRACTL {
+        THROWS;
+        GC_TRIGGERS;
+        MODE_COOPERATIVE;
+        INSTANCE_CHECK;
+    } CONTRACTL_END;
+
+    SAFEHANDLEREF sh(this);
+
+    // See AddRef above for the design of the synchronization here. Basically
+    // we will try to decrement the current ref count and, if that would take
+    // us to zero refs, set the closed state on the handle as well.
+    bool fPerformRelease = false;
+
+    INT32 oldState, newState;
+    do {
+
+        oldState = sh->m_state;
+
+        // If this is a Dispose operation we have additional requirements (to
+        // ensure that Dispose happens at most once as the comments in AddRef
+        // detail). We must check that the dispose bit is not set in the old
+        // state and, in the case of successful state update, leave the disposed
+        // bit set. Silently do nothing if Dispose has already been called
+        // (because we advertise that as a semantic of Dispose).
+        if (fDispose && (oldState & SH_State_Disposed))
+            return;
+
+        // We should never see a ref count of zero (that would imply we have
+        // unbalanced AddRef and Releases). (We might see a closed state before
+        // hitting zero though -- that can happen if SetHandleAsInvalid is
+        // used).
+        if ((oldState & SH_State_RefCount) == 0)
+            COMPlusThrow(kObjectDisposedException);
+
+        // If we're proposing a decrement to zero and the handle is not closed
+        // and we own the handle then we need to release the handle upon a
+        // successful state update.
+        fPerformRelease = ((oldState & (SH_State_RefCount | SH_State_Closed)) == SH_RefCountOne) && m_ownsHandle;
+
+        // Attempt the update to the new state, fail and retry if the initial
+        // state has been modified in the meantime. Decrement the ref count by
+        // substracting SH_RefCountOne from the state then OR in the bits for
+        // Dispose (if that's the reason for the Release) and closed (if the
+        // initial ref count was 1).
+        newState = (oldState - SH_RefCountOne) |
+            ((oldState & SH_State_RefCount) == SH_RefCountOne ? SH_State_Closed : 0) |
+            (fDispose ? SH_State_Disposed : 0);
+
+    } while (InterlockedCompareExchange((LONG*)&sh->m_state, newState, oldState) != oldState);
+
+    // If we get here we successfully decremented the ref count. Additonally we
+    // may have decremented it to zero and set the handle state as closed. In
+    // this case (providng we own the handle) we will call the ReleaseHandle
+    // method on the SafeHandle subclass (invalid handles are skipped by the managed helper).
+    if (fPerformRelease)
+        RunReleaseMethod(sh);
+}
+
+void SafeHandle::Dispose()
+{
+    CONTRACTL {
+        THROWS;
+        GC_TRIGGERS;
+        MODE_COOPERATIVE;
+        INSTANCE_CHECK;
+    } CONTRACTL_END;
+
+    // You can't use the "this" pointer after the call to Release because
+    // Release may trigger a GC.
+    SAFEHANDLEREF sh(this);
+
+    sh->Release(true);
+    GCHeap::GetGCHeap()->SetFinalizationRun(sh);
+}
+
+void SafeHandle::RunReleaseMethod(SafeHandle* psh)
+{
+    CONTRACTL {
+        THROWS;
+        GC_TRIGGERS;
+        MODE_COOPERATIVE;
+    } CONTRACTL_END;
+
+    // TODO: Fire SafeHandleCriticalFailure MDA when ReleaseHandle returns false
+    System_Runtime_InteropServices_SafeHandle__InternalReleaseHandle__(psh);
+}
+
+void SafeHandle::DisposeNative(SafeHandle* refThisUNSAFE)
+{
+    FCALL_CONTRACT;
+
+    SAFEHANDLEREF sh(refThisUNSAFE);
+    _ASSERTE(sh != NULL);
+
+    sh->Dispose();
+}
+
+void SafeHandle::Finalize(SafeHandle* refThisUNSAFE)
+{
+    FCALL_CONTRACT;
+
+    SAFEHANDLEREF sh(refThisUNSAFE);
+    _ASSERTE(sh != NULL);
+
+    // Handle could have been partially constructed, in which case it isn't released
+    if (sh->m_fullyInitialized)
+        sh->Dispose();
+}
+
+void SafeHandle::SetHandleAsInvalid(SafeHandle* refThisUNSAFE)
+{
+    FCALL_CONTRACT;
+
+    SAFEHANDLEREF sh(refThisUNSAFE);
+    _ASSERTE(sh != NULL);
+
+    // Attempt to set closed state (low order bit of the m_state field).
+    // Might have to attempt these repeatedly, if the operation suffers
+    // interference from an AddRef or Release.
+    INT32 oldState, newState;
+    do {
+        oldState = sh->m_state;
+        newState = oldState | SH_State_Closed;
+    } while (InterlockedCompareExchange((LONG*)&sh->m_state, newState, oldState) != oldState);
+
+    GCHeap::GetGCHeap()->SetFinalizationRun(sh);
+}
+
+void SafeHandle::DangerousAddRef(SafeHandle* refThisUNSAFE, CLR_BOOL* pfSuccess)
+{
+    FCALL_CONTRACT;
+
+    SAFEHANDLEREF sh(refThisUNSAFE);
+    _ASSERTE(sh != NULL);
+
+    if (pfSuccess == NULL)
+        COMPlusThrow(kNullReferenceException);
+
+    // By the time we're prepared to set *pfSuccess to true, the ref count has been
+    // incremented (AddRef throws if handle is already closed)
+    sh->AddRef();
+    *pfSuccess = true;
+}
+
+void SafeHandle::DangerousRelease(SafeHandle* refThisUNSAFE)
+{
+    FCALL_CONTRACT;
+
+    SAFEHANDLEREF sh(refThisUNSAFE);
+    _ASSERTE(sh != NULL);
+
+    sh->Release(false);
+}
+
 void AcquireSafeHandle(SAFEHANDLEREF* s) 
 {
     WRAPPER_NO_CONTRACT;
     GCX_COOP();
     _ASSERTE(s != NULL && *s != NULL);
-    //(*s)->AddRef(); 
+    (*s)->AddRef(); 
 }
 
 void ReleaseSafeHandle(SAFEHANDLEREF* s) 
@@ -43,5 +231,5 @@ void ReleaseSafeHandle(SAFEHANDLEREF* s)
     WRAPPER_NO_CONTRACT;
     GCX_COOP();
     _ASSERTE(s != NULL && *s != NULL);
-    //(*s)->Release(false); 
+    (*s)->Release(false); 
 }
@@ -159,11 +159,12 @@ namespace System.Runtime.CompilerServices {
                 // length.  Of course, the String reference points to the memory 
                 // after the sync block, so don't count that.  
                 // This property allows C#'s fixed statement to work on Strings.
-                // On 64 bit platforms, this should be 12 (8+4) and on 32 bit 8 (4+4).
+                // SharpLang: header word is stored right after the MethodTable pointer.
+                // On 64 bit platforms, this should be 20 (8+8+4) and on 32 bit 12 (4+4+4).
 #if WIN32
-                return 8;
-#else
                 return 12;
+#else
+                return 20;
 #endif // WIN32
             }
         }
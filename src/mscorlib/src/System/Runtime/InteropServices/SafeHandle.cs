@@ -281,6 +281,16 @@ public abstract class SafeHandle : CriticalFinalizerObject, IDisposable
     [ReliabilityContract(Consistency.WillNotCorruptState, Cer.Success)]
     protected abstract bool ReleaseHandle();
 
+    // Called by the runtime when the last reference is released (it can't do
+    // virtual calls itself). Invalid handles are not released.
+    [ReliabilityContract(Consistency.WillNotCorruptState, Cer.Success)]
+    private bool InternalReleaseHandle()
+    {
+        if (IsInvalid)
+            return true;
+        return ReleaseHandle();
+    }
+
     // Add a reason why this handle should not be relinquished (i.e. have
     // ReleaseHandle called on it). This method has dangerous in the name since
     // it must always be used carefully (e.g. called within a CER) to avoid
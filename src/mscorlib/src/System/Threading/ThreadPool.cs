@@ -616,6 +616,7 @@ namespace System.Threading
             if (loggingEnabled)
                 System.Diagnostics.Tracing.FrameworkEventSource.Log.ThreadPoolEnqueueWorkObject(callback);
             
+#if SHARPLANG_NOTSUPPORTED
             if (null != tl)
             {
                 tl.workStealingQueue.LocalPush(callback);
@@ -637,21 +638,31 @@ namespace System.Threading
             }
 
             EnsureThreadRequested();
+#else
+            // SharpLang: work items are queued in the native work-stealing pool (per-worker deques and global queue),
+            // since queues of ThreadPoolWorkQueueThreadLocals rely on [ThreadStatic]. Native side also wakes a worker if needed.
+            ThreadPool.EnqueueWorkItemNative(callback, forceGlobal);
+#endif
         }
 
         [SecurityCritical]
         internal bool LocalFindAndPop(IThreadPoolWorkItem callback)
         {
+#if SHARPLANG_NOTSUPPORTED
             ThreadPoolWorkQueueThreadLocals tl = ThreadPoolWorkQueueThreadLocals.threadLocals;
             if (null == tl)
                 return false;
 
             return tl.workStealingQueue.LocalFindAndPop(callback);
+#else
+            return ThreadPool.LocalFindAndPopNative(callback);
+#endif
         }
 
         [SecurityCritical]
         public void Dequeue(ThreadPoolWorkQueueThreadLocals tl, out IThreadPoolWorkItem callback, out bool missedSteal)
         {
+#if SHARPLANG_NOTSUPPORTED
             callback = null;
             missedSteal = false;
             WorkStealingQueue wsq = tl.workStealingQueue;
@@ -701,6 +712,11 @@ namespace System.Threading
                     c--;
                 }
             }
+#else
+            // SharpLang: native side retries lost steals itself
+            callback = ThreadPool.DequeueWorkItemNative();
+            missedSteal = false;
+#endif
         }
 
         [SecurityCritical]
@@ -1769,6 +1785,19 @@ namespace System.Threading
         [MethodImplAttribute(MethodImplOptions.InternalCall)]
         unsafe private static extern bool PostQueuedCompletionStatus(NativeOverlapped* overlapped);
 
+        // SharpLang: work-stealing queues are implemented natively
+        [System.Security.SecurityCritical]
+        [MethodImplAttribute(MethodImplOptions.InternalCall)]
+        internal static extern void EnqueueWorkItemNative(IThreadPoolWorkItem workItem, bool forceGlobal);
+
+        [System.Security.SecurityCritical]
+        [MethodImplAttribute(MethodImplOptions.InternalCall)]
+        internal static extern IThreadPoolWorkItem DequeueWorkItemNative();
+
+        [System.Security.SecurityCritical]
+        [MethodImplAttribute(MethodImplOptions.InternalCall)]
+        internal static extern bool LocalFindAndPopNative(IThreadPoolWorkItem workItem);
+
         [System.Security.SecurityCritical]  // auto-generated_required
         [CLSCompliant(false)]
         unsafe public static bool UnsafeQueueNativeOverlapped(NativeOverlapped* overlapped)